@@ -2,17 +2,45 @@
 #include "my_application.h"
 
 // std
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 
-int main()
+// A decimal number from minimum to maximum, std::stoul alone would take "-1", "12abc" or "0"
+static uint32_t parseCount(const std::string& option, const std::string& text, uint32_t minimum = 1, uint32_t maximum = UINT32_MAX)
 {
-    MyApplication app{};
+    bool bDigits = !text.empty() && text.size() <= 10 && text.find_first_not_of("0123456789") == std::string::npos;
+    unsigned long long value = bDigits ? std::stoull(text) : 0;
+    if (!bDigits || value < minimum || value > maximum)
+    {
+        throw std::runtime_error(option + " needs a count from " + std::to_string(minimum) + " to " + std::to_string(maximum) + ", got '" + text + "'!");
+    }
+    return static_cast<uint32_t>(value);
+}
 
+// Usage: app [--headless <frames>] [--recording-threads <count>]
+int main(int argc, char* argv[])
+{
     try 
     {
+        uint32_t headlessFrames = 0;
+        uint32_t recordingThreads = MyApplication::DEFAULT_RECORDING_THREADS;
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::string(argv[i]) == "--headless")
+            {
+                headlessFrames = (i + 1 < argc) ? parseCount("--headless", argv[++i]) : 1000;
+            }
+            else if (std::string(argv[i]) == "--recording-threads" && i + 1 < argc)
+            {
+                recordingThreads = parseCount("--recording-threads", argv[++i], 0, MyApplication::MAX_RECORDING_THREADS);
+            }
+        }
+
+        MyApplication app{ headlessFrames, recordingThreads };
         app.run();
     }
     catch (const std::exception& e) 
@@ -23,4 +51,3 @@ int main()
 
     return EXIT_SUCCESS;
 }
-
@@ -0,0 +1,64 @@
+#include "my_allocation_counter.h"
+
+// std
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Constant initialized, so it is ready before any allocation of a static constructor
+static std::atomic<uint64_t> s_iAllocationCount{ 0 };
+
+uint64_t MyAllocationCounter::count()
+{
+	return s_iAllocationCount.load(std::memory_order_relaxed);
+}
+
+static void* countedAllocate(std::size_t size)
+{
+	s_iAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	// Same contract as the default operator new
+	if (size == 0)
+	{
+		size = 1;
+	}
+
+	while (true)
+	{
+		if (void* p = std::malloc(size))
+		{
+			return p;
+		}
+
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+}
+
+static void* countedAllocateNoThrow(std::size_t size) noexcept
+{
+	try
+	{
+		return countedAllocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocateNoThrow(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocateNoThrow(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
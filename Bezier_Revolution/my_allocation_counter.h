@@ -0,0 +1,20 @@
+#ifndef __MY_ALLOCATION_COUNTER_H__
+#define __MY_ALLOCATION_COUNTER_H__
+
+// std
+#include <cstdint>
+
+//
+// Counts the heap allocations of the whole process. The global operator new is replaced
+// and counts with one relaxed atomic increment, so it is cheap enough to stay on in every
+// build. Read the count around a frame to see whether a steady state frame allocates.
+// The over-aligned operator new of C++17 is not replaced and not counted
+//
+class MyAllocationCounter
+{
+public:
+	// Allocations since the start of the program, on every thread
+	static uint64_t count();
+};
+
+#endif
@@ -4,6 +4,9 @@
 #include "my_simple_render_system.h"
 #include "my_point_line_render_system.h"
 #include "my_keyboard_controller.h"
+#include "my_allocation_counter.h"
+#include "my_cpu_profiler.h"
+#include "my_tracer.h"
 
 // use radian rather degree for angle
 #define GLM_FORCE_RADIANS
@@ -12,14 +15,17 @@
 #include <glm/gtc/constants.hpp>
 
 // Std
+#include <algorithm>
 #include <stdexcept>
 #include <array>
 #include <chrono>
 #include <iostream>
-#include <limits>
 #include <math.h>
 
-MyApplication::MyApplication() :
+MyApplication::MyApplication(uint32_t headlessFrames, uint32_t recordingThreads) :
+    m_iHeadlessFrames(headlessFrames),
+    m_iRecordingThreads(recordingThreads),
+    m_myWindow{ WIDTH, HEIGHT, "Bezier Revolution", headlessFrames > 0 },
     m_bPerspectiveProjection(true)
 {
     _loadGameObjects();
@@ -32,11 +38,17 @@ MyApplication::~MyApplication()
 
 void MyApplication::run() 
 {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool bFirstFrame = true;
+    uint32_t frameCount = 0;
+
     // Declare the render systems
-    MySimpleRenderSystem    simpleRenderSystem{ m_myDevice, m_myRenderer.swapChainRenderPass() };                                  // Draw indexed triangles
-    MyPointLineRenderSystem pointRenderSystem{ m_myDevice, m_myRenderer.swapChainRenderPass(), VK_PRIMITIVE_TOPOLOGY_POINT_LIST }; // Draw points
-    MyPointLineRenderSystem lineRenderSystem{ m_myDevice, m_myRenderer.swapChainRenderPass(), VK_PRIMITIVE_TOPOLOGY_LINE_STRIP };  // Draw line strip
-    MyPointLineRenderSystem normalRenderSystem{ m_myDevice, m_myRenderer.swapChainRenderPass(), VK_PRIMITIVE_TOPOLOGY_LINE_LIST }; // Draw lines
+    MySimpleRenderSystem    simpleRenderSystem{ m_myDevice, m_myPipelineLibrary, m_myRenderer.swapChainRenderPass() };                                  // Draw indexed triangles
+    MyPointLineRenderSystem pointRenderSystem{ m_myDevice, m_myPipelineLibrary, m_myRenderer.swapChainRenderPass(), VK_PRIMITIVE_TOPOLOGY_POINT_LIST }; // Draw points
+    MyPointLineRenderSystem lineRenderSystem{ m_myDevice, m_myPipelineLibrary, m_myRenderer.swapChainRenderPass(), VK_PRIMITIVE_TOPOLOGY_LINE_STRIP };  // Draw line strip
+    MyPointLineRenderSystem normalRenderSystem{ m_myDevice, m_myPipelineLibrary, m_myRenderer.swapChainRenderPass(), VK_PRIMITIVE_TOPOLOGY_LINE_LIST }; // Draw lines
+
+    MY_TRACE_THREAD_NAME("main");
 
     m_myWindow.bindMyApplication(this);
 
@@ -47,15 +59,55 @@ void MyApplication::run()
     auto viewerObject = MyGameObject::createGameObject("camera");
     MyKeyboardController cameraController{};
 
+    // Draw packets of the render systems are sorted and recorded in one go
+    MyRenderQueue renderQueue{};
+    renderQueue.setPassName(0, "control points");
+    renderQueue.setPassName(1, "control polygon");
+    renderQueue.setPassName(2, "center line");
+    renderQueue.setPassName(3, "bezier curve");
+    renderQueue.setPassName(4, "normals");
+    renderQueue.setPassName(5, "surface");
+
+    MyNameID renderPassName = MyNameTable::instance().intern("render pass");
+
     auto currentTime = std::chrono::high_resolution_clock::now();
 
+    // Phases of the frame, reported every MyCpuProfiler::DEFAULT_REPORT_INTERVAL frames
+    MyCpuProfiler& cpuProfiler = MyCpuProfiler::instance();
+
     while (!m_myWindow.shouldClose()) 
     {
+        uint64_t frameStart = cpuProfiler.now();
+        uint64_t frameAllocations = MyAllocationCounter::count();
+
         // Note: depending on the platforms (PC, Linux or Mac), this function
         // will cause the event proecssing to block during a Window move, resize or
         // menu operation. Users can use the "window refresh callback" to redraw the
         // contents of the window when necessary during such operation.
-        m_myWindow.pollEvents();
+        // Headless runs draw every frame, and so does the application until the pipelines
+        // compiling in the background are ready because each of them adds to the picture
+        bool bContinuous = m_myWindow.isHeadless() || !m_myPipelineLibrary.isIdle();
+        if (bContinuous || m_myWindow.isDirty())
+        {
+            MyCpuScope scope{ "pollEvents" };
+            m_myWindow.pollEvents();
+        }
+        else
+        {
+            // Nothing changed since the last frame, sleep until an event arrives
+            m_myWindow.waitEventsTimeout(IDLE_TIMEOUT);
+            if (!m_myWindow.isDirty())
+            {
+                continue;
+            }
+
+            // The time spent waiting is not part of the frame
+            frameStart = cpuProfiler.now();
+            frameAllocations = MyAllocationCounter::count();
+            currentTime = std::chrono::high_resolution_clock::now();
+        }
+
+        uint64_t updateStart = cpuProfiler.now();
 
         // Need to get the call after glfwPollEvants because the call above may take time
         auto newTime = std::chrono::high_resolution_clock::now();
@@ -79,53 +131,153 @@ void MyApplication::run()
             // such that Y is up. Because we move the part 2.5 units, the near and far value needs to cover the model
             // Also, near and far will automatically apply negative values
             m_myCamera.setOrthographicProjection(-apsectRatio, apsectRatio, -1.0f, 1.0f, -100.0f, 100.0f);
+
+        cpuProfiler.record("update", updateStart, cpuProfiler.now());
  
         // Please note that commandBuffer could be null pointer
-        // if the swapChain needs to be recreated
-        if (auto commandBuffer = m_myRenderer.beginFrame())
+        // if the swapChain needs to be recreated.
+        // Includes the wait for the frame that last used this frame index
+        VkCommandBuffer commandBuffer;
+        {
+            MyCpuScope scope{ "beginFrame" };
+            commandBuffer = m_myRenderer.beginFrame();
+        }
+
+        if (commandBuffer)
 		{
+            uint64_t recordStart = cpuProfiler.now();
+
+            // Everything that changed so far is in this frame
+            m_myWindow.clearDirty();
+
             // In case we have multiple render passes for the current frame
             // begin offsreen shadow pass
             // render shadow casting objects
             // end offscreen shadow pass
 
             int frameIndex = m_myRenderer.frameIndex();
-            MyFrameInfo frameInfo{ frameIndex, frameTime, commandBuffer, m_myCamera, glm::vec3(1.0f, 1.0f, 1.0f) };
+            MyFrameInfo frameInfo{ frameIndex, frameTime, commandBuffer, m_myCamera, glm::vec3(1.0f, 1.0f, 1.0f), renderQueue, 0 };
+
+            // Read the GPU timings of this frame index's previous use and start over
+            m_myGpuProfiler.beginFrame(commandBuffer, frameIndex);
+            uint32_t renderPassScope = m_myGpuProfiler.beginScope(commandBuffer, renderPassName);
+
             m_myRenderer.beginSwapChainRenderPass(commandBuffer);
             
-            // The order the render systems determines which one is rendered on top
+            // The pass of the render systems determines which one is rendered on top
+            frameInfo.pass = 0;
             frameInfo.color = glm::vec3(1.0f, 0.0f, 0.0f);
-            pointRenderSystem.renderControlPoints(frameInfo, m_vMyGameObjects);
+            pointRenderSystem.renderControlPoints(frameInfo, m_myWorld);
 
+            frameInfo.pass = 1;
             frameInfo.color = glm::vec3(1.0f, 1.0f, 0.0f);
-            lineRenderSystem.renderControlPoints(frameInfo, m_vMyGameObjects);
+            lineRenderSystem.renderControlPoints(frameInfo, m_myWorld);
 
+            frameInfo.pass = 2;
             frameInfo.color = glm::vec3(0.0f, 0.0f, 1.0f);
-            lineRenderSystem.renderCenerLine(frameInfo, m_vMyGameObjects);
+            lineRenderSystem.renderCenerLine(frameInfo, m_myWorld);
 
+            frameInfo.pass = 3;
             frameInfo.color = glm::vec3(1.0f, 1.0f, 1.0f);
-            lineRenderSystem.renderBezierCurve(frameInfo, m_vMyGameObjects);
+            lineRenderSystem.renderBezierCurve(frameInfo, m_myWorld);
 
             if (m_bShowNormals) // render normal vectors only if users decided to show the normals
 			{
+                frameInfo.pass = 4;
                 frameInfo.color = glm::vec3(0.0f, 1.0f, 0.0f);
-                normalRenderSystem.renderNormals(frameInfo, m_vMyGameObjects);
+                normalRenderSystem.renderNormals(frameInfo, m_myWorld);
             }
 
             if (m_bShowSurface) // render surface only if users decided to show the surface
             {
+                frameInfo.pass = 5;
                 frameInfo.color = glm::vec3(1.0f, 1.0f, 1.0f); // Not use
-                simpleRenderSystem.renderGameObjects(frameInfo, m_vMyGameObjects);
+                simpleRenderSystem.renderGameObjects(frameInfo, m_myWorld);
             }
 
+            // Sort the submitted packets and record them with redundant binds removed.
+            // The passes are only timed one by one when recorded into the primary command buffer
+            if (m_myRenderer.isParallelRecording())
+                renderQueue.flush(commandBuffer, m_myRenderer, m_myThreadPool);
+            else
+                renderQueue.flush(commandBuffer, &m_myGpuProfiler);
+
             m_myRenderer.endSwapChainRenderPass(commandBuffer);
+            m_myGpuProfiler.endScope(commandBuffer, renderPassScope);
+
+            cpuProfiler.record("record", recordStart, cpuProfiler.now());
+
+            {
+                MyCpuScope scope{ "endFrame" };
+                m_myRenderer.endFrame();
+            }
 
-            m_myRenderer.endFrame();
+            // The pipelines are still compiling in the background at this point
+            if (bFirstFrame)
+            {
+                bFirstFrame = false;
+                float firstFrameTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                    std::chrono::high_resolution_clock::now() - startTime).count();
+                std::cout << "Time to first frame: " << firstFrameTime << " ms" << std::endl;
+            }
+
+            if (m_myWindow.isHeadless() && ++frameCount >= m_iHeadlessFrames)
+            {
+                m_myWindow.requestClose();
+            }
         }
+
+        cpuProfiler.record("frame", frameStart, cpuProfiler.now());
+        cpuProfiler.recordFrameAllocations(MyAllocationCounter::count() - frameAllocations);
+        cpuProfiler.endFrame();
+    }
+
+    if (m_myWindow.isHeadless())
+    {
+        float totalTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+        std::cout << "Headless: " << frameCount << " frames in " << totalTime << " ms ("
+                  << totalTime / std::max(frameCount, 1u) << " ms per frame, "
+                  << m_myRenderer.recordingSlots() << " recording threads)" << std::endl;
+        m_myGpuProfiler.printStats(std::cout);
+        cpuProfiler.printReport(std::cout);
+        cpuProfiler.writeChromeTrace("cpu_trace.json");
+        m_myDevice.printMemoryReport(std::cout);
     }
 
     // GPU will block until all CPU is complete
     vkDeviceWaitIdle(m_myDevice.device());
+
+    MY_TRACE_WRITE("trace.json");
+}
+
+void MyApplication::printGpuProfile()
+{
+    m_myGpuProfiler.printStats(std::cout);
+}
+
+void MyApplication::writeGpuProfileCsv()
+{
+    m_myGpuProfiler.writeCsv("gpu_profile.csv");
+}
+
+void MyApplication::writeCpuTrace()
+{
+    MyCpuProfiler::instance().writeChromeTrace("cpu_trace.json");
+}
+
+void MyApplication::printMemoryReport()
+{
+    m_myDevice.printMemoryReport(std::cout);
+}
+
+void MyApplication::writeTrace()
+{
+#ifdef MY_ENABLE_TRACING
+    MY_TRACE_WRITE("trace.json");
+#else
+    std::cout << "Tracing is disabled, build with MY_ENABLE_TRACING defined" << std::endl;
+#endif
 }
 
 void MyApplication::switchProjectionMatrix()
@@ -139,16 +291,15 @@ void MyApplication::_loadGameObjects()
     // Initialize the memory of Game Objects
     m_pMyBezier = std::make_shared<MyBezier>();
 
-    // Add dynamic control points (no more than 100 points)
-    std::shared_ptr<MyModel> mypontLine = std::make_shared<MyModel>(m_myDevice, 100);
-    auto mygameobj1 = MyGameObject::createGameObject("control_points");
-    mygameobj1.model = mypontLine;
-    m_vMyGameObjects.push_back(std::move(mygameobj1));
+    // Add dynamic control points, room for 100 points before the buffer grows
+    std::shared_ptr<MyModel> mypontLine = std::make_shared<MyModel>(m_myDevice, m_myRenderer, 100);
+    m_myControlPointsEntity = m_myWorld.create(
+        PointLineComponent{ PointLineComponent::CONTROL_POINTS }, 
+        ModelComponent{ mypontLine }, 
+        TransformComponent{});
 
     // Add center line (2 points)
-    std::shared_ptr<MyModel> mycenterLine = std::make_shared<MyModel>(m_myDevice, 2);
-    auto mygameobj2 = MyGameObject::createGameObject("centerLine");
-    mygameobj2.model = mycenterLine;
+    std::shared_ptr<MyModel> mycenterLine = std::make_shared<MyModel>(m_myDevice, m_myRenderer, 2);
 
     MyModel::PointLine vertex1, vertex2;
     vertex1.position.x = -1.0f;
@@ -171,21 +322,38 @@ void MyApplication::_loadGameObjects()
 
     mycenterLine->updatePointLines(centerLine);
 
-    m_vMyGameObjects.push_back(std::move(mygameobj2));
-
-	// Note: if you increase the resolutions of the curve, you need to increase the value 1000 here
-    std::shared_ptr<MyModel> mybezierCurve = std::make_shared<MyModel>(m_myDevice, 1000);
-    auto mygameobj3 = MyGameObject::createGameObject("bezier_curve");
-    mygameobj3.model = mybezierCurve;
-    m_vMyGameObjects.push_back(std::move(mygameobj3));
-
-    // Add revolution surface game object, but no model yet
-    auto mygameobj4 = MyGameObject::createGameObject("bezier_surface"); // it will crash if don't check nullptr on model in the render system
-    m_vMyGameObjects.push_back(std::move(mygameobj4));
-
-    // Add normal vectors game object, but no model yet
-    auto mygameobj5 = MyGameObject::createGameObject("surface_normals");
-    m_vMyGameObjects.push_back(std::move(mygameobj5));
+    m_myCenterLineEntity = m_myWorld.create(
+        PointLineComponent{ PointLineComponent::CENTER_LINE }, 
+        ModelComponent{ mycenterLine }, 
+        TransformComponent{});
+    m_mySceneBounds.setPoints(m_myCenterLineEntity, centerLine);
+
+    // The curve buffer grows with the resolution of the curve
+    std::shared_ptr<MyModel> mybezierCurve = std::make_shared<MyModel>(m_myDevice, m_myRenderer, 1000);
+    m_myBezierCurveEntity = m_myWorld.create(
+        PointLineComponent{ PointLineComponent::BEZIER_CURVE }, 
+        ModelComponent{ mybezierCurve }, 
+        TransformComponent{});
+
+    // Add revolution surface entity, but no model yet
+    m_mySurfaceEntity = m_myWorld.create(
+        SurfaceComponent{}, 
+        ModelComponent{}, // it will crash if don't check nullptr on model in the render system
+        TransformComponent{});
+
+    // Add normal vectors entity, but no model yet
+    m_myNormalsEntity = m_myWorld.create(
+        PointLineComponent{ PointLineComponent::SURFACE_NORMALS }, 
+        ModelComponent{}, 
+        TransformComponent{});
+
+    // The names are interned once here, nothing per frame looks anything up by its string
+    MyNameTable& nameTable = MyNameTable::instance();
+    m_myWorld.setName(m_myControlPointsEntity, nameTable.intern("control_points"));
+    m_myWorld.setName(m_myCenterLineEntity, nameTable.intern("centerLine"));
+    m_myWorld.setName(m_myBezierCurveEntity, nameTable.intern("bezier_curve"));
+    m_myWorld.setName(m_mySurfaceEntity, nameTable.intern("bezier_surface"));
+    m_myWorld.setName(m_myNormalsEntity, nameTable.intern("surface_normals"));
 }
 
 // Function used to check whether the given coordinate overlaps with an existing control point, if yes return its index in m_vControlPointVertices
@@ -261,12 +429,6 @@ void MyApplication::mouseButtonEvent(bool bMouseDown, float posx, float posy)
             m_vControlPointVertices.push_back(controlPoint);
         }
 
-        // No more than 100 points
-        if (m_vControlPointVertices.size() >= 100)
-        {
-            return;
-        }
-
         // Step2: Create Bezier curve 
         if (m_vControlPointVertices.size() > 2)  // only create the curve if there is at least 3 points (2 points is just a line and 1 point is just a point)
         {
@@ -274,18 +436,10 @@ void MyApplication::mouseButtonEvent(bool bMouseDown, float posx, float posy)
         }
 
         // Step 3
-        // Update the game objects for rendering
-        for (auto& obj : m_vMyGameObjects)
-        {
-            if (obj.name() == std::string("control_points"))
-            {
-                obj.model->updatePointLines(m_vControlPointVertices);
-            }
-            else if (obj.name() == std::string("bezier_curve"))
-            {
-                obj.model->updatePointLines(m_pMyBezier->m_vCurve);
-            }
-        }
+        // Update the entities for rendering
+        m_myWorld.get<ModelComponent>(m_myControlPointsEntity).model->updatePointLines(m_vControlPointVertices);
+        m_myWorld.get<ModelComponent>(m_myBezierCurveEntity).model->updatePointLines(m_pMyBezier->m_vCurve);
+        _updateCurveBounds();
     }
 
     // If in edit mode and mouse button released -> end movement of selected control point if applicable
@@ -310,6 +464,12 @@ void MyApplication::mouseMotionEvent(float posx, float posy)
     if (!m_bCreateModel)
 	{
         m_myCamera.setMotion(m_bMouseButtonPress, posx, posy);
+
+        // The camera only moves while the mouse is dragged
+        if (m_bMouseButtonPress)
+        {
+            m_myWindow.invalidate();
+        }
 	}
 
     // Otherwise, in editting mode, mouse movements can be used to edit control point position
@@ -330,28 +490,39 @@ void MyApplication::mouseMotionEvent(float posx, float posy)
             m_pMyBezier->modifyControlPoint(index_of_selected_point, x, y); 
 
             m_pMyBezier->createBezierCurve(20); // recreate bezier curve based on modified control point
+            m_myWindow.invalidate();
 
-            // Update the corresponding models for rendering
-            for (auto& obj : m_vMyGameObjects)
-            {
-                if (obj.name() == std::string("control_points"))
-                {
-                    obj.model->updatePointLines(m_vControlPointVertices);
-                }
-                else if (obj.name() == std::string("bezier_curve"))
-                {
-                    obj.model->updatePointLines(m_pMyBezier->m_vCurve);
-                }
-            }
+            // Update the corresponding models for rendering, only the dragged point changed
+            m_myWorld.get<ModelComponent>(m_myControlPointsEntity).model->updateRange(m_vControlPointVertices, index_of_selected_point, 1);
+            m_myWorld.get<ModelComponent>(m_myBezierCurveEntity).model->updatePointLines(m_pMyBezier->m_vCurve);
+            _updateCurveBounds();
         }
     }
 }
 
 void MyApplication::setCameraNavigationMode(MyCamera::MyCameraMode mode)
 {
+    // Frame what is drawn, the surface and the normals can be hidden
+    m_mySceneBounds.setVisible(m_mySurfaceEntity, m_bShowSurface);
+    m_mySceneBounds.setVisible(m_myNormalsEntity, m_bShowNormals);
+
+    // Every navigation starts here, the sphere is only recomputed if something changed since the last one
+    const MySphere& sceneSphere = m_mySceneBounds.sceneSphere();
+    if (!sceneSphere.isEmpty())
+    {
+        m_myCamera.setSceneSphere(sceneSphere.center, sceneSphere.radius);
+    }
+
     m_myCamera.setMode(mode);   
 }
 
+void MyApplication::_updateCurveBounds()
+{
+    // The arrays of the bounds keep their capacity, dragging a point does not allocate
+    m_mySceneBounds.setPoints(m_myControlPointsEntity, m_vControlPointVertices);
+    m_mySceneBounds.setPoints(m_myBezierCurveEntity, m_pMyBezier->m_vCurve);
+}
+
 void MyApplication::switchEditMode()
 {
     // Switch between edit mode and camera mode
@@ -375,33 +546,31 @@ void MyApplication::switchEditMode()
 // Clear everything (control points, bezier curves, surfaces, normal vectors) 
 void MyApplication::resetSurface()
 {
-    for (auto& obj : m_vMyGameObjects)
+    m_vControlPointVertices.clear();
+    m_pMyBezier->clearControlPoints(); 
+    m_myWorld.get<ModelComponent>(m_myControlPointsEntity).model->updatePointLines(m_vControlPointVertices);
+
+    // The normals have no model until the first surface was created
+    m_vNormalVectors.clear();
+    ModelComponent& normals = m_myWorld.get<ModelComponent>(m_myNormalsEntity);
+    if (normals.model != nullptr)
     {
-        if (obj.name() == std::string("control_points"))
-        {
-            m_vControlPointVertices.clear();
-            m_pMyBezier->clearControlPoints(); 
-            obj.model->updatePointLines(m_vControlPointVertices);
-        }
-        else if (obj.name() == std::string("surface_normals"))
-        {
-            m_vNormalVectors.clear();
-            obj.model->updatePointLines(m_vNormalVectors);
-            m_bShowNormals = false; 
-        }
-        else if (obj.name() == std::string("bezier_curve"))
-        {
-            m_pMyBezier->m_vCurve.clear(); 
-            obj.model->updatePointLines(m_pMyBezier->m_vCurve);
-        }
-        else if (obj.name() == std::string("bezier_surface"))
-        {
-            m_pMyBezier->m_vSurface.clear(); 
-            m_pMyBezier->m_vIndices.clear(); 
-            obj.model = nullptr; 
-            m_bShowSurface = false; 
-        }
+        normals.model->updatePointLines(m_vNormalVectors);
     }
+    m_bShowNormals = false; 
+
+    m_pMyBezier->m_vCurve.clear(); 
+    m_myWorld.get<ModelComponent>(m_myBezierCurveEntity).model->updatePointLines(m_pMyBezier->m_vCurve);
+    _updateCurveBounds();
+    m_mySceneBounds.remove(m_mySurfaceEntity);
+    m_mySceneBounds.remove(m_myNormalsEntity);
+
+    m_pMyBezier->m_vSurface.clear(); 
+    m_pMyBezier->m_vIndices.clear(); 
+    ModelComponent& surface = m_myWorld.get<ModelComponent>(m_mySurfaceEntity);
+    m_myRenderer.releaseAfterFrames(surface.model);  // may still be drawn by a frame in flight
+    surface.model = nullptr; 
+    m_bShowSurface = false; 
 	std::cout << "Reset" << std::endl;
 }
 
@@ -441,6 +610,8 @@ void MyApplication::showHideSurface()
 void MyApplication::createBezierRevolutionSurface()
 {
     std::cout << "Create Bezier Surface" << std::endl;
+
+    MY_TRACE_SCOPE("surface", "createBezierRevolutionSurface");
 	
     m_vNormalVectors.clear();
     
@@ -472,52 +643,21 @@ void MyApplication::createBezierRevolutionSurface()
         m_vNormalVectors[index++].position = m_pMyBezier->m_vSurface[ii].position + m_pMyBezier->m_vSurface[ii].normal * 0.1f;
     }
 
-    std::shared_ptr<MyModel> mynormals = std::make_shared<MyModel>(m_myDevice, nvertices * 2);
+    std::shared_ptr<MyModel> mynormals = std::make_shared<MyModel>(m_myDevice, m_myRenderer, nvertices * 2);
     mynormals->updatePointLines(m_vNormalVectors);
 
-    for (auto& obj : m_vMyGameObjects)
-    {
-        if (obj.name() == std::string("bezier_surface"))
-        {
-            obj.model = mysurface;
-        }
-        else if (obj.name() == std::string("surface_normals"))
-        {
-            obj.model = mynormals;
-        }
-    }
-
-	// Step 3: Update min and max for MyCamera from the surface and the normals
-    float min_x, min_y, min_z;
-    min_x = min_y = min_z = std::numeric_limits<float>::max();
-
-    float max_x, max_y, max_z;
-    max_x = max_y = max_z = std::numeric_limits<float>::min();
+    // The replaced models may still be drawn by a frame in flight
+    ModelComponent& surface = m_myWorld.get<ModelComponent>(m_mySurfaceEntity);
+    m_myRenderer.releaseAfterFrames(surface.model);
+    surface.model = mysurface;
 
-    for (auto & vertex : m_pMyBezier->m_vSurface)
-    {
-        min_x = std::min(vertex.position.x, min_x);
-        min_y = std::min(vertex.position.y, min_y);
-        min_z = std::min(vertex.position.z, min_z);
-
-        max_x = std::max(vertex.position.x, max_x);
-        max_y = std::max(vertex.position.y, max_y);
-        max_z = std::max(vertex.position.z, max_z);
-
-        if (m_bShowNormals) // Only consider normals if normals are currently being shown
-        {
-            min_x = std::min(vertex.normal.x, min_x);
-            min_y = std::min(vertex.normal.y, min_y);
-            min_z = std::min(vertex.normal.z, min_z);
-
-            max_x = std::max(vertex.normal.x, max_x);
-            max_y = std::max(vertex.normal.y, max_y);
-            max_z = std::max(vertex.normal.z, max_z);
-        }
-    }
-    glm::vec3 min(min_x, min_y, min_z); 
-    glm::vec3 max(max_x, max_y, max_z); 
+    ModelComponent& normals = m_myWorld.get<ModelComponent>(m_myNormalsEntity);
+    m_myRenderer.releaseAfterFrames(normals.model);
+    normals.model = mynormals;
 
-    m_myCamera.setSceneMinMax(min, max); 
+	// Step 3: Update the bounds of the surface and the normals, the normals are lines from
+    // the surface to 0.1 along the normal. MyCamera gets them with the next navigation mode
+    m_mySceneBounds.setPoints(m_mySurfaceEntity, m_pMyBezier->m_vSurface);
+    m_mySceneBounds.setPoints(m_myNormalsEntity, m_vNormalVectors);
 }
 
@@ -4,9 +4,14 @@
 #include "my_window.h"
 #include "my_device.h"
 #include "my_renderer.h"
+#include "my_gpu_profiler.h"
+#include "my_pipeline_library.h"
+#include "my_ecs.h"
+#include "my_bounds.h"
 #include "my_game_object.h"
 #include "my_camera.h"
 #include "my_bezier_curve_surface.h"
+#include "my_thread_pool.h"
 
 #include <memory>
 #include <vector>
@@ -17,7 +22,24 @@ public:
 	static constexpr int WIDTH = 1000;
 	static constexpr int HEIGHT = 1000;
 
-	MyApplication();
+	// Frames are only drawn when something changed. Without events the loop
+	// still wakes up after this many seconds
+	static constexpr double IDLE_TIMEOUT = 0.5;
+
+	// Default number of threads recording the draw packets into secondary command buffers,
+	// main.cpp takes another one from --recording-threads. 0 records everything on the main
+	// thread into the primary command buffer. The recording uses the same thread pool the
+	// pipelines are compiled on
+	static constexpr uint32_t DEFAULT_RECORDING_THREADS = 0;
+	static constexpr uint32_t MAX_RECORDING_THREADS = 64;
+
+	// Frames the CPU can record ahead of the GPU, between 2 and MySwapChain::MAX_FRAMES_IN_FLIGHT.
+	// More hides GPU stalls at the cost of input latency
+	static constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+
+	// With headlessFrames > 0 nothing is shown, the given number of frames
+	// are rendered offscreen and run() returns
+	MyApplication(uint32_t headlessFrames = 0, uint32_t recordingThreads = DEFAULT_RECORDING_THREADS);
 	~MyApplication();
 
 	MyApplication(const MyApplication&) = delete;
@@ -37,15 +59,38 @@ public:
 	void showHideSurface();
 	void createBezierRevolutionSurface();
 
+	// Profiling
+	void printGpuProfile();
+	void writeGpuProfileCsv();
+	void writeCpuTrace();
+	void writeTrace();
+	void printMemoryReport();
+
 private:
 	void _loadGameObjects();
 	int  _queryControlPoints(float posx, float posy); 
 
+	// The control points and the curve changed, so did their bounds
+	void _updateCurveBounds();
+
+	uint32_t                        m_iHeadlessFrames;
+	uint32_t                        m_iRecordingThreads;
 	MyWindow                        m_myWindow{ WIDTH, HEIGHT, "Bezier Revolution" };
 	MyDevice                        m_myDevice{ m_myWindow };
-	MyRenderer                      m_myRenderer{ m_myWindow, m_myDevice };
+	MyRenderer                      m_myRenderer{ m_myWindow, m_myDevice, m_iRecordingThreads, FRAMES_IN_FLIGHT };
+	MyGpuProfiler                   m_myGpuProfiler{ m_myDevice };
+	MyThreadPool                    m_myThreadPool{ MyThreadPool::defaultThreadCount() };
+	MyPipelineLibrary               m_myPipelineLibrary{ m_myDevice, m_myThreadPool };
+
+	// The entities of the scene, the handles below are kept instead of looking them up by name
+	MyWorld                         m_myWorld;
+	MyEntity                        m_myControlPointsEntity;
+	MyEntity                        m_myCenterLineEntity;
+	MyEntity                        m_myBezierCurveEntity;
+	MyEntity                        m_mySurfaceEntity;
+	MyEntity                        m_myNormalsEntity;
+	MySceneBounds                   m_mySceneBounds;
 
-	std::vector<MyGameObject>       m_vMyGameObjects;
 	MyCamera                        m_myCamera{};
 	bool                            m_bPerspectiveProjection;
 	bool                            m_bMouseButtonPress = false;
@@ -1,5 +1,9 @@
 #include "my_bezier_curve_surface.h"
+#include "my_tracer.h"
+
+#ifndef M_PI
 #define M_PI        3.14159265358979323846264338327950288   /* pi */
+#endif
 
 void MyBezier::addControlPoint(float x, float y)
 {
@@ -63,6 +67,9 @@ void MyBezier::modifyControlPoint(int index, float x, float y)
 
 void MyBezier::createRevolutionSurface(int xResolution, int rResolution)
 {
+    MY_TRACE_SCOPE_ARGS("surface", "createRevolutionSurface", "control points=%d resolution=%dx%d",
+        numberOfControlPoints(), xResolution, rResolution);
+
     m_vSurface.clear();
     m_vIndices.clear();
 
@@ -167,25 +174,26 @@ void MyBezier::_pointOnBezierCurve(int degree, float u, glm::vec2 &point)
     /* Compute point on Bezier curve */
     /* Input: P (control point) n, u */
     /* Output: C (a point) */
-    std::vector<float> vfB(degree + 1, 0.0f);
+    // Reused, dragging a control point rebuilds the curve on every mouse move
+    m_vBernstein.assign(degree + 1, 0.0f);
 
-    _allBernstein(degree, u, vfB.data()); /* B is a local array */
+    _allBernstein(degree, u, m_vBernstein.data());
     point = glm::vec3{ 0.0f };
     for (int k = 0; k <= degree; k++)
     {
-        point = point + m_vControlPoints[k] * vfB[k];
+        point = point + m_vControlPoints[k] * m_vBernstein[k];
     }
 }
 
 void MyBezier::_derivative(int degree, float u, glm::vec2& der)
 {
-    std::vector<float> vfB(degree, 0.0f);
+    m_vBernstein.assign(degree, 0.0f);
 
-    _allBernstein(degree - 1, u, vfB.data());
+    _allBernstein(degree - 1, u, m_vBernstein.data());
     der = glm::vec3{ 0.0f };
     for (int k = 0; k <= degree - 1; k++)
     {
-        der = der +  (m_vControlPoints[k + 1] - m_vControlPoints[k]) * vfB[k];
+        der = der +  (m_vControlPoints[k + 1] - m_vControlPoints[k]) * m_vBernstein[k];
     }
 
     der = der * (float)degree;
@@ -28,6 +28,7 @@ protected:
 
 	std::vector<glm::vec2>          m_vControlPoints;
 	//float                           m_fB[100]; // Bernstein function
+	std::vector<float>              m_vBernstein;    // scratch of _allBernstein, keeps its capacity between calls
 };
 
 
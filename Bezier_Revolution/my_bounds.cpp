@@ -0,0 +1,436 @@
+#include "my_bounds.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <iterator>
+#include <thread>
+
+//
+// Box of the points after the upper 3x3 of the transform, without the translation.
+// Every lane keeps its own minimum and maximum, so the inner loop is element wise and the
+// compiler turns it into SIMD min and max instructions. A single running minimum would be a
+// reduction, which is only vectorized with fast math
+//
+static MyAabb transformedBox(const float* pX, const float* pY, const float* pZ, size_t count, const glm::mat4& transform)
+{
+	static constexpr size_t LANES = 8;
+
+	const float m00 = transform[0][0], m10 = transform[1][0], m20 = transform[2][0];
+	const float m01 = transform[0][1], m11 = transform[1][1], m21 = transform[2][1];
+	const float m02 = transform[0][2], m12 = transform[1][2], m22 = transform[2][2];
+
+	float minX[LANES], maxX[LANES], minY[LANES], maxY[LANES], minZ[LANES], maxZ[LANES];
+	for (size_t k = 0; k < LANES; k++)
+	{
+		minX[k] = minY[k] = minZ[k] = std::numeric_limits<float>::max();
+		maxX[k] = maxY[k] = maxZ[k] = -std::numeric_limits<float>::max();
+	}
+
+	auto accumulate = [&](size_t i, size_t k)
+	{
+		float x = m00 * pX[i] + m10 * pY[i] + m20 * pZ[i];
+		float y = m01 * pX[i] + m11 * pY[i] + m21 * pZ[i];
+		float z = m02 * pX[i] + m12 * pY[i] + m22 * pZ[i];
+
+		minX[k] = x < minX[k] ? x : minX[k];
+		maxX[k] = x > maxX[k] ? x : maxX[k];
+		minY[k] = y < minY[k] ? y : minY[k];
+		maxY[k] = y > maxY[k] ? y : maxY[k];
+		minZ[k] = z < minZ[k] ? z : minZ[k];
+		maxZ[k] = z > maxZ[k] ? z : maxZ[k];
+	};
+
+	size_t i = 0;
+	for (; i + LANES <= count; i += LANES)
+	{
+		for (size_t k = 0; k < LANES; k++)
+		{
+			accumulate(i + k, k);
+		}
+	}
+
+	// The points that do not fill all lanes go to the first lanes
+	for (size_t k = 0; i < count; i++, k++)
+	{
+		accumulate(i, k);
+	}
+
+	MyAabb box;
+	for (size_t k = 0; k < LANES; k++)
+	{
+		box.min = glm::min(box.min, glm::vec3(minX[k], minY[k], minZ[k]));
+		box.max = glm::max(box.max, glm::vec3(maxX[k], maxY[k], maxZ[k]));
+	}
+	return box;
+}
+
+//
+// Squared distance of the farthest transformed point to center, with the same lanes as
+// transformedBox
+//
+static float farthestDistance2(const float* pX, const float* pY, const float* pZ, size_t count, const glm::mat4& transform, const glm::vec3& center)
+{
+	static constexpr size_t LANES = 8;
+
+	const float m00 = transform[0][0], m10 = transform[1][0], m20 = transform[2][0];
+	const float m01 = transform[0][1], m11 = transform[1][1], m21 = transform[2][1];
+	const float m02 = transform[0][2], m12 = transform[1][2], m22 = transform[2][2];
+	const glm::vec3 offset = glm::vec3(transform[3]) - center;
+
+	float maxDistance2[LANES] = {};
+
+	auto accumulate = [&](size_t i, size_t k)
+	{
+		float x = m00 * pX[i] + m10 * pY[i] + m20 * pZ[i] + offset.x;
+		float y = m01 * pX[i] + m11 * pY[i] + m21 * pZ[i] + offset.y;
+		float z = m02 * pX[i] + m12 * pY[i] + m22 * pZ[i] + offset.z;
+
+		float distance2 = x * x + y * y + z * z;
+		maxDistance2[k] = distance2 > maxDistance2[k] ? distance2 : maxDistance2[k];
+	};
+
+	size_t i = 0;
+	for (; i + LANES <= count; i += LANES)
+	{
+		for (size_t k = 0; k < LANES; k++)
+		{
+			accumulate(i + k, k);
+		}
+	}
+
+	for (size_t k = 0; i < count; i++, k++)
+	{
+		accumulate(i, k);
+	}
+
+	float result = 0.0f;
+	for (size_t k = 0; k < LANES; k++)
+	{
+		result = std::max(result, maxDistance2[k]);
+	}
+	return result;
+}
+
+//
+// Runs pass(first, count) on one chunk of the points per thread and combines the results
+// with merge(a, b). Small point sets stay on this thread, asking for the core count is not
+// free and small objects move every frame
+//
+template<typename T, typename Pass, typename Merge>
+static T parallelPass(size_t count, Pass&& pass, Merge&& merge)
+{
+	uint32_t threadCount = count < MySceneBounds::PARALLEL_MIN_POINTS ? 1 : std::max(std::thread::hardware_concurrency(), 1u);
+	if (threadCount == 1)
+	{
+		return pass(0, count);
+	}
+
+	// This thread takes the first chunk
+	size_t chunkSize = (count + threadCount - 1) / threadCount;
+	std::vector<std::future<T>> futures;
+	for (size_t first = chunkSize; first < count; first += chunkSize)
+	{
+		size_t chunkCount = std::min(chunkSize, count - first);
+		futures.push_back(std::async(std::launch::async, [&pass, first, chunkCount]()
+		{
+			return pass(first, chunkCount);
+		}));
+	}
+
+	T result = pass(0, std::min(chunkSize, count));
+	for (std::future<T>& future : futures)
+	{
+		result = merge(result, future.get());
+	}
+	return result;
+}
+
+// Distance from the point to the farthest corner of the box, no point in the box is farther
+static float farthestCorner(const MyAabb& box, const glm::vec3& point)
+{
+	return glm::length(glm::max(glm::abs(box.min - point), glm::abs(box.max - point)));
+}
+
+void MySceneBounds::setTransform(MySlotHandle object, const glm::mat4& transform)
+{
+	Entry* pEntry = _find(object);
+	if (pEntry == nullptr || pEntry->transform == transform)
+	{
+		return;
+	}
+
+	pEntry->transform = transform;
+	_changed(*pEntry);
+}
+
+void MySceneBounds::setVisible(MySlotHandle object, bool bVisible)
+{
+	Entry* pEntry = _find(object);
+	if (pEntry == nullptr || pEntry->bVisible == bVisible)
+	{
+		return;
+	}
+
+	pEntry->bVisible = bVisible;
+	m_bSceneDirty = true;
+}
+
+void MySceneBounds::remove(MySlotHandle object)
+{
+	Entry* pEntry = _find(object);
+	if (pEntry == nullptr)
+	{
+		return;
+	}
+
+	if (pEntry->bVisible)
+	{
+		m_bSceneDirty = true;
+	}
+	*pEntry = Entry{};
+}
+
+const MySphere& MySceneBounds::sceneSphere()
+{
+	if (!m_bSceneDirty)
+	{
+		return m_mySceneSphere;
+	}
+	m_bSceneDirty = false;
+
+	// Only the objects that changed since the last call read their points here
+	MyAabb sceneBox;
+	m_vpVisible.clear();
+	for (Entry& entry : m_vEntries)
+	{
+		if (entry.handle.isValid() && entry.bVisible)
+		{
+			if (entry.bDirty)
+			{
+				_update(entry);
+			}
+			if (!entry.box.isEmpty())
+			{
+				sceneBox.expand(entry.box);
+				m_vpVisible.push_back(&entry);
+			}
+		}
+	}
+
+	if (sceneBox.isEmpty())
+	{
+		m_mySceneSphere = MySphere{};
+		return m_mySceneSphere;
+	}
+
+	// Box shaped scenes like a single cube fool the start of Ritter's algorithm,
+	// the sphere around the center of the box is smaller for them
+	MySphere ritterSphere = _ritterSphere(sceneBox);
+	MySphere boxSphere = _boxCenterSphere(sceneBox);
+	m_mySceneSphere = boxSphere.radius < ritterSphere.radius ? boxSphere : ritterSphere;
+	return m_mySceneSphere;
+}
+
+MySphere MySceneBounds::_ritterSphere(const MyAabb& sceneBox) const
+{
+	// The points with the smallest and the largest coordinate along an axis are in the objects
+	// whose boxes reach the scene box on that side, only those objects are searched for them
+	const Entry* minOwners[3] = {};
+	const Entry* maxOwners[3] = {};
+	for (const Entry* pEntry : m_vpVisible)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (minOwners[axis] == nullptr && pEntry->box.min[axis] == sceneBox.min[axis]) minOwners[axis] = pEntry;
+			if (maxOwners[axis] == nullptr && pEntry->box.max[axis] == sceneBox.max[axis]) maxOwners[axis] = pEntry;
+		}
+	}
+
+	glm::vec3 minPoints[3];
+	glm::vec3 maxPoints[3];
+	for (const Entry* pEntry : m_vpVisible)
+	{
+		if (std::find(std::begin(minOwners), std::end(minOwners), pEntry) == std::end(minOwners) &&
+			std::find(std::begin(maxOwners), std::end(maxOwners), pEntry) == std::end(maxOwners))
+		{
+			continue;
+		}
+
+		glm::vec3 objectMinPoints[3];
+		glm::vec3 objectMaxPoints[3];
+		_extremePoints(*pEntry, objectMinPoints, objectMaxPoints);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (minOwners[axis] == pEntry) minPoints[axis] = objectMinPoints[axis];
+			if (maxOwners[axis] == pEntry) maxPoints[axis] = objectMaxPoints[axis];
+		}
+	}
+
+	// The most distant of the three pairs is the first diameter
+	MySphere sphere;
+	float maxDistance2 = -1.0f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		glm::vec3 diameter = maxPoints[axis] - minPoints[axis];
+		float distance2 = glm::dot(diameter, diameter);
+		if (distance2 > maxDistance2)
+		{
+			maxDistance2 = distance2;
+			sphere.center = (minPoints[axis] + maxPoints[axis]) * 0.5f;
+			sphere.radius = std::sqrt(distance2) * 0.5f;
+		}
+	}
+
+	// Grow to take in every point that is still outside. An object whose box is inside the
+	// sphere has no such point, and a block of points is only walked one by one when the
+	// SIMD pass finds a point of it outside
+	static constexpr size_t BLOCK_POINTS = 1024;
+	for (const Entry* pEntry : m_vpVisible)
+	{
+		const Entry& entry = *pEntry;
+		if (farthestCorner(entry.box, sphere.center) <= sphere.radius)
+		{
+			continue;
+		}
+
+		const glm::mat4& m = entry.transform;
+		size_t count = entry.vX.size();
+		for (size_t first = 0; first < count; first += BLOCK_POINTS)
+		{
+			size_t blockCount = std::min(BLOCK_POINTS, count - first);
+			if (farthestDistance2(entry.vX.data() + first, entry.vY.data() + first, entry.vZ.data() + first, blockCount, m, sphere.center) <= sphere.radius * sphere.radius)
+			{
+				continue;
+			}
+
+			for (size_t i = first; i < first + blockCount; i++)
+			{
+				glm::vec3 point = glm::vec3(m[0]) * entry.vX[i] + glm::vec3(m[1]) * entry.vY[i] + glm::vec3(m[2]) * entry.vZ[i] + glm::vec3(m[3]);
+				glm::vec3 offset = point - sphere.center;
+				float distance2 = glm::dot(offset, offset);
+				if (distance2 > sphere.radius * sphere.radius)
+				{
+					// The new sphere touches the point and the far side of the old sphere
+					float distance = std::sqrt(distance2);
+					float radius = (sphere.radius + distance) * 0.5f;
+					sphere.center += offset * ((radius - sphere.radius) / distance);
+					sphere.radius = radius;
+				}
+			}
+		}
+	}
+	return sphere;
+}
+
+MySphere MySceneBounds::_boxCenterSphere(const MyAabb& sceneBox)
+{
+	glm::vec3 center = (sceneBox.min + sceneBox.max) * 0.5f;
+
+	// No point of an object is farther from the center than the farthest corner of its box
+	m_vCandidates.clear();
+	for (Entry* pEntry : m_vpVisible)
+	{
+		m_vCandidates.emplace_back(farthestCorner(pEntry->box, center), pEntry);
+	}
+	std::sort(m_vCandidates.begin(), m_vCandidates.end(),
+		[](const std::pair<float, Entry*>& a, const std::pair<float, Entry*>& b) { return a.first > b.first; });
+
+	// Visit the objects from the largest bound down, and stop once no bound is beyond the
+	// farthest point so far. The bounds get a little slack for rounding
+	float radius2 = 0.0f;
+	for (const std::pair<float, Entry*>& candidate : m_vCandidates)
+	{
+		float bound = candidate.first * 1.0001f;
+		if (bound * bound <= radius2)
+		{
+			break;
+		}
+
+		const Entry& entry = *candidate.second;
+		radius2 = std::max(radius2, parallelPass<float>(entry.vX.size(), [&entry, &center](size_t first, size_t count)
+		{
+			return farthestDistance2(entry.vX.data() + first, entry.vY.data() + first, entry.vZ.data() + first, count, entry.transform, center);
+		}, [](float a, float b) { return std::max(a, b); }));
+	}
+
+	MySphere sphere;
+	sphere.center = center;
+	sphere.radius = std::sqrt(radius2);
+	return sphere;
+}
+
+MySceneBounds::Entry* MySceneBounds::_find(MySlotHandle object)
+{
+	if (!object.isValid() || object.index >= m_vEntries.size() || m_vEntries[object.index].handle != object)
+	{
+		return nullptr;
+	}
+	return &m_vEntries[object.index];
+}
+
+MySceneBounds::Entry& MySceneBounds::_entry(MySlotHandle object)
+{
+	if (object.index >= m_vEntries.size())
+	{
+		m_vEntries.resize(object.index + 1);
+	}
+
+	// A stale object in the same slot is replaced
+	Entry& entry = m_vEntries[object.index];
+	if (entry.handle != object)
+	{
+		if (entry.handle.isValid() && entry.bVisible)
+		{
+			m_bSceneDirty = true;
+		}
+		entry = Entry{};
+		entry.handle = object;
+	}
+	return entry;
+}
+
+void MySceneBounds::_changed(Entry& entry)
+{
+	entry.bDirty = true;
+	if (entry.bVisible)
+	{
+		m_bSceneDirty = true;
+	}
+}
+
+void MySceneBounds::_update(Entry& entry)
+{
+	entry.bDirty = false;
+	entry.box = MyAabb{};
+
+	size_t count = entry.vX.size();
+	if (count == 0)
+	{
+		return;
+	}
+
+	entry.box = parallelPass<MyAabb>(count, [&entry](size_t first, size_t chunkCount)
+	{
+		return transformedBox(entry.vX.data() + first, entry.vY.data() + first, entry.vZ.data() + first, chunkCount, entry.transform);
+	}, [](MyAabb a, const MyAabb& b) { a.expand(b); return a; });
+
+	glm::vec3 translation = glm::vec3(entry.transform[3]);
+	entry.box.min += translation;
+	entry.box.max += translation;
+}
+
+void MySceneBounds::_extremePoints(const Entry& entry, glm::vec3 minPoints[3], glm::vec3 maxPoints[3])
+{
+	const glm::mat4& m = entry.transform;
+	for (size_t i = 0; i < entry.vX.size(); i++)
+	{
+		glm::vec3 point = glm::vec3(m[0]) * entry.vX[i] + glm::vec3(m[1]) * entry.vY[i] + glm::vec3(m[2]) * entry.vZ[i] + glm::vec3(m[3]);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (i == 0 || point[axis] < minPoints[axis][axis]) minPoints[axis] = point;
+			if (i == 0 || point[axis] > maxPoints[axis][axis]) maxPoints[axis] = point;
+		}
+	}
+}
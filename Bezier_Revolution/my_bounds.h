@@ -0,0 +1,115 @@
+#ifndef __MY_BOUNDS_H__
+#define __MY_BOUNDS_H__
+
+#include "my_slot_map.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <limits>
+#include <utility>
+#include <vector>
+
+struct MyAabb
+{
+	glm::vec3 min{ std::numeric_limits<float>::max() };
+	glm::vec3 max{ -std::numeric_limits<float>::max() };
+
+	bool isEmpty() const { return min.x > max.x; }
+
+	void expand(const MyAabb& other)
+	{
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+};
+
+struct MySphere
+{
+	glm::vec3 center{ 0.0f };
+	float     radius = -1.0f;   // negative for an empty sphere
+
+	bool isEmpty() const { return radius < 0.0f; }
+};
+
+//
+// Bounding sphere of the objects of a scene, keyed by their slot map handle, used to frame
+// all of them. Every object keeps a copy of its object space vertex positions, one array per
+// coordinate, and caches its world space box. Changes only mark the object, the next
+// sceneSphere call brings the boxes of the objects that changed up to date. The sphere comes
+// from Ritter's algorithm over the world space vertices, which is not minimal but usually
+// within a few percent of it, or the sphere around the center of the scene box when that one
+// is smaller. The boxes tell where Ritter's starting points are and which objects can not
+// grow the sphere, so most points are only read by a SIMD pass or not at all
+//
+class MySceneBounds
+{
+public:
+	// Point sets at least this large are processed on several threads
+	static constexpr size_t PARALLEL_MIN_POINTS = 65536;
+
+	// Replaces the object space points of the object, V is anything with a glm::vec3 position.
+	// The object is added if it is new. The arrays keep their capacity, so refreshing points
+	// that did not grow does not allocate
+	template<typename V>
+	void setPoints(MySlotHandle object, const std::vector<V>& vertices)
+	{
+		Entry& entry = _entry(object);
+		entry.vX.resize(vertices.size());
+		entry.vY.resize(vertices.size());
+		entry.vZ.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			entry.vX[i] = vertices[i].position.x;
+			entry.vY[i] = vertices[i].position.y;
+			entry.vZ[i] = vertices[i].position.z;
+		}
+		_changed(entry);
+	}
+
+	void setTransform(MySlotHandle object, const glm::mat4& transform);
+
+	// Hidden objects keep their points but are left out of the scene sphere
+	void setVisible(MySlotHandle object, bool bVisible);
+	void remove(MySlotHandle object);
+
+	// Of all visible objects, empty if there are none
+	const MySphere& sceneSphere();
+
+private:
+	struct Entry
+	{
+		MySlotHandle       handle;
+		std::vector<float> vX;
+		std::vector<float> vY;
+		std::vector<float> vZ;
+		glm::mat4          transform{ 1.0f };
+		MyAabb             box;               // world space
+		bool               bVisible = true;
+		bool               bDirty = true;     // the box is out of date
+	};
+
+	Entry*       _find(MySlotHandle object);
+	Entry&       _entry(MySlotHandle object);
+
+	void         _changed(Entry& entry);
+	void         _update(Entry& entry);
+
+	// Of the visible objects, whose boxes make up sceneBox
+	MySphere     _ritterSphere(const MyAabb& sceneBox) const;
+	MySphere     _boxCenterSphere(const MyAabb& sceneBox);
+
+	// The world space points with the smallest and the largest coordinate along each axis
+	static void  _extremePoints(const Entry& entry, glm::vec3 minPoints[3], glm::vec3 maxPoints[3]);
+
+	std::vector<Entry>                   m_vEntries;        // indexed by the slot index of the handle
+	std::vector<Entry*>                  m_vpVisible;       // visible objects with points, kept to not allocate every call
+	std::vector<std::pair<float, Entry*>> m_vCandidates;     // visible objects and how far their points can be from the box center
+	MySphere                             m_mySceneSphere;
+	bool                                 m_bSceneDirty = true;
+};
+
+#endif
@@ -8,10 +8,37 @@
 #include "my_buffer.h"
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
 
+void MyDirtyRanges::add(VkDeviceSize offset, VkDeviceSize size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    VkDeviceSize end = offset + size;
+
+    // First range that ends at or after the new one starts, it and the ranges
+    // after it that start before the new one ends are merged into it
+    auto first = std::lower_bound(m_vRanges.begin(), m_vRanges.end(), offset,
+        [](const Range& range, VkDeviceSize value) { return range.offset + range.size < value; });
+
+    auto last = first;
+    while (last != m_vRanges.end() && last->offset <= end)
+    {
+        offset = std::min(offset, last->offset);
+        end = std::max(end, last->offset + last->size);
+        last++;
+    }
+
+    first = m_vRanges.erase(first, last);
+    m_vRanges.insert(first, Range{ offset, end - offset });
+}
+
 
 /**
  * Returns the minimum instance size required to be compatible with devices minOffsetAlignment
@@ -38,8 +65,10 @@ MyBuffer::MyBuffer(
     uint32_t instanceCount,
     VkBufferUsageFlags usageFlags,
     VkMemoryPropertyFlags memoryPropertyFlags,
-    VkDeviceSize minOffsetAlignment)
+    VkDeviceSize minOffsetAlignment,
+    const std::string& owner)
     : m_myDevice{ device },
+    m_sOwner{ owner },
     m_vkInstanceSize{ instanceSize },
     m_iInstanceCount{ instanceCount },
     m_vkUsageFlags{ usageFlags },
@@ -48,14 +77,14 @@ MyBuffer::MyBuffer(
     // Get the smallest size required for alignment/padding
     m_vkAlignmentSize = alignmentSize(instanceSize, minOffsetAlignment);
     m_vkBufferSize = m_vkAlignmentSize * instanceCount;
-    m_myDevice.createBuffer(m_vkBufferSize, usageFlags, memoryPropertyFlags, m_vkBuffer, m_vkMemory);
+    m_myDevice.createBuffer(m_vkBufferSize, usageFlags, memoryPropertyFlags, m_vkBuffer, m_vkMemory, owner);
 }
 
 MyBuffer::~MyBuffer()
 {
     unmap();
     vkDestroyBuffer(m_myDevice.device(), m_vkBuffer, nullptr);
-    vkFreeMemory(m_myDevice.device(), m_vkMemory, nullptr);
+    m_myDevice.freeMemory(m_vkMemory);
 }
 
 /**
@@ -133,6 +162,100 @@ VkResult MyBuffer::flush(VkDeviceSize size, VkDeviceSize offset)
     return vkFlushMappedMemoryRanges(m_myDevice.device(), 1, &mappedRange);
 }
 
+/**
+ * Copies the specified data into the buffer and records the range as dirty. Nothing is made
+ * visible to the device until flushDirtyRanges
+ *
+ * @param data Pointer to the data to copy
+ * @param size Size of the data to copy
+ * @param offset Byte offset from beginning of the buffer
+ *
+ */
+void MyBuffer::writeRange(const void* data, VkDeviceSize size, VkDeviceSize offset)
+{
+    assert(offset + size <= m_vkBufferSize && "Range is outside of the buffer");
+
+    if (_isHostVisible())
+    {
+        assert(m_pMappedMemeoy && "Cannot copy to unmapped buffer");
+        memcpy((char*)m_pMappedMemeoy + offset, data, static_cast<size_t>(size));
+    }
+    else
+    {
+        if (!m_pStagingBuffer)
+        {
+            // Same layout as this buffer, so a dirty range has the same offset in both
+            m_pStagingBuffer = std::make_unique<MyBuffer>(
+                m_myDevice,
+                m_vkBufferSize,
+                1,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                1,
+                m_sOwner + " staging");
+            m_pStagingBuffer->map();
+        }
+
+        m_pStagingBuffer->writeRange(data, size, offset);
+    }
+
+    m_dirtyRanges.add(offset, size);
+}
+
+/**
+ * Make the ranges written by writeRange visible to the device
+ *
+ * @note Host coherent memory needs nothing, non-coherent memory flushes the ranges
+ * rounded to nonCoherentAtomSize and device local memory copies them from the
+ * staging buffer, which waits for the copy to complete
+ *
+ * @return VkResult of the flush call
+ */
+VkResult MyBuffer::flushDirtyRanges()
+{
+    VkResult result = VK_SUCCESS;
+
+    if (m_dirtyRanges.empty())
+    {
+        return result;
+    }
+
+    if (m_pStagingBuffer)
+    {
+        std::vector<VkBufferCopy> regions;
+        for (auto& range : m_dirtyRanges.ranges())
+        {
+            regions.push_back(VkBufferCopy{ range.offset, range.offset, range.size });
+        }
+
+        m_myDevice.copyBufferRegions(m_pStagingBuffer->buffer(), m_vkBuffer, regions);
+    }
+    else if (!(m_vkMemoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+    {
+        VkDeviceSize atomSize = m_myDevice.properties().limits.nonCoherentAtomSize;
+
+        std::vector<VkMappedMemoryRange> mappedRanges;
+        for (auto& range : m_dirtyRanges.ranges())
+        {
+            VkMappedMemoryRange mappedRange = {};
+            mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            mappedRange.memory = m_vkMemory;
+            mappedRange.offset = range.offset / atomSize * atomSize;
+
+            // The last atom may reach past the buffer, then flush to the end of the memory instead
+            VkDeviceSize end = alignmentSize(range.offset + range.size, atomSize);
+            mappedRange.size = end > m_vkBufferSize ? VK_WHOLE_SIZE : end - mappedRange.offset;
+
+            mappedRanges.push_back(mappedRange);
+        }
+
+        result = vkFlushMappedMemoryRanges(m_myDevice.device(), static_cast<uint32_t>(mappedRanges.size()), mappedRanges.data());
+    }
+
+    m_dirtyRanges.clear();
+    return result;
+}
+
 /**
  * Create a buffer info descriptor
  *
@@ -3,6 +3,33 @@
 
 #include "my_device.h"
 
+// std
+#include <memory>
+#include <string>
+#include <vector>
+
+//
+// Sorted byte ranges waiting to be uploaded. A range that overlaps or touches
+// the existing ones is merged with them
+//
+class MyDirtyRanges
+{
+public:
+    struct Range
+    {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    void                      add(VkDeviceSize offset, VkDeviceSize size);
+    void                      clear()        { m_vRanges.clear(); }
+    bool                      empty()  const { return m_vRanges.empty(); }
+    const std::vector<Range>& ranges() const { return m_vRanges; }
+
+private:
+    std::vector<Range>        m_vRanges;
+};
+
 //
 // Wrap VkBuffer and VkBuffer Memory into a single class
 //
@@ -15,7 +42,8 @@ public:
         uint32_t instanceCount,
         VkBufferUsageFlags usageFlags,
         VkMemoryPropertyFlags memoryPropertyFlags,
-        VkDeviceSize minOffsetAlignment = 1);
+        VkDeviceSize minOffsetAlignment = 1,
+        const std::string& owner = "MyBuffer"); // shows up in the device memory report
     ~MyBuffer();
 
     MyBuffer(const MyBuffer&) = delete;
@@ -27,14 +55,26 @@ public:
     // Mapping memoey and write to device memory
     void                   writeToBuffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
     VkResult               flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+    // Partial updates. The written ranges are merged and only those reach the device on
+    // flushDirtyRanges: flushed for non-coherent memory, copied through a staging buffer
+    // for device local memory. A host visible buffer must be mapped first
+    void                   writeRange(const void* data, VkDeviceSize size, VkDeviceSize offset);
+    VkResult               flushDirtyRanges();
+    bool                   hasDirtyRanges() const { return !m_dirtyRanges.empty(); }
+
     //VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
     VkBuffer               buffer() const { return m_vkBuffer; }
+    VkDeviceSize           instanceAlignmentSize() const { return m_vkAlignmentSize; } // instance size padded to the alignment
 
 private:
     // Need to follow certain memory padding guideline 
     static VkDeviceSize    alignmentSize(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
 
+    bool                   _isHostVisible() const { return m_vkMemoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT; }
+
     MyDevice&              m_myDevice;
+    std::string            m_sOwner;
     void*                  m_pMappedMemeoy = nullptr;
     VkBuffer               m_vkBuffer = VK_NULL_HANDLE;
     VkDeviceMemory         m_vkMemory = VK_NULL_HANDLE;
@@ -45,6 +85,9 @@ private:
     VkDeviceSize           m_vkAlignmentSize;
     VkBufferUsageFlags     m_vkUsageFlags;
     VkMemoryPropertyFlags  m_vkMemoryPropertyFlags;
+
+    MyDirtyRanges             m_dirtyRanges;
+    std::unique_ptr<MyBuffer> m_pStagingBuffer;  // device local buffers only, created by the first writeRange
 };
 
 #endif
@@ -33,7 +33,8 @@ public:
 
     // Assignment
     void setMode(MyCameraMode mode);
-    void setSceneMinMax(glm::vec3 min, glm::vec3 max);
+    // The sphere around everything visible, fit all frames it and the camera turns about its center
+    void setSceneSphere(glm::vec3 center, float radius);
     void setButton(bool buttonPress, float x, float y);
     void setMotion(bool buttonPress, float x, float y);
 
@@ -45,6 +46,9 @@ private:
     void _twist(float dx, float dy);
     void _fitAll();
 
+    // Distance from the scene center at which the scene sphere just fits into the view
+    float _fitDistance() const;
+
     void _atRotate(float x, float y, float z, float angle);
     void _getScreenXYZ(glm::vec3 &sx, glm::vec3 &sy, glm::vec3 &sz);
 
@@ -54,8 +58,12 @@ private:
     glm::vec2    m_vCurrPos;
     glm::vec2    m_vPrevPos;
 
-    glm::vec3    m_vSceneMin;
-    glm::vec3    m_vSceneMax;
+    glm::vec3    m_vSceneCenter{ 0.0f };
+    float        m_fSceneRadius = 1.0f;
+
+    // Of the last perspective projection, fit all needs the field of view
+    float        m_fFovy = glm::radians(50.0f);
+    float        m_fAspect = 1.0f;
     
     bool         m_bMoving = false;
     MyCameraMode m_eMode = MYCAMERA_NONE;
@@ -0,0 +1,111 @@
+#ifndef __MY_CPU_PROFILER_H__
+#define __MY_CPU_PROFILER_H__
+
+// std
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//
+// Record how long the phases of a frame take on every thread. Each thread writes into its
+// own ring buffer of the last RING_SIZE scopes, so recording is one uncontended lock and
+// never allocates after the first scope of the thread
+//
+class MyCpuProfiler
+{
+public:
+	static constexpr size_t   RING_SIZE = 16384;
+	static constexpr uint32_t DEFAULT_REPORT_INTERVAL = 300; // frames
+
+	struct Event
+	{
+		const char* name;        // must outlive the profiler, string literals only
+		uint64_t    startNs;
+		uint64_t    durationNs;
+	};
+
+	static MyCpuProfiler& instance();
+
+	MyCpuProfiler(const MyCpuProfiler&) = delete;
+	MyCpuProfiler& operator=(const MyCpuProfiler&) = delete;
+
+	// Nanoseconds since the profiler was created
+	uint64_t now() const;
+
+	void     record(const char* name, uint64_t startNs, uint64_t endNs);
+
+	// Call once per frame on the main thread. Prints the report every reportInterval frames,
+	// 0 turns the periodic report off
+	void     endFrame();
+	void     setReportInterval(uint32_t frames) { m_iReportInterval = frames; }
+
+	// Heap allocations made during one frame, see MyAllocationCounter. Only aggregated,
+	// so recording never allocates itself
+	void     recordFrameAllocations(uint64_t count);
+
+	// p50/p95/p99 of every scope name and the allocations per frame recorded since the previous report
+	void     printReport(std::ostream& out);
+
+	// Chrome trace event JSON of what is left in the ring buffers,
+	// open it in chrome://tracing or https://ui.perfetto.dev
+	void     writeChromeTrace(const std::string& filepath);
+
+private:
+	struct ThreadRing
+	{
+		uint32_t           threadID;
+		std::mutex         mutex;
+		std::vector<Event> vEvents;     // ring buffer of RING_SIZE events
+		uint64_t           written = 0; // total number of events, the ring holds the last RING_SIZE
+	};
+
+	MyCpuProfiler();
+
+	ThreadRing& _threadRing();
+
+	std::chrono::steady_clock::time_point    m_startTime;
+	std::mutex                               m_mutex;    // guards m_vThreadRings
+	std::vector<std::unique_ptr<ThreadRing>> m_vThreadRings;
+
+	uint32_t                                 m_iReportInterval = DEFAULT_REPORT_INTERVAL;
+	uint32_t                                 m_iFrameCount = 0;
+	uint64_t                                 m_iLastReportNs = 0;
+
+	// Allocations per frame since the last report
+	uint32_t                                 m_iAllocationFrames = 0;
+	uint32_t                                 m_iAllocatingFrames = 0;
+	uint64_t                                 m_iAllocationTotal = 0;
+	uint64_t                                 m_iAllocationMax = 0;
+};
+
+//
+// Times the enclosing block: { MyCpuScope scope{ "pollEvents" }; ... }
+//
+class MyCpuScope
+{
+public:
+	MyCpuScope(const char* name) :
+		m_pName{ name },
+		m_iStartNs{ MyCpuProfiler::instance().now() }
+	{
+	}
+
+	~MyCpuScope()
+	{
+		MyCpuProfiler& profiler = MyCpuProfiler::instance();
+		profiler.record(m_pName, m_iStartNs, profiler.now());
+	}
+
+	MyCpuScope(const MyCpuScope&) = delete;
+	MyCpuScope& operator=(const MyCpuScope&) = delete;
+
+private:
+	const char* m_pName;
+	uint64_t    m_iStartNs;
+};
+
+#endif
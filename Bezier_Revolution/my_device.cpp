@@ -1,7 +1,12 @@
 #include "my_device.h"
+#include "my_tracer.h"
 
 // std headers
+#include <cassert>
 #include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -52,20 +57,60 @@ void DestroyDebugUtilsMessengerEXT(
     }
 }
 
+static MyMemoryCategory bufferMemoryCategory(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+{
+    if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)  return MyMemoryCategory::Vertex;
+    if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)   return MyMemoryCategory::Index;
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) return MyMemoryCategory::Uniform;
+    
+    if ((usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) && (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+    {
+        return MyMemoryCategory::Staging;
+    }
+    
+    return MyMemoryCategory::Other;
+}
+
+static MyMemoryCategory imageMemoryCategory(VkImageUsageFlags usage)
+{
+    if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) return MyMemoryCategory::Depth;
+    if (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)         return MyMemoryCategory::ColorAttachment;
+    
+    return MyMemoryCategory::Other;
+}
+
+const char* memoryCategoryName(MyMemoryCategory category)
+{
+    switch (category)
+    {
+        case MyMemoryCategory::Vertex:          return "vertex";
+        case MyMemoryCategory::Index:           return "index";
+        case MyMemoryCategory::Uniform:         return "uniform";
+        case MyMemoryCategory::Staging:         return "staging";
+        case MyMemoryCategory::Depth:           return "depth";
+        case MyMemoryCategory::ColorAttachment: return "color attachment";
+        default:                                return "other";
+    }
+}
+
 // class member functions
 MyDevice::MyDevice(MyWindow &window) :
     m_myWindow{ window } 
 {
     _createInstance();      // Create a Vulkan instance and connect our application window with Vulkan instance
     _setupDebugMessenger(); // Set up validation layer to check for error during debug, and uncheck for release build
-    _createSurface();       // Create a surface for GLFW to connect with Window
+    _createSurface();       // Create a surface for GLFW to connect with Window (none when headless)
     _pickPhysicalDevice();  // Pick the graphics hardware device (GPU) that is capable of using VulKan API
     _createLogicalDevice(); // Describe what featues we would like to use for the physical device we just pick
     _createCommandPool();   // Ceate command buffer to send command to the device
+    _createPipelineCache(); // Reuse the pipelines compiled in the previous runs
 }
 
 MyDevice::~MyDevice() 
 {
+    _printLeakReport();
+    _savePipelineCache();
+    vkDestroyPipelineCache(m_vkDevice, m_vkPipelineCache, nullptr);
     vkDestroyCommandPool(m_vkDevice, m_vkCommandPool, nullptr);
     vkDestroyDevice(m_vkDevice, nullptr);
     
@@ -74,7 +119,11 @@ MyDevice::~MyDevice()
         DestroyDebugUtilsMessengerEXT(m_vkInstance, m_vkDebugMessenger, nullptr);
     }
     
-    vkDestroySurfaceKHR(m_vkInstance, m_vkSurface, nullptr);
+    // VK_KHR_surface is not enabled when headless
+    if (m_vkSurface != VK_NULL_HANDLE)
+    {
+        vkDestroySurfaceKHR(m_vkInstance, m_vkSurface, nullptr);
+    }
     vkDestroyInstance(m_vkInstance, nullptr);
 }
 
@@ -91,7 +140,7 @@ void MyDevice::_createInstance()
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_2; // for vkGetPhysicalDeviceFeatures2 and timeline semaphores
     
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -165,9 +214,8 @@ void MyDevice::_pickPhysicalDevice()
         throw std::runtime_error("failed to find a suitable GPU!");
     }
     
-    VkPhysicalDeviceProperties properties;
-    vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
-    std::cout << "picked physical device: " << properties.deviceName << std::endl;
+    vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &m_vkProperties);
+    std::cout << "picked physical device: " << m_vkProperties.deviceName << std::endl;
 }
 
 void MyDevice::_createLogicalDevice() 
@@ -199,8 +247,40 @@ void MyDevice::_createLogicalDevice()
     
     createInfo.pEnabledFeatures = &deviceFeatures;
     
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    // Optional extensions are enabled on top of the required ones
+    std::vector<const char *> enabledExtensions = _requiredDeviceExtensions();
+    
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures = {};
+    extendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    
+    m_bExtendedDynamicState = _checkExtendedDynamicStateSupport(m_vkPhysicalDevice);
+    if (m_bExtendedDynamicState)
+    {
+        enabledExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+        extendedDynamicStateFeatures.extendedDynamicState = VK_TRUE;
+        createInfo.pNext = &extendedDynamicStateFeatures;
+    }
+    
+    m_bMemoryBudget = _checkMemoryBudgetSupport(m_vkPhysicalDevice);
+    if (m_bMemoryBudget)
+    {
+        enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+    
+    // Core in Vulkan 1.2, only the feature has to be enabled
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    
+    m_bTimelineSemaphore = _checkTimelineSemaphoreSupport(m_vkPhysicalDevice);
+    if (m_bTimelineSemaphore)
+    {
+        timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+        timelineSemaphoreFeatures.pNext = (void *)createInfo.pNext;
+        createInfo.pNext = &timelineSemaphoreFeatures;
+    }
+    
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
     
     // might not really be necessary anymore because device specific validation layers
     // have been deprecated
@@ -221,6 +301,37 @@ void MyDevice::_createLogicalDevice()
     
     vkGetDeviceQueue(m_vkDevice, indices.graphicsFamily, 0, &m_vkGraphicsQueue);
     vkGetDeviceQueue(m_vkDevice, indices.presentFamily, 0, &m_vkPresentQueue);
+    
+    if (m_bExtendedDynamicState)
+    {
+        m_pfnCmdSetPrimitiveTopology = (PFN_vkCmdSetPrimitiveTopologyEXT)vkGetDeviceProcAddr(
+            m_vkDevice,
+            "vkCmdSetPrimitiveTopologyEXT");
+        m_bExtendedDynamicState = m_pfnCmdSetPrimitiveTopology != nullptr;
+    }
+    
+    std::cout << "extended dynamic state: " << (m_bExtendedDynamicState ? "enabled" : "not available") << std::endl;
+    std::cout << "memory budget: " << (m_bMemoryBudget ? "enabled" : "not available") << std::endl;
+    std::cout << "timeline semaphore: " << (m_bTimelineSemaphore ? "enabled" : "not available") << std::endl;
+}
+
+uint32_t MyDevice::timestampValidBits()
+{
+    QueueFamilyIndices indices = _findQueueFamilies(m_vkPhysicalDevice);
+    
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_vkPhysicalDevice, &queueFamilyCount, nullptr);
+    
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_vkPhysicalDevice, &queueFamilyCount, queueFamilies.data());
+    
+    return queueFamilies[indices.graphicsFamily].timestampValidBits;
+}
+
+void MyDevice::cmdSetPrimitiveTopology(VkCommandBuffer commandBuffer, VkPrimitiveTopology topology)
+{
+    assert(m_bExtendedDynamicState && "Dynamic primitive topology needs VK_EXT_extended_dynamic_state");
+    m_pfnCmdSetPrimitiveTopology(commandBuffer, topology);
 }
 
 void MyDevice::_createCommandPool()
@@ -241,8 +352,94 @@ void MyDevice::_createCommandPool()
     }
 }
 
+void MyDevice::_createPipelineCache()
+{
+    std::vector<char> cacheData = _loadPipelineCacheData();
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = cacheData.size();
+    cacheInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+    if (vkCreatePipelineCache(m_vkDevice, &cacheInfo, nullptr, &m_vkPipelineCache) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+std::vector<char> MyDevice::_loadPipelineCacheData()
+{
+    std::ifstream file{ PIPELINE_CACHE_FILE, std::ios::ate | std::ios::binary };
+    if (!file.is_open())
+    {
+        std::cout << "pipeline cache: no " << PIPELINE_CACHE_FILE << ", starting cold" << std::endl;
+        return {};
+    }
+
+    std::vector<char> cacheData(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(cacheData.data(), cacheData.size());
+
+    // The driver would reject a cache from another GPU or driver version anyway,
+    // but check the header ourselves so a stale file is reported and replaced
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+
+    VkPipelineCacheHeaderVersionOne header = {};
+    if (cacheData.size() < sizeof(header))
+    {
+        std::cout << "pipeline cache: " << PIPELINE_CACHE_FILE << " is truncated, starting cold" << std::endl;
+        return {};
+    }
+    memcpy(&header, cacheData.data(), sizeof(header));
+
+    if (header.headerSize < sizeof(header) ||
+        header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        header.vendorID != properties.vendorID ||
+        header.deviceID != properties.deviceID ||
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        std::cout << "pipeline cache: " << PIPELINE_CACHE_FILE << " was created by another device or driver, starting cold" << std::endl;
+        return {};
+    }
+
+    std::cout << "pipeline cache: loaded " << cacheData.size() << " bytes, starting warm" << std::endl;
+    return cacheData;
+}
+
+void MyDevice::_savePipelineCache()
+{
+    size_t cacheSize = 0;
+    if (vkGetPipelineCacheData(m_vkDevice, m_vkPipelineCache, &cacheSize, nullptr) != VK_SUCCESS || cacheSize == 0)
+    {
+        return;
+    }
+
+    std::vector<char> cacheData(cacheSize);
+    if (vkGetPipelineCacheData(m_vkDevice, m_vkPipelineCache, &cacheSize, cacheData.data()) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    // Failing to save only costs a cold start next time, so do not throw from the destructor
+    std::ofstream file{ PIPELINE_CACHE_FILE, std::ios::binary | std::ios::trunc };
+    if (!file.is_open())
+    {
+        std::cerr << "pipeline cache: failed to write " << PIPELINE_CACHE_FILE << std::endl;
+        return;
+    }
+
+    file.write(cacheData.data(), cacheSize);
+}
+
 void MyDevice::_createSurface() 
 { 
+    if (isHeadless())
+    {
+        m_vkSurface = VK_NULL_HANDLE;
+        return;
+    }
+    
     m_myWindow.createWindowSurface(m_vkInstance, &m_vkSurface);
 }
 
@@ -252,8 +449,10 @@ bool MyDevice::_isDeviceSuitable(VkPhysicalDevice device)
     
     bool extensionsSupported = _checkDeviceExtensionSupport(device);
     
-    bool swapChainAdequate = false;
-    if (extensionsSupported) 
+    // Nothing is presented when headless, so a device without a present queue
+    // or swap chain support (e.g. lavapipe) is fine
+    bool swapChainAdequate = isHeadless();
+    if (extensionsSupported && !isHeadless()) 
     {
         SwapChainSupportDetails swapChainSupport = _querySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -382,7 +581,8 @@ bool MyDevice::_checkDeviceExtensionSupport(VkPhysicalDevice device)
         &extensionCount,
         availableExtensions.data());
     
-    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+    std::vector<const char *> deviceRequiredExtensions = _requiredDeviceExtensions();
+    std::set<std::string> requiredExtensions(deviceRequiredExtensions.begin(), deviceRequiredExtensions.end());
     
     for (const auto &extension : availableExtensions)
     {
@@ -392,6 +592,113 @@ bool MyDevice::_checkDeviceExtensionSupport(VkPhysicalDevice device)
     return requiredExtensions.empty();
 }
 
+std::vector<const char *> MyDevice::_requiredDeviceExtensions()
+{
+    if (isHeadless())
+    {
+        return {};
+    }
+    
+    return deviceExtensions;
+}
+
+bool MyDevice::_checkMemoryBudgetSupport(VkPhysicalDevice device)
+{
+    // The budget is read with vkGetPhysicalDeviceMemoryProperties2, core in Vulkan 1.1
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_1)
+    {
+        return false;
+    }
+    
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(
+        device,
+        nullptr,
+        &extensionCount,
+        availableExtensions.data());
+    
+    for (const auto &extension : availableExtensions)
+    {
+        if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+        {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool MyDevice::_checkTimelineSemaphoreSupport(VkPhysicalDevice device)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return false;
+    }
+    
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &timelineSemaphoreFeatures;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+    
+    return timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE;
+}
+
+bool MyDevice::_checkExtendedDynamicStateSupport(VkPhysicalDevice device)
+{
+    // The feature query below is core in Vulkan 1.1
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_1)
+    {
+        return false;
+    }
+    
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(
+        device,
+        nullptr,
+        &extensionCount,
+        availableExtensions.data());
+    
+    bool extensionFound = false;
+    for (const auto &extension : availableExtensions)
+    {
+        if (strcmp(extension.extensionName, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) == 0)
+        {
+            extensionFound = true;
+            break;
+        }
+    }
+    
+    if (!extensionFound)
+    {
+        return false;
+    }
+    
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures = {};
+    extendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &extendedDynamicStateFeatures;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+    
+    return extendedDynamicStateFeatures.extendedDynamicState == VK_TRUE;
+}
+
 QueueFamilyIndices MyDevice::_findQueueFamilies(VkPhysicalDevice device) 
 {
     QueueFamilyIndices indices;
@@ -402,7 +709,7 @@ QueueFamilyIndices MyDevice::_findQueueFamilies(VkPhysicalDevice device)
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
     
-    int i = 0;
+    uint32_t i = 0;
     for (const auto &queueFamily : queueFamilies) 
     {
         if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
@@ -411,8 +718,13 @@ QueueFamilyIndices MyDevice::_findQueueFamilies(VkPhysicalDevice device)
             indices.graphicsFamilyHasValue = true;
         }
 
+        // The graphics queue stands in for the present queue when headless
         VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_vkSurface, &presentSupport);
+        if (isHeadless())
+            presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == i;
+        else
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_vkSurface, &presentSupport);
+        
         if (queueFamily.queueCount > 0 && presentSupport)
         {
             indices.presentFamily = i;
@@ -502,7 +814,8 @@ void MyDevice::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory)
+    VkDeviceMemory &bufferMemory,
+    const std::string &owner)
 {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -528,11 +841,16 @@ void MyDevice::createBuffer(
         throw std::runtime_error("failed to allocate vertex buffer memory!");
     }
     
+    _trackAllocation(bufferMemory, bufferMemoryCategory(usage, properties), allocInfo.allocationSize, allocInfo.memoryTypeIndex, owner);
+    
     vkBindBufferMemory(m_vkDevice, buffer, bufferMemory, 0);
 }
 
 void MyDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
 {
+    // Includes the wait for the transfer to complete
+    MY_TRACE_SCOPE_ARGS("upload", "copyBuffer", "size=%llu bytes", static_cast<unsigned long long>(size));
+
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
     VkBufferCopy copyRegion{};
@@ -544,6 +862,31 @@ void MyDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize s
     endSingleTimeCommands(commandBuffer);
 }
 
+void MyDevice::copyBufferRegions(VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy>& regions)
+{
+    MY_TRACE_SCOPE_ARGS("upload", "copyBufferRegions", "regions=%zu", regions.size());
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+    // The copy waits for the earlier frames on the queue to finish reading the buffer,
+    // and its writes are made visible to the vertex input of the later frames
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    endSingleTimeCommands(commandBuffer);
+}
+
 VkCommandBuffer MyDevice::beginSingleTimeCommands() 
 {
     VkCommandBufferAllocateInfo allocInfo{};
@@ -583,7 +926,8 @@ void MyDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) 
+    VkDeviceMemory &imageMemory,
+    const std::string &owner) 
 {
    if (vkCreateImage(m_vkDevice, &imageInfo, nullptr, &image) != VK_SUCCESS)
    {
@@ -603,9 +947,160 @@ void MyDevice::createImageWithInfo(
        throw std::runtime_error("failed to allocate image memory!");
    }
    
+   _trackAllocation(imageMemory, imageMemoryCategory(imageInfo.usage), allocInfo.allocationSize, allocInfo.memoryTypeIndex, owner);
+   
    if (vkBindImageMemory(m_vkDevice, image, imageMemory, 0) != VK_SUCCESS)
    {
        throw std::runtime_error("failed to bind image memory!");
    }
 }
 
+
+void MyDevice::_trackAllocation(
+    VkDeviceMemory memory,
+    MyMemoryCategory category,
+    VkDeviceSize size,
+    uint32_t memoryTypeIndex,
+    const std::string &owner)
+{
+    std::lock_guard<std::mutex> lock{ m_memoryMutex };
+    
+    m_mapAllocations[memory] = MemoryAllocation{ category, size, memoryTypeIndex, owner };
+    
+    for (MemoryCategoryStats *stats : { &m_memoryStats.categories[static_cast<size_t>(category)], &m_memoryStats.total })
+    {
+        stats->bytes += size;
+        stats->allocations++;
+        stats->peakBytes = std::max(stats->peakBytes, stats->bytes);
+    }
+}
+
+void MyDevice::freeMemory(VkDeviceMemory memory)
+{
+    // The entry goes first: once freed, the driver can hand the same handle to another
+    // thread allocating at the same time, and its new entry must not be erased
+    {
+        std::lock_guard<std::mutex> lock{ m_memoryMutex };
+        
+        auto it = m_mapAllocations.find(memory);
+        if (it != m_mapAllocations.end())
+        {
+            const MemoryAllocation &allocation = it->second;
+            for (MemoryCategoryStats *stats : { &m_memoryStats.categories[static_cast<size_t>(allocation.category)], &m_memoryStats.total })
+            {
+                stats->bytes -= allocation.size;
+                stats->allocations--;
+            }
+            
+            m_mapAllocations.erase(it);
+        }
+    }
+    
+    vkFreeMemory(m_vkDevice, memory, nullptr);
+}
+
+MemoryStats MyDevice::memoryStats()
+{
+    std::lock_guard<std::mutex> lock{ m_memoryMutex };
+    return m_memoryStats;
+}
+
+std::vector<MemoryHeapBudget> MyDevice::memoryBudget()
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    
+    if (m_bMemoryBudget)
+    {
+        VkPhysicalDeviceMemoryProperties2 memProperties2 = {};
+        memProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memProperties2.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(m_vkPhysicalDevice, &memProperties2);
+        memProperties = memProperties2.memoryProperties;
+    }
+    else
+    {
+        vkGetPhysicalDeviceMemoryProperties(m_vkPhysicalDevice, &memProperties);
+        
+        // Without the extension only the allocations of this device are known
+        std::lock_guard<std::mutex> lock{ m_memoryMutex };
+        for (const auto &kv : m_mapAllocations)
+        {
+            uint32_t heapIndex = memProperties.memoryTypes[kv.second.memoryTypeIndex].heapIndex;
+            budgetProperties.heapUsage[heapIndex] += kv.second.size;
+        }
+    }
+    
+    std::vector<MemoryHeapBudget> heaps(memProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++)
+    {
+        heaps[i].size = memProperties.memoryHeaps[i].size;
+        heaps[i].budget = m_bMemoryBudget ? budgetProperties.heapBudget[i] : memProperties.memoryHeaps[i].size;
+        heaps[i].usage = budgetProperties.heapUsage[i];
+        heaps[i].deviceLocal = (memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    }
+    
+    return heaps;
+}
+
+static double toMiB(VkDeviceSize bytes)
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void MyDevice::printMemoryReport(std::ostream &out)
+{
+    MemoryStats stats = memoryStats();
+    
+    out << "Device memory (MiB)" << std::endl;
+    out << std::left << std::setw(20) << "category" << std::right
+        << std::setw(8) << "count" << std::setw(12) << "current" << std::setw(12) << "peak" << std::endl;
+    
+    out << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < stats.categories.size(); i++)
+    {
+        const MemoryCategoryStats &category = stats.categories[i];
+        if (category.peakBytes == 0)
+        {
+            continue;
+        }
+        
+        out << std::left << std::setw(20) << memoryCategoryName(static_cast<MyMemoryCategory>(i)) << std::right
+            << std::setw(8) << category.allocations << std::setw(12) << toMiB(category.bytes) << std::setw(12) << toMiB(category.peakBytes) << std::endl;
+    }
+    out << std::left << std::setw(20) << "total" << std::right
+        << std::setw(8) << stats.total.allocations << std::setw(12) << toMiB(stats.total.bytes) << std::setw(12) << toMiB(stats.total.peakBytes) << std::endl;
+    
+    std::vector<MemoryHeapBudget> heaps = memoryBudget();
+    for (size_t i = 0; i < heaps.size(); i++)
+    {
+        out << "heap " << i << (heaps[i].deviceLocal ? " (device local)" : " (host)")
+            << ": " << toMiB(heaps[i].usage) << " used of " << toMiB(heaps[i].budget) << " budget, "
+            << toMiB(heaps[i].size) << " size" << std::endl;
+    }
+    if (!m_bMemoryBudget)
+    {
+        out << "(VK_EXT_memory_budget not available, the usage only counts this device's allocations)" << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+void MyDevice::_printLeakReport()
+{
+    std::lock_guard<std::mutex> lock{ m_memoryMutex };
+    
+    if (m_mapAllocations.empty())
+    {
+        return;
+    }
+    
+    std::cerr << "Device memory leak: " << m_mapAllocations.size() << " allocations ("
+              << m_memoryStats.total.bytes << " bytes) were never freed" << std::endl;
+    for (const auto &kv : m_mapAllocations)
+    {
+        const MemoryAllocation &allocation = kv.second;
+        std::cerr << "  " << allocation.owner << ": " << memoryCategoryName(allocation.category) << ", "
+                  << allocation.size << " bytes, memory type " << allocation.memoryTypeIndex << std::endl;
+    }
+}
@@ -4,7 +4,11 @@
 #include "my_window.h"
 
 // std lib headers
+#include <array>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -24,6 +28,42 @@ struct QueueFamilyIndices
     bool     isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 };
 
+// What a device memory allocation is used for, derived from the buffer or image usage
+enum class MyMemoryCategory
+{
+    Vertex,
+    Index,
+    Uniform,
+    Staging,
+    Depth,
+    ColorAttachment,
+    Other,
+    Count
+};
+
+const char* memoryCategoryName(MyMemoryCategory category);
+
+struct MemoryCategoryStats
+{
+    VkDeviceSize bytes = 0;
+    VkDeviceSize peakBytes = 0;   // high-water mark
+    uint32_t     allocations = 0;
+};
+
+struct MemoryStats
+{
+    std::array<MemoryCategoryStats, static_cast<size_t>(MyMemoryCategory::Count)> categories;
+    MemoryCategoryStats                                                           total;
+};
+
+struct MemoryHeapBudget
+{
+    VkDeviceSize size;
+    VkDeviceSize budget;          // heap size without VK_EXT_memory_budget
+    VkDeviceSize usage;           // of the whole process, only what this device allocated without VK_EXT_memory_budget
+    bool         deviceLocal;
+};
+
 class MyDevice 
 {
   public:
@@ -45,9 +85,26 @@ class MyDevice
     VkCommandPool commandPool() { return m_vkCommandPool; }
     VkDevice device()           { return m_vkDevice; }
     VkSurfaceKHR surface()      { return m_vkSurface; }
+    bool isHeadless() const     { return m_myWindow.isHeadless(); }
     VkQueue graphicsQueue()     { return m_vkGraphicsQueue; }
     VkQueue presentQueue()      { return m_vkPresentQueue; }
 
+    // Shared by all the pipelines, loaded from and saved to PIPELINE_CACHE_FILE
+    VkPipelineCache pipelineCache() { return m_vkPipelineCache; }
+
+    // Properties of the picked physical device
+    const VkPhysicalDeviceProperties& properties() const { return m_vkProperties; }
+    
+    // Number of meaningful bits in the timestamps written on the graphics queue, 0 if not supported
+    uint32_t timestampValidBits();
+
+    // VK_EXT_extended_dynamic_state, only enabled when the GPU supports it
+    bool hasExtendedDynamicState() const { return m_bExtendedDynamicState; }
+    void cmdSetPrimitiveTopology(VkCommandBuffer commandBuffer, VkPrimitiveTopology topology);
+
+    // Vulkan 1.2 timeline semaphores, only enabled when the GPU supports them
+    bool hasTimelineSemaphore() const { return m_bTimelineSemaphore; }
+
     // Used by Swap Chain
     SwapChainSupportDetails getSwapChainSupport()  { return _querySwapChainSupport(m_vkPhysicalDevice); }
     QueueFamilyIndices findPhysicalQueueFamilies() { return _findQueueFamilies(m_vkPhysicalDevice); }
@@ -57,11 +114,13 @@ class MyDevice
     VkCommandBuffer beginSingleTimeCommands();
     void endSingleTimeCommands(VkCommandBuffer commandBuffer);
     
+    // The owner name shows up in the memory report and the leak report
     void createImageWithInfo(
         const VkImageCreateInfo &imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage &image,
-        VkDeviceMemory &imageMemory);
+        VkDeviceMemory &imageMemory,
+        const std::string &owner = "unnamed");
     
     // Buffer Helper Functions
     void createBuffer(
@@ -69,9 +128,21 @@ class MyDevice
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer &buffer,
-        VkDeviceMemory &bufferMemory);
+        VkDeviceMemory &bufferMemory,
+        const std::string &owner = "unnamed");
     
 	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+
+	// Partial update of a buffer the frames in flight may be reading as vertices or indices
+	void copyBufferRegions(VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy>& regions);
+
+    // Memory accounting. Memory allocated by createBuffer or createImageWithInfo
+    // must be released with freeMemory, which is vkFreeMemory plus the bookkeeping
+    void freeMemory(VkDeviceMemory memory);
+    MemoryStats memoryStats();
+    std::vector<MemoryHeapBudget> memoryBudget();
+    bool hasMemoryBudget() const { return m_bMemoryBudget; }
+    void printMemoryReport(std::ostream &out);
 	
   private:
     void _createInstance();
@@ -80,21 +151,31 @@ class MyDevice
     void _createSurface();
     void _createLogicalDevice();
     void _createCommandPool();
+    void _createPipelineCache();
+    void _savePipelineCache();
     uint32_t _findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    void _trackAllocation(VkDeviceMemory memory, MyMemoryCategory category, VkDeviceSize size, uint32_t memoryTypeIndex, const std::string &owner);
+    void _printLeakReport();
     
     // helper functions
     bool _isDeviceSuitable(VkPhysicalDevice device);
+    std::vector<char> _loadPipelineCacheData();
     std::vector<const char *> _getRequiredExtensions();
     bool _checkValidationLayerSupport();
     QueueFamilyIndices _findQueueFamilies(VkPhysicalDevice device);
     void _populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
     void _hasGflwRequiredInstanceExtensions();
     bool _checkDeviceExtensionSupport(VkPhysicalDevice device);
+    std::vector<const char *> _requiredDeviceExtensions();
+    bool _checkExtendedDynamicStateSupport(VkPhysicalDevice device);
+    bool _checkMemoryBudgetSupport(VkPhysicalDevice device);
+    bool _checkTimelineSemaphoreSupport(VkPhysicalDevice device);
     SwapChainSupportDetails _querySwapChainSupport(VkPhysicalDevice device);
 	
     VkInstance                 m_vkInstance;
     VkDebugUtilsMessengerEXT   m_vkDebugMessenger;
     VkPhysicalDevice           m_vkPhysicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties m_vkProperties = {};
 
     MyWindow                  &m_myWindow;
     VkCommandPool              m_vkCommandPool;
@@ -103,9 +184,30 @@ class MyDevice
     VkSurfaceKHR               m_vkSurface;
     VkQueue                    m_vkGraphicsQueue;
     VkQueue                    m_vkPresentQueue;
+    VkPipelineCache            m_vkPipelineCache = VK_NULL_HANDLE;
+
+    bool                       m_bExtendedDynamicState = false;
+    PFN_vkCmdSetPrimitiveTopologyEXT m_pfnCmdSetPrimitiveTopology = nullptr;
+
+    bool                       m_bTimelineSemaphore = false;
+
+    struct MemoryAllocation
+    {
+        MyMemoryCategory category;
+        VkDeviceSize     size;
+        uint32_t         memoryTypeIndex;
+        std::string      owner;
+    };
+
+    // VK_EXT_memory_budget, only enabled when the GPU supports it
+    bool                       m_bMemoryBudget = false;
+    std::mutex                 m_memoryMutex;  // guards the allocations and the stats
+    std::unordered_map<VkDeviceMemory, MemoryAllocation> m_mapAllocations;
+    MemoryStats                m_memoryStats;
     
     const std::vector<const char *> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-    const std::vector<const char *> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    const std::vector<const char *> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME }; // not needed when headless
+    const std::string               PIPELINE_CACHE_FILE = "pipeline_cache.bin";
 };
 
 #endif
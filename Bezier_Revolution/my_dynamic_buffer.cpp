@@ -0,0 +1,109 @@
+#include "my_dynamic_buffer.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+MyDynamicBuffer::MyDynamicBuffer(
+	MyDevice& device,
+	MyRenderer& renderer,
+	VkDeviceSize instanceSize,
+	uint32_t initialCapacity,
+	VkBufferUsageFlags usageFlags,
+	uint32_t slotCount,
+	const std::string& owner) :
+	m_myDevice{ device },
+	m_myRenderer{ renderer },
+	m_vkInstanceSize{ instanceSize },
+	m_vkUsageFlags{ usageFlags },
+	m_sOwner{ owner },
+	m_vSlots(slotCount)
+{
+	assert(slotCount > 0 && slotCount < 32 && "Dynamic buffer needs between 1 and 31 slots");
+
+	_allocate(std::max(initialCapacity, 1u));
+}
+
+void MyDynamicBuffer::_allocate(uint32_t capacity)
+{
+	// A prepared slot may still be read by a frame in flight. The renderer frees the old
+	// buffer from beginFrame, so it does not wait for this buffer to be prepared again
+	if (m_pMyBuffer && m_iPreparedSlots != 0)
+	{
+		m_myRenderer.releaseAfterFrames(std::shared_ptr<MyBuffer>(std::move(m_pMyBuffer)));
+	}
+	m_iPreparedSlots = 0;
+
+	// Each slot is one instance of the underlying buffer, so its offset is aligned
+	// for a later flush of a non-coherent memory range
+	m_pMyBuffer = std::make_unique<MyBuffer>(
+		m_myDevice,
+		m_vkInstanceSize * capacity,
+		static_cast<uint32_t>(m_vSlots.size()),
+		m_vkUsageFlags,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_myDevice.properties().limits.nonCoherentAtomSize,
+		m_sOwner);
+	m_vkSlotSize = m_pMyBuffer->instanceAlignmentSize();
+	m_iCapacity = capacity;
+
+	m_pMyBuffer->map();
+}
+
+void MyDynamicBuffer::write(const void* data, uint32_t instanceCount)
+{
+	if (instanceCount > m_iCapacity)
+	{
+		// Doubling keeps the cost of a steadily growing count amortized O(1) per instance
+		_allocate(std::max(instanceCount, m_iCapacity * 2));
+	}
+
+	const char* bytes = static_cast<const char*>(data);
+	m_vData.assign(bytes, bytes + static_cast<size_t>(m_vkInstanceSize * instanceCount));
+	m_iInstanceCount = instanceCount;
+	m_iVersion++;
+
+	// Every slot, including the empty ones of a grown buffer, needs all of it
+	for (auto& slot : m_vSlots)
+	{
+		slot.dirtyRanges.clear();
+		slot.dirtyRanges.add(0, m_vData.size());
+	}
+}
+
+void MyDynamicBuffer::writeRange(const void* data, uint32_t first, uint32_t count)
+{
+	assert(first + count <= m_iInstanceCount && "Range is outside of the last write");
+
+	VkDeviceSize offset = m_vkInstanceSize * first;
+	VkDeviceSize size = m_vkInstanceSize * count;
+	memcpy(m_vData.data() + offset, data, static_cast<size_t>(size));
+	m_iVersion++;
+
+	for (auto& slot : m_vSlots)
+	{
+		slot.dirtyRanges.add(offset, size);
+	}
+}
+
+void MyDynamicBuffer::prepareSlot(int frameIndex)
+{
+	m_iPreparedSlots |= 1u << frameIndex;
+
+	Slot& slot = m_vSlots[frameIndex];
+	if (slot.version == m_iVersion)
+	{
+		return;
+	}
+
+	for (auto& range : slot.dirtyRanges.ranges())
+	{
+		m_pMyBuffer->writeRange(m_vData.data() + range.offset, range.size, slotOffset(frameIndex) + range.offset);
+	}
+	slot.dirtyRanges.clear();
+	m_pMyBuffer->flushDirtyRanges();
+
+	slot.version = m_iVersion;
+	slot.instanceCount = m_iInstanceCount;
+}
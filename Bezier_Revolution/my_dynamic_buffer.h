@@ -0,0 +1,83 @@
+#ifndef __MY_DYNAMIC_BUFFER_H__
+#define __MY_DYNAMIC_BUFFER_H__
+
+#include "my_buffer.h"
+#include "my_device.h"
+#include "my_renderer.h"
+#include "my_swap_chain.h"
+
+// std
+#include <memory>
+#include <string>
+#include <vector>
+
+//
+// A host visible buffer the CPU updates while the GPU may still read it. There is one slot
+// per frame in flight, and a write only goes into the slot of the frame being recorded, whose
+// previous frame has already been waited for. The other slots catch up when their frame comes around,
+// so a write never races the GPU and never needs a vkDeviceWaitIdle.
+// A write over the capacity reallocates at twice the size, the old buffer goes to
+// MyRenderer::releaseAfterFrames, which frees it once every frame that could still read it
+// is complete, whether or not the buffer is used again
+//
+class MyDynamicBuffer
+{
+public:
+	MyDynamicBuffer(
+		MyDevice& device,
+		MyRenderer& renderer,
+		VkDeviceSize instanceSize,
+		uint32_t initialCapacity,
+		VkBufferUsageFlags usageFlags,
+		uint32_t slotCount = MySwapChain::MAX_FRAMES_IN_FLIGHT,
+		const std::string& owner = "MyDynamicBuffer");
+
+	MyDynamicBuffer(const MyDynamicBuffer&) = delete;
+	MyDynamicBuffer& operator=(const MyDynamicBuffer&) = delete;
+
+	// Keeps a copy of the first instanceCount instances, growing the buffer if needed.
+	// Nothing is written to the GPU until prepareSlot, so it must not be called between
+	// the prepareSlot of a frame and the recording of that frame
+	void         write(const void* data, uint32_t instanceCount);
+
+	// Replaces instances [first, first + count) of the last write, only those bytes
+	// are copied into each slot
+	void         writeRange(const void* data, uint32_t first, uint32_t count);
+
+	// Copy the latest write into the slot of frameIndex if it has not seen it yet. Must be called
+	// after the frame that last used frameIndex was waited for and before the slot is recorded
+	void         prepareSlot(int frameIndex);
+
+	VkBuffer     buffer()                     const { return m_pMyBuffer->buffer(); }
+	VkDeviceSize slotOffset(int frameIndex)   const { return m_vkSlotSize * frameIndex; }
+	uint32_t     instanceCount(int frameIndex) const { return m_vSlots[frameIndex].instanceCount; }
+	uint32_t     capacity()                   const { return m_iCapacity; }
+
+private:
+	struct Slot
+	{
+		uint64_t      version = 0;
+		uint32_t      instanceCount = 0;
+		MyDirtyRanges dirtyRanges;     // bytes of m_vData the slot has not seen yet
+	};
+
+	void _allocate(uint32_t capacity);
+
+	MyDevice&                  m_myDevice;
+	MyRenderer&                m_myRenderer;
+	VkDeviceSize               m_vkInstanceSize;
+	VkBufferUsageFlags         m_vkUsageFlags;
+	std::string                m_sOwner;
+	uint32_t                   m_iCapacity = 0;
+	VkDeviceSize               m_vkSlotSize = 0;
+
+	std::unique_ptr<MyBuffer>  m_pMyBuffer;          // all the slots, persistently mapped
+	std::vector<Slot>          m_vSlots;
+	uint32_t                   m_iPreparedSlots = 0; // bit i is set once slot i was prepared with the current buffer
+
+	std::vector<char>          m_vData;              // latest write, only the used bytes
+	uint32_t                   m_iInstanceCount = 0;
+	uint64_t                   m_iVersion = 0;
+};
+
+#endif
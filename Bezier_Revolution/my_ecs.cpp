@@ -0,0 +1,273 @@
+#include "my_ecs.h"
+
+// std
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+//
+// MyComponentRegistry
+//
+
+static std::mutex& componentRegistryMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+// Only appended to, an entry never changes once its id was handed out
+static MyComponentRegistry::Info s_componentInfos[MyComponentRegistry::MAX_COMPONENT_TYPES];
+static uint32_t                  s_iComponentCount = 0;
+
+MyComponentID MyComponentRegistry::_register(const Info& info)
+{
+	// Component types are registered from whichever thread uses them first
+	std::lock_guard<std::mutex> lock{ componentRegistryMutex() };
+
+	if (s_iComponentCount >= MAX_COMPONENT_TYPES)
+	{
+		throw std::runtime_error("too many component types!");
+	}
+	if (info.alignment > alignof(std::max_align_t))
+	{
+		throw std::runtime_error("component alignment is not supported!");
+	}
+
+	s_componentInfos[s_iComponentCount] = info;
+	return s_iComponentCount++;
+}
+
+const MyComponentRegistry::Info& MyComponentRegistry::info(MyComponentID id)
+{
+	// Whoever has the id got it after the entry was written, no lock needed
+	assert(id < MAX_COMPONENT_TYPES && "Unknown component id");
+	return s_componentInfos[id];
+}
+
+//
+// MyArchetype
+//
+
+static size_t alignUp(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+MyArchetype::MyArchetype(MyComponentMask mask) :
+	m_iMask{ mask },
+	m_vOffsets(MyComponentRegistry::MAX_COMPONENT_TYPES, 0)
+{
+	size_t rowSize = sizeof(MyEntity);
+	size_t padding = 0;
+	for (MyComponentID id = 0; id < MyComponentRegistry::MAX_COMPONENT_TYPES; id++)
+	{
+		if (has(id))
+		{
+			const MyComponentRegistry::Info& info = MyComponentRegistry::info(id);
+			m_vComponentIDs.push_back(id);
+			rowSize += info.size;
+			padding += info.alignment;
+		}
+	}
+
+	size_t usable = padding < CHUNK_SIZE ? CHUNK_SIZE - padding : 0;
+	m_iRowsPerChunk = static_cast<uint32_t>(std::max<size_t>(1, usable / rowSize));
+
+	// The entity handles first, then one array per component
+	size_t offset = sizeof(MyEntity) * m_iRowsPerChunk;
+	for (MyComponentID id : m_vComponentIDs)
+	{
+		const MyComponentRegistry::Info& info = MyComponentRegistry::info(id);
+		offset = alignUp(offset, info.alignment);
+		m_vOffsets[id] = offset;
+		offset += info.size * m_iRowsPerChunk;
+	}
+	m_iChunkBytes = offset;
+}
+
+MyArchetype::~MyArchetype()
+{
+	for (uint32_t chunk = 0; chunk < chunkCount(); chunk++)
+	{
+		for (MyComponentID id : m_vComponentIDs)
+		{
+			const MyComponentRegistry::Info& info = MyComponentRegistry::info(id);
+			for (uint32_t row = 0; row < m_vChunks[chunk].count; row++)
+			{
+				info.destroy(component(id, chunk, row));
+			}
+		}
+	}
+}
+
+void* MyArchetype::component(MyComponentID id, uint32_t chunk, uint32_t row)
+{
+	assert(has(id) && "Archetype does not have the component");
+	assert(row < m_vChunks[chunk].count && "Row is out of range");
+
+	unsigned char* pData = reinterpret_cast<unsigned char*>(m_vChunks[chunk].pData.get());
+	return pData + m_vOffsets[id] + MyComponentRegistry::info(id).size * row;
+}
+
+void MyArchetype::allocateRow(MyEntity entity, uint32_t& chunk, uint32_t& row)
+{
+	if (m_vChunks.empty() || m_vChunks.back().count == m_iRowsPerChunk)
+	{
+		Chunk newChunk;
+		size_t elementCount = (m_iChunkBytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+		newChunk.pData = std::make_unique<std::max_align_t[]>(elementCount);
+		m_vChunks.push_back(std::move(newChunk));
+	}
+
+	chunk = chunkCount() - 1;
+	row = m_vChunks[chunk].count++;
+	entities(chunk)[row] = entity;
+}
+
+MyEntity MyArchetype::removeRow(uint32_t chunk, uint32_t row)
+{
+	uint32_t lastChunk = chunkCount() - 1;
+	uint32_t lastRow = m_vChunks[lastChunk].count - 1;
+	bool     bLast = chunk == lastChunk && row == lastRow;
+
+	for (MyComponentID id : m_vComponentIDs)
+	{
+		const MyComponentRegistry::Info& info = MyComponentRegistry::info(id);
+		void* pRemoved = component(id, chunk, row);
+		info.destroy(pRemoved);
+
+		if (!bLast)
+		{
+			void* pLast = component(id, lastChunk, lastRow);
+			info.moveConstruct(pRemoved, pLast);
+			info.destroy(pLast);
+		}
+	}
+
+	MyEntity moved{};
+	if (!bLast)
+	{
+		moved = entities(lastChunk)[lastRow];
+		entities(chunk)[row] = moved;
+	}
+
+	if (--m_vChunks[lastChunk].count == 0)
+	{
+		m_vChunks.pop_back();
+	}
+	return moved;
+}
+
+//
+// MyWorld
+//
+
+bool MyWorld::isAlive(MyEntity entity) const
+{
+	return m_myEntities.contains(entity);
+}
+
+MyArchetype* MyWorld::_archetype(MyComponentMask mask)
+{
+	auto it = m_mapArchetypes.find(mask);
+	if (it != m_mapArchetypes.end())
+	{
+		return it->second;
+	}
+
+	m_vArchetypes.push_back(std::make_unique<MyArchetype>(mask));
+	MyArchetype* pArchetype = m_vArchetypes.back().get();
+	m_mapArchetypes[mask] = pArchetype;
+	return pArchetype;
+}
+
+void MyWorld::_removeRow(MyArchetype& archetype, uint32_t chunk, uint32_t row)
+{
+	MyEntity moved = archetype.removeRow(chunk, row);
+	if (moved.isValid())
+	{
+		EntityRecord* pRecord = m_myEntities.get(moved);
+		pRecord->chunk = chunk;
+		pRecord->row = row;
+	}
+}
+
+void MyWorld::destroy(MyEntity entity)
+{
+	assert(!m_bIterating && "Entities cannot be destroyed inside each()");
+	if (!isAlive(entity))
+	{
+		return;
+	}
+
+	const EntityRecord& record = _record(entity);
+	_removeRow(*record.pArchetype, record.chunk, record.row);
+
+	if (record.name != MyNameTable::INVALID_NAME)
+	{
+		m_mapNamedEntities.erase(record.name);
+	}
+
+	// The old handles no longer match
+	m_myEntities.remove(entity);
+}
+
+void MyWorld::setName(MyEntity entity, MyNameID name)
+{
+	assert(isAlive(entity) && "Entity was destroyed");
+	EntityRecord& record = *m_myEntities.get(entity);
+
+	if (record.name != MyNameTable::INVALID_NAME)
+	{
+		m_mapNamedEntities.erase(record.name);
+	}
+
+	// The previous owner of the name loses it
+	auto it = m_mapNamedEntities.find(name);
+	if (it != m_mapNamedEntities.end())
+	{
+		m_myEntities.get(it->second)->name = MyNameTable::INVALID_NAME;
+	}
+
+	record.name = name;
+	if (name != MyNameTable::INVALID_NAME)
+	{
+		m_mapNamedEntities[name] = entity;
+	}
+}
+
+MyEntity MyWorld::find(MyNameID name) const
+{
+	auto it = m_mapNamedEntities.find(name);
+	return it != m_mapNamedEntities.end() ? it->second : MyEntity{};
+}
+
+const MyWorld::EntityRecord& MyWorld::_moveToArchetype(MyEntity entity, MyComponentMask mask)
+{
+	assert(!m_bIterating && "Components cannot be added or removed inside each()");
+	assert(isAlive(entity) && "Entity was destroyed");
+
+	EntityRecord& record = *m_myEntities.get(entity);
+	MyArchetype* pSource = record.pArchetype;
+	MyArchetype* pTarget = _archetype(mask);
+
+	uint32_t chunk, row;
+	pTarget->allocateRow(entity, chunk, row);
+	for (MyComponentID id : pTarget->componentIDs())
+	{
+		if (pSource->has(id))
+		{
+			MyComponentRegistry::info(id).moveConstruct(
+				pTarget->component(id, chunk, row),
+				pSource->component(id, record.chunk, record.row));
+		}
+	}
+
+	// Destroys the moved-from components and the ones the target does not have
+	_removeRow(*pSource, record.chunk, record.row);
+
+	record.pArchetype = pTarget;
+	record.chunk = chunk;
+	record.row = row;
+	return record;
+}
@@ -2,6 +2,7 @@
 #define __MY_FRAMEINFO_H__
 
 #include "my_camera.h"
+#include "my_render_queue.h"
 
 // lib
 #include <vulkan/vulkan.h>
@@ -13,6 +14,8 @@ struct MyFrameInfo
 	VkCommandBuffer commandBuffer;
 	MyCamera&       camera;
 	glm::vec3       color;
+	MyRenderQueue&  renderQueue; // render systems submit draw packets here instead of recording directly
+	uint32_t        pass;        // draw order of the packets submitted by the current render system
 };
 
 #endif
@@ -5,7 +5,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
+#include <atomic>
 #include <memory>
+#include <string>
 
 struct TransformComponent
 {
@@ -72,14 +74,42 @@ struct TransformComponent
 	}
 };
 
+//
+// Components of the entities in MyWorld, each system only iterates the ones it needs
+//
+struct ModelComponent
+{
+	std::shared_ptr<MyModel> model{};   // nullptr until there is something to draw
+};
+
+// Drawn by MyPointLineRenderSystem, the kind selects the pass it is drawn in
+struct PointLineComponent
+{
+	enum Kind
+	{
+		CONTROL_POINTS,
+		CENTER_LINE,
+		BEZIER_CURVE,
+		SURFACE_NORMALS
+	};
+
+	Kind kind;
+};
+
+// Drawn by MySimpleRenderSystem
+struct SurfaceComponent
+{
+};
+
 class MyGameObject
 {
 public:
 	using id_t = unsigned int;
 
+	// Can be called from any thread
 	static MyGameObject createGameObject(std::string name)
 	{
-		static id_t currentID = 0;
+		static std::atomic<id_t> currentID{ 0 };
 		return MyGameObject{ currentID++, name };
 	}
 
@@ -92,7 +122,7 @@ public:
 	std::shared_ptr<MyModel> model{};
 	glm::vec3                color{};
 	TransformComponent       transform{};
-	std::string              name() const { return m_sName; }
+	const std::string&       name() const { return m_sName; }
 
 private:
 	MyGameObject(id_t objID, std::string name) : m_iID{ objID }, m_sName{ name } {}
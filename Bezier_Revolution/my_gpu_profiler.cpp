@@ -0,0 +1,233 @@
+#include "my_gpu_profiler.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+MyGpuProfiler::MyGpuProfiler(MyDevice& device) :
+	m_myDevice{ device }
+{
+	const auto& limits = m_myDevice.properties().limits;
+	uint32_t validBits = m_myDevice.timestampValidBits();
+
+	m_bSupported = limits.timestampComputeAndGraphics == VK_TRUE && validBits > 0;
+	if (!m_bSupported)
+	{
+		std::cout << "GPU profiler: timestamps are not supported on the graphics queue" << std::endl;
+		return;
+	}
+
+	m_fTimestampPeriod = limits.timestampPeriod;
+	m_iTimestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+	m_vFrames.resize(MySwapChain::MAX_FRAMES_IN_FLIGHT);
+	for (auto& frame : m_vFrames)
+	{
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = MAX_SCOPES_PER_FRAME * 2;
+
+		if (vkCreateQueryPool(m_myDevice.device(), &queryPoolInfo, nullptr, &frame.queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create timestamp query pool!");
+		}
+
+		// Allocated once, recording and reading back the scopes of a frame never allocate
+		frame.vScopeNames.reserve(MAX_SCOPES_PER_FRAME);
+		frame.vTimestamps.resize(MAX_SCOPES_PER_FRAME * 2);
+	}
+}
+
+MyGpuProfiler::~MyGpuProfiler()
+{
+	for (auto& frame : m_vFrames)
+	{
+		vkDestroyQueryPool(m_myDevice.device(), frame.queryPool, nullptr);
+	}
+}
+
+void MyGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex)
+{
+	if (!m_bSupported)
+	{
+		return;
+	}
+
+	m_iCurrentFrame = frameIndex;
+	FrameQueries& frame = m_vFrames[frameIndex];
+
+	// The frame that last used this frame index has been waited for,
+	// so the queries it wrote are complete
+	_readResults(frame);
+
+	vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0, MAX_SCOPES_PER_FRAME * 2);
+	frame.vScopeNames.clear();
+}
+
+uint32_t MyGpuProfiler::beginScope(VkCommandBuffer commandBuffer, MyNameID name)
+{
+	if (!m_bSupported || m_iCurrentFrame < 0)
+	{
+		return INVALID_SCOPE;
+	}
+
+	FrameQueries& frame = m_vFrames[m_iCurrentFrame];
+	if (frame.vScopeNames.size() >= MAX_SCOPES_PER_FRAME)
+	{
+		return INVALID_SCOPE;
+	}
+
+	uint32_t scope = static_cast<uint32_t>(frame.vScopeNames.size());
+	frame.vScopeNames.push_back(name);
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, scope * 2);
+	return scope;
+}
+
+void MyGpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+	if (scope == INVALID_SCOPE)
+	{
+		return;
+	}
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vFrames[m_iCurrentFrame].queryPool, scope * 2 + 1);
+}
+
+void MyGpuProfiler::_readResults(FrameQueries& frame)
+{
+	if (frame.vScopeNames.empty())
+	{
+		return;
+	}
+
+	uint32_t queryCount = static_cast<uint32_t>(frame.vScopeNames.size()) * 2;
+	std::vector<uint64_t>& timestamps = frame.vTimestamps;
+
+	// No VK_QUERY_RESULT_WAIT_BIT. A scope that was never ended leaves its query
+	// unavailable, and the whole frame is dropped instead of waiting for it
+	VkResult result = vkGetQueryPoolResults(
+		m_myDevice.device(),
+		frame.queryPool,
+		0,
+		queryCount,
+		queryCount * sizeof(uint64_t),
+		timestamps.data(),
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < frame.vScopeNames.size(); i++)
+	{
+		uint64_t ticks = (timestamps[i * 2 + 1] - timestamps[i * 2]) & m_iTimestampMask;
+		float ms = static_cast<float>(static_cast<double>(ticks) * m_fTimestampPeriod / 1000000.0);
+		_addSample(frame.vScopeNames[i], ms);
+	}
+}
+
+void MyGpuProfiler::_addSample(MyNameID name, float ms)
+{
+	auto it = m_mapScopeIndices.find(name);
+	if (it == m_mapScopeIndices.end())
+	{
+		it = m_mapScopeIndices.emplace(name, m_vScopes.size()).first;
+		m_vScopes.push_back(ScopeHistory{ name, {}, 0 });
+		m_vScopes.back().vSamplesMs.reserve(HISTORY_SIZE);
+	}
+
+	ScopeHistory& scope = m_vScopes[it->second];
+	if (scope.vSamplesMs.size() < HISTORY_SIZE)
+	{
+		scope.vSamplesMs.push_back(ms);
+	}
+	else
+	{
+		scope.vSamplesMs[scope.nextSample] = ms;
+	}
+	scope.nextSample = (scope.nextSample + 1) % HISTORY_SIZE;
+}
+
+std::vector<MyGpuProfiler::ScopeStats> MyGpuProfiler::stats() const
+{
+	std::vector<ScopeStats> result;
+	result.reserve(m_vScopes.size());
+
+	std::vector<float> sorted;
+	for (const auto& scope : m_vScopes)
+	{
+		ScopeStats scopeStats{};
+		scopeStats.name = MyNameTable::instance().name(scope.name);
+		scopeStats.samples = static_cast<uint32_t>(scope.vSamplesMs.size());
+
+		if (!scope.vSamplesMs.empty())
+		{
+			sorted = scope.vSamplesMs;
+			std::sort(sorted.begin(), sorted.end());
+
+			float sum = 0.0f;
+			for (float ms : sorted)
+			{
+				sum += ms;
+			}
+
+			size_t p99Index = static_cast<size_t>(std::ceil(0.99 * sorted.size())) - 1;
+
+			scopeStats.minMs = sorted.front();
+			scopeStats.avgMs = sum / sorted.size();
+			scopeStats.p99Ms = sorted[p99Index];
+		}
+
+		result.push_back(scopeStats);
+	}
+
+	return result;
+}
+
+void MyGpuProfiler::printStats(std::ostream& out) const
+{
+	if (!m_bSupported)
+	{
+		out << "GPU profiler: not supported" << std::endl;
+		return;
+	}
+
+	out << "GPU time over the last " << HISTORY_SIZE << " frames (ms)" << std::endl;
+	out << std::left << std::setw(24) << "scope" << std::right
+		<< std::setw(10) << "min" << std::setw(10) << "avg" << std::setw(10) << "p99" << std::endl;
+
+	out << std::fixed << std::setprecision(3);
+	for (const auto& scope : stats())
+	{
+		out << std::left << std::setw(24) << scope.name << std::right
+			<< std::setw(10) << scope.minMs << std::setw(10) << scope.avgMs << std::setw(10) << scope.p99Ms << std::endl;
+	}
+	out << std::defaultfloat;
+}
+
+void MyGpuProfiler::writeCsv(const std::string& filepath) const
+{
+	std::ofstream file{ filepath };
+	if (!file.is_open())
+	{
+		std::cout << "failed to open file: " << filepath << std::endl;
+		return;
+	}
+
+	file << "scope,samples,min_ms,avg_ms,p99_ms\n";
+	for (const auto& scope : stats())
+	{
+		file << scope.name << ',' << scope.samples << ','
+			<< scope.minMs << ',' << scope.avgMs << ',' << scope.p99Ms << '\n';
+	}
+
+	std::cout << "GPU profile written to " << filepath << std::endl;
+}
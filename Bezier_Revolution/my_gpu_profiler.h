@@ -0,0 +1,94 @@
+#ifndef __MY_GPU_PROFILER_H__
+#define __MY_GPU_PROFILER_H__
+
+#include "my_device.h"
+#include "my_name_table.h"
+#include "my_swap_chain.h"
+
+// std
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// Measure GPU time with timestamp queries. Each frame in flight has its own query pool,
+// and the results of a pool are read when the same frame index comes back, after the
+// renderer has waited for the frame that last used it, so reading them never stalls
+//
+class MyGpuProfiler
+{
+public:
+	// Two queries per scope
+	static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+
+	// Number of frames the min/avg/p99 of a scope are computed over
+	static constexpr uint32_t HISTORY_SIZE = 256;
+
+	// Returned by beginScope when nothing is written, endScope ignores it
+	static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+	struct ScopeStats
+	{
+		std::string name;
+		uint32_t    samples = 0;
+		float       minMs = 0.0f;
+		float       avgMs = 0.0f;
+		float       p99Ms = 0.0f;
+	};
+
+	MyGpuProfiler(MyDevice& device);
+	~MyGpuProfiler();
+
+	MyGpuProfiler(const MyGpuProfiler&) = delete;
+	MyGpuProfiler& operator=(const MyGpuProfiler&) = delete;
+
+	bool     isSupported() const { return m_bSupported; }
+
+	// Must be called outside of a render pass, right after MyRenderer::beginFrame
+	void     beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+	// Scopes may nest. Inside a render pass recorded with secondary command buffers
+	// the timestamps have to be written into the secondary command buffers instead.
+	// The name is interned up front, so a scope never allocates or hashes a string
+	uint32_t beginScope(VkCommandBuffer commandBuffer, MyNameID name);
+	void     endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+	// In the order the scopes were first seen
+	std::vector<ScopeStats> stats() const;
+
+	void     printStats(std::ostream& out) const;
+	void     writeCsv(const std::string& filepath) const;
+
+private:
+	struct FrameQueries
+	{
+		VkQueryPool              queryPool = VK_NULL_HANDLE;
+		std::vector<MyNameID>    vScopeNames;   // scope i uses the queries 2i and 2i+1
+		std::vector<uint64_t>    vTimestamps;   // read back into, sized for MAX_SCOPES_PER_FRAME
+	};
+
+	struct ScopeHistory
+	{
+		MyNameID           name;
+		std::vector<float> vSamplesMs;          // ring buffer of HISTORY_SIZE samples
+		uint32_t           nextSample = 0;
+	};
+
+	void _readResults(FrameQueries& frame);
+	void _addSample(MyNameID name, float ms);
+
+	MyDevice&                               m_myDevice;
+	bool                                    m_bSupported = false;
+	float                                   m_fTimestampPeriod = 1.0f; // nanoseconds per tick
+	uint64_t                                m_iTimestampMask = ~0ull;
+
+	std::vector<FrameQueries>               m_vFrames;
+	int                                     m_iCurrentFrame = -1;
+
+	std::vector<ScopeHistory>               m_vScopes;
+	std::unordered_map<MyNameID, size_t>    m_mapScopeIndices;
+};
+
+#endif
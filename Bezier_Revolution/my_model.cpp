@@ -1,5 +1,6 @@
 #include "my_model.h"
 #include "my_utils.h"
+#include "my_tracer.h"
 
 // libs
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -8,8 +9,10 @@
 #include <glm/gtx/hash.hpp>
 
 // std
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <string>
 #include <unordered_map>
 
 namespace std {
@@ -39,24 +42,21 @@ MyModel::MyModel(MyDevice& device, const MyModel::Builder& builder) :
 	_createIndexBuffers(builder.indices);
 }
 
-// For dynamic data update to pre-allocate a big memory in GPU
-MyModel::MyModel(MyDevice& device, const int maxVertices) :
+// For dynamic data update, the buffer starts at the given capacity and grows on demand
+MyModel::MyModel(MyDevice& device, MyRenderer& renderer, const int initialVertexCapacity) :
 	m_myDevice{ device },
-	m_iVertexCount{ 0 },
-	m_iMaxVertexCount{ (uint32_t)maxVertices }
+	m_iVertexCount{ 0 }
 {
-	// This for points and lines to allocate big memory in GPU side
+	// This for points and lines to allocate memory in GPU side
 	// and fill up the data later
-	VkDeviceSize maxbufferSize = sizeof(PointLine) * m_iMaxVertexCount;
-
-	m_pMyVertexBuffer = std::make_unique<MyBuffer>(
+	m_pMyDynamicVertexBuffer = std::make_unique<MyDynamicBuffer>(
 		m_myDevice,
+		renderer,
 		sizeof(PointLine),
-		m_iMaxVertexCount,
+		(uint32_t)initialVertexCapacity,
 		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	m_pMyVertexBuffer->map();
+		MySwapChain::MAX_FRAMES_IN_FLIGHT,
+		"model " + std::to_string(m_iID) + " points/lines");
 }
 
 MyModel::~MyModel()
@@ -64,6 +64,13 @@ MyModel::~MyModel()
   // Uniquie pointer will remove the buffer memory automatically
 }
 
+uint32_t MyModel::_nextID()
+{
+	// Models can be created on loader threads
+	static std::atomic<uint32_t> currentID{ 0 };
+	return currentID++;
+}
+
 std::unique_ptr<MyModel> MyModel::createModelFromFile(
 	MyDevice& device, const std::string& filepath) 
 {
@@ -98,6 +105,8 @@ void MyModel::_createVertexBuffer(const std::vector<Vertex>& vertices, bool bUse
 	  m_iVertexCount, // number of instances
 	  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 	  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	  1,
+	  "model " + std::to_string(m_iID) + " vertex staging"
 	};
 
 	// Note: it will unmap in the destructor
@@ -109,7 +118,9 @@ void MyModel::_createVertexBuffer(const std::vector<Vertex>& vertices, bool bUse
 		vertexSize,
 		m_iVertexCount,
 		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		1,
+		"model " + std::to_string(m_iID) + " vertices");
 
 	// Copy from stage buffer to device local buffer
 	// Note: because device local buffer can perform faster, but cannot access by CPU
@@ -137,6 +148,8 @@ void MyModel::_createIndexBuffers(const std::vector<uint32_t>& indices)
 	  m_iIndexCount,
 	  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 	  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	  1,
+	  "model " + std::to_string(m_iID) + " index staging"
 	};
 
 	stagingBuffer.map();
@@ -147,16 +160,42 @@ void MyModel::_createIndexBuffers(const std::vector<uint32_t>& indices)
 		indexSize,
 		m_iIndexCount,
 		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		1,
+		"model " + std::to_string(m_iID) + " indices");
 
 	m_myDevice.copyBuffer(stagingBuffer.buffer(), m_pMyIndexBuffer->buffer(), bufferSize);
 }
 
+void MyModel::prepareFrame(int frameIndex)
+{
+	m_iFrameIndex = frameIndex;
+
+	if (m_pMyDynamicVertexBuffer)
+	{
+		m_pMyDynamicVertexBuffer->prepareSlot(frameIndex);
+	}
+	else if (m_pMyVertexBuffer->hasDirtyRanges())
+	{
+		m_pMyVertexBuffer->flushDirtyRanges();
+	}
+}
+
+VkBuffer MyModel::vertexBuffer() const
+{
+	return m_pMyDynamicVertexBuffer ? m_pMyDynamicVertexBuffer->buffer() : m_pMyVertexBuffer->buffer();
+}
+
+VkDeviceSize MyModel::vertexOffset() const
+{
+	return m_pMyDynamicVertexBuffer ? m_pMyDynamicVertexBuffer->slotOffset(m_iFrameIndex) : 0;
+}
+
 void MyModel::bind(VkCommandBuffer commandBuffer)
 {
 	// Bind vertex buffer and index buffer
-	VkBuffer buffers[] = { m_pMyVertexBuffer->buffer() };
-	VkDeviceSize offsets[] = { 0 };
+	VkBuffer buffers[] = { vertexBuffer() };
+	VkDeviceSize offsets[] = { vertexOffset() };
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
 	if (m_bHasIndexBuffer) 
@@ -171,6 +210,10 @@ void MyModel::draw(VkCommandBuffer commandBuffer)
 	{
 		vkCmdDrawIndexed(commandBuffer, m_iIndexCount, 1, 0, 0, 0);
 	}
+	else if (m_pMyDynamicVertexBuffer)
+	{
+		vkCmdDraw(commandBuffer, m_pMyDynamicVertexBuffer->instanceCount(m_iFrameIndex), 1, 0, 0);
+	}
 	else
 	{
 		vkCmdDraw(commandBuffer, m_iVertexCount, 1, 0, 0);
@@ -221,6 +264,8 @@ std::vector<VkVertexInputAttributeDescription> MyModel::PointLine::getAttributeD
 
 void MyModel::Builder::loadModel(const std::string& filepath)
 {
+	MY_TRACE_SCOPE_ARGS("model", "loadModel", "file=%s", filepath.c_str());
+
 	// Note: attrib contains vertex, color, normal, texture coordinate...
 	// shapes contain the index elements for the geometry
 	tinyobj::attrib_t attrib;
@@ -298,11 +343,32 @@ void MyModel::Builder::loadModel(const std::string& filepath)
 
 void MyModel::updatePointLines(const std::vector<PointLine>& vertices)
 {
-	m_iVertexCount = static_cast<uint32_t>(vertices.size());
-	if (m_iVertexCount <= 0 || m_iVertexCount > m_iMaxVertexCount)
+	assert(m_pMyDynamicVertexBuffer && "Only point and line models can be updated");
+
+	// Only the used vertices are copied, an empty vector hides the model
+	m_pMyDynamicVertexBuffer->write(vertices.data(), static_cast<uint32_t>(vertices.size()));
+}
+
+void MyModel::updateRange(const std::vector<PointLine>& vertices, uint32_t first, uint32_t count)
+{
+	assert(m_pMyDynamicVertexBuffer && "Only point and line models can be updated");
+	assert(first + count <= vertices.size() && "Range is outside of the vertices");
+
+	if (count == 0)
+		return;
+
+	m_pMyDynamicVertexBuffer->writeRange(&vertices[first], first, count);
+}
+
+void MyModel::updateRange(const std::vector<Vertex>& vertices, uint32_t first, uint32_t count)
+{
+	assert(!m_pMyDynamicVertexBuffer && "Point and line models take PointLine vertices");
+	assert(first + count <= m_iVertexCount && first + count <= vertices.size() && "Range is outside of the vertices");
+
+	if (count == 0)
 		return;
 
-	VkDeviceSize bufferSize = sizeof(vertices[0]) * m_iVertexCount;
-	m_pMyVertexBuffer->writeToBuffer((void*)vertices.data());
+	// Copied into the device local buffer on the next prepareFrame
+	m_pMyVertexBuffer->writeRange(&vertices[first], sizeof(Vertex) * count, sizeof(Vertex) * first);
 }
 
@@ -3,6 +3,7 @@
 
 #include "my_buffer.h"
 #include "my_device.h"
+#include "my_dynamic_buffer.h"
 
 // use radian rather degree for angle
 #define GLM_FORCE_RADIANS
@@ -62,8 +63,9 @@ public:
 	MyModel(MyDevice &device, const std::vector<Vertex>& vertices);
 	MyModel(MyDevice& device, const MyModel::Builder& builder);
 
-	// For build point, line and curve
-    MyModel(MyDevice &device, const int maxVertices);
+	// For build point, line and curve, the vertex buffer grows as needed and the
+	// renderer frees the buffers it outgrew
+    MyModel(MyDevice &device, MyRenderer& renderer, const int initialVertexCapacity);
 
 	~MyModel();
 
@@ -73,20 +75,44 @@ public:
 	static std::unique_ptr<MyModel> createModelFromFile(
 		MyDevice& device, const std::string& filepath);
 
+	// Point and line models only. Safe while frames are in flight, the vertices
+	// reach the GPU when prepareFrame is called for each frame
     void updatePointLines(const std::vector<PointLine>& vertices);
+
+	// Upload only vertices [first, first + count) of vertices, which otherwise must match
+	// the last update. For point and line models and for models with a vertex buffer
+	void updateRange(const std::vector<PointLine>& vertices, uint32_t first, uint32_t count);
+	void updateRange(const std::vector<Vertex>& vertices, uint32_t first, uint32_t count);
+
+	// Must be called on the main thread for every frame the model is recorded in,
+	// after the frame that last used frameIndex was waited for and before recording
+	void prepareFrame(int frameIndex);
+
 	void bind(VkCommandBuffer commandBuffer);
 	void draw(VkCommandBuffer commandBuffer);
 
+	// Used by the render queue to skip redundant binds
+	uint32_t     id()             const { return m_iID; }
+	VkBuffer     vertexBuffer()   const;
+	VkDeviceSize vertexOffset()   const;
+	VkBuffer     indexBuffer()    const { return m_bHasIndexBuffer ? m_pMyIndexBuffer->buffer() : VK_NULL_HANDLE; }
+	bool         hasIndexBuffer() const { return m_bHasIndexBuffer; }
+
 private:
+	static uint32_t _nextID();
 
 	void _createVertexBuffer(const std::vector<Vertex>& vertices, bool bUseIndexBuffer = false);
 	void _createIndexBuffers(const std::vector<uint32_t>& indices);
 
 	// Use the new MyBuffer for vertex and index buffers
 	MyDevice&                 m_myDevice;
+	uint32_t                  m_iID = _nextID();
 	std::unique_ptr<MyBuffer> m_pMyVertexBuffer;
 	uint32_t                  m_iVertexCount = 0;
-    uint32_t                  m_iMaxVertexCount = 0;
+
+	// Points and lines, one slot per frame in flight
+	std::unique_ptr<MyDynamicBuffer> m_pMyDynamicVertexBuffer;
+	int                       m_iFrameIndex = 0;  // slot recorded in the current frame
 
 	bool                      m_bHasIndexBuffer = false;
 	std::unique_ptr<MyBuffer> m_pMyIndexBuffer;
@@ -0,0 +1,42 @@
+#include "my_name_table.h"
+
+// std
+#include <cassert>
+
+MyNameTable& MyNameTable::instance()
+{
+	static MyNameTable table;
+	return table;
+}
+
+MyNameID MyNameTable::intern(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock{ m_mutex };
+
+	auto it = m_mapIDs.find(name);
+	if (it != m_mapIDs.end())
+	{
+		return it->second;
+	}
+
+	MyNameID id = static_cast<MyNameID>(m_dqNames.size());
+	m_dqNames.push_back(name);
+	m_mapIDs.emplace(name, id);
+	return id;
+}
+
+MyNameID MyNameTable::find(const std::string& name) const
+{
+	std::lock_guard<std::mutex> lock{ m_mutex };
+
+	auto it = m_mapIDs.find(name);
+	return it != m_mapIDs.end() ? it->second : INVALID_NAME;
+}
+
+const std::string& MyNameTable::name(MyNameID id) const
+{
+	std::lock_guard<std::mutex> lock{ m_mutex };
+
+	assert(id < m_dqNames.size() && "Unknown name id");
+	return m_dqNames[id];
+}
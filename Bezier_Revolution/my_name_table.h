@@ -0,0 +1,44 @@
+#ifndef __MY_NAME_TABLE_H__
+#define __MY_NAME_TABLE_H__
+
+// std
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using MyNameID = uint32_t;
+
+//
+// Interns names into 32-bit ids, so per-frame code compares and hashes integers instead of
+// strings. Interning a new name allocates once, after that the same name always maps to the
+// same id and the lookup allocates nothing. Intern the names at load time, not per frame
+//
+class MyNameTable
+{
+public:
+	static constexpr MyNameID INVALID_NAME = UINT32_MAX;
+
+	static MyNameTable& instance();
+
+	MyNameTable(const MyNameTable&) = delete;
+	MyNameTable& operator=(const MyNameTable&) = delete;
+
+	MyNameID           intern(const std::string& name);
+
+	// INVALID_NAME if the name was never interned
+	MyNameID           find(const std::string& name) const;
+
+	// The reference stays valid for the lifetime of the table
+	const std::string& name(MyNameID id) const;
+
+private:
+	MyNameTable() = default;
+
+	mutable std::mutex                        m_mutex;
+	std::deque<std::string>                   m_dqNames;    // indexed by id, a deque never moves its elements
+	std::unordered_map<std::string, MyNameID> m_mapIDs;
+};
+
+#endif
@@ -1,67 +1,53 @@
 #include "my_pipeline.h"
 #include "my_model.h"
+#include "my_tracer.h"
 
 // std
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
 #include <cassert>
 
-MyPipeline::MyPipeline(MyDevice& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) :
+MyPipeline::MyPipeline(MyDevice& device, VkShaderModule vertShaderModule, VkShaderModule fragShaderModule, const PipelineConfigInfo& configInfo) :
     m_myDevice{ device }
 {
-    _createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+    MY_TRACE_SCOPE_ARGS("pipeline", "create pipeline", "topology=%d", static_cast<int>(configInfo.inputAssemblyInfo.topology));
+
+    m_bDynamicTopology = std::find(
+        configInfo.dynamicStateEnables.begin(),
+        configInfo.dynamicStateEnables.end(),
+        VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT) != configInfo.dynamicStateEnables.end();
+
+    _createGraphicsPipeline(vertShaderModule, fragShaderModule, configInfo);
 }
 
 MyPipeline::~MyPipeline()
 {
-    vkDestroyShaderModule(m_myDevice.device(), m_vkVertShaderModule, nullptr);
-    vkDestroyShaderModule(m_myDevice.device(), m_vkFragShaderModule, nullptr);
+    // The shader modules are owned by the pipeline library
     vkDestroyPipeline(m_myDevice.device(), m_vkGraphicsPipeline, nullptr);
 }
 
-std::vector<char> MyPipeline::_readFile(const std::string& filename)
+uint32_t MyPipeline::_nextID()
 {
-    std::ifstream file{ filename, std::ios::ate | std::ios::binary };
-
-    if (!file.is_open())
-    {
-        throw std::runtime_error("failed to open file: " + filename);
-    }
-
-    size_t fileSize = (size_t)file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-
-    file.close();
-
-    return buffer;
+    // Pipelines can be compiled on several worker threads at once
+    static std::atomic<uint32_t> currentID{ 0 };
+    return currentID++;
 }
 
 void MyPipeline::_createGraphicsPipeline(
-    const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
+    VkShaderModule vertShaderModule, VkShaderModule fragShaderModule, const PipelineConfigInfo& configInfo)
 {
     assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Pipeline cannot be created with null pipeline layout");
     assert(configInfo.renderPass != VK_NULL_HANDLE && "RenderPass cannot be created with null pipeline layout");
 
-    auto vertCode = _readFile(vertFilepath);
-    auto fragCode = _readFile(fragFilepath);
-
-    std::cout << "Vertex Shader Code Size: " << vertCode.size() << '\n';
-    std::cout << "Fragment Shader Code Size: " << fragCode.size() << '\n';
-
-    // Create the shader module based on the current shader code
-    _createShaderModule(vertCode, &m_vkVertShaderModule);
-    _createShaderModule(fragCode, &m_vkFragShaderModule);
-
     VkPipelineShaderStageCreateInfo shaderStages[2];
 
     shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-    shaderStages[0].module = m_vkVertShaderModule;
+    shaderStages[0].module = vertShaderModule;
     shaderStages[0].pName = "main"; // the main funciton of teh vertex shader
     shaderStages[0].flags = 0;
     shaderStages[0].pNext = nullptr;
@@ -69,7 +55,7 @@ void MyPipeline::_createGraphicsPipeline(
 
     shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    shaderStages[1].module = m_vkFragShaderModule;
+    shaderStages[1].module = fragShaderModule;
     shaderStages[1].pName = "main"; // the main funciton of teh vertex shader
     shaderStages[1].flags = 0;
     shaderStages[1].pNext = nullptr;
@@ -109,9 +95,12 @@ void MyPipeline::_createGraphicsPipeline(
     pipelineInfo.basePipelineIndex = -1;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     
+    // The pipeline cache of the device is warm if the pipeline has been compiled in a previous run
+    auto startTime = std::chrono::high_resolution_clock::now();
+
     if (vkCreateGraphicsPipelines(
         m_myDevice.device(),
-        VK_NULL_HANDLE,
+        m_myDevice.pipelineCache(),
         1,
         &pipelineInfo,
         nullptr,
@@ -119,19 +108,10 @@ void MyPipeline::_createGraphicsPipeline(
     {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
-}
 
-void MyPipeline::_createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
-{
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-    if (vkCreateShaderModule(m_myDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create Shader Module");
-    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    float creationTime = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+    std::cout << "Pipeline " << m_iID << " created in " << creationTime << " ms" << std::endl;
 }
 
 void MyPipeline::bind(VkCommandBuffer commandBuffer)
@@ -144,6 +124,34 @@ void MyPipeline::bind(VkCommandBuffer commandBuffer)
 	}
 }
 
+void MyPipeline::setTopology(VkCommandBuffer commandBuffer, VkPrimitiveTopology topology)
+{
+    assert(m_bDynamicTopology && "Pipeline was not created with dynamic primitive topology");
+    m_myDevice.cmdSetPrimitiveTopology(commandBuffer, topology);
+}
+
+void MyPipeline::clonePipelineConfigInfo(const PipelineConfigInfo& source, PipelineConfigInfo& configInfo)
+{
+    configInfo.viewportInfo = source.viewportInfo;
+    configInfo.inputAssemblyInfo = source.inputAssemblyInfo;
+    configInfo.rasterizationInfo = source.rasterizationInfo;
+    configInfo.multisampleInfo = source.multisampleInfo;
+    configInfo.colorBlendAttachment = source.colorBlendAttachment;
+    configInfo.colorBlendInfo = source.colorBlendInfo;
+    configInfo.depthStencilInfo = source.depthStencilInfo;
+    configInfo.dynamicStateEnables = source.dynamicStateEnables;
+    configInfo.dynamicStateInfo = source.dynamicStateInfo;
+    configInfo.pipelineLayout = source.pipelineLayout;
+    configInfo.renderPass = source.renderPass;
+    configInfo.subpass = source.subpass;
+    configInfo.pointLineRendering = source.pointLineRendering;
+
+    // Point to the members of the clone instead of the source
+    configInfo.colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+    configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+    configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+}
+
 void MyPipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
 {
     // This is the first stage of the pipeline to take a list of vertices to let Vulkan know
@@ -30,7 +30,8 @@ struct PipelineConfigInfo
 class MyPipeline
 {
 public:
-	MyPipeline(MyDevice &device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo &configInfo);
+	// The shader modules are only used during creation and are not owned by the pipeline
+	MyPipeline(MyDevice &device, VkShaderModule vertShaderModule, VkShaderModule fragShaderModule, const PipelineConfigInfo &configInfo);
 	~MyPipeline();
 
 	MyPipeline(const MyPipeline&) = delete;
@@ -39,16 +40,25 @@ public:
     void bind(VkCommandBuffer commandBuffer);
 	static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
 
+	// PipelineConfigInfo cannot be copied because it points into itself
+	static void clonePipelineConfigInfo(const PipelineConfigInfo& source, PipelineConfigInfo& configInfo);
+
+	VkPipeline pipeline() const { return m_vkGraphicsPipeline; }
+	uint32_t   id()       const { return m_iID; } // small sequential id used in the render queue sort key
+
+	// True if the topology is set at draw time with VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT
+	bool       hasDynamicTopology() const { return m_bDynamicTopology; }
+	void       setTopology(VkCommandBuffer commandBuffer, VkPrimitiveTopology topology);
+
 private:
-	static std::vector<char> _readFile(const std::string& filename);
+	static uint32_t _nextID();
 
-	void _createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
-	void _createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
+	void _createGraphicsPipeline(VkShaderModule vertShaderModule, VkShaderModule fragShaderModule, const PipelineConfigInfo& configInfo);
 
 	MyDevice&      m_myDevice;
+	uint32_t       m_iID = _nextID();
 	VkPipeline     m_vkGraphicsPipeline;
-	VkShaderModule m_vkVertShaderModule;
-	VkShaderModule m_vkFragShaderModule;
+	bool           m_bDynamicTopology = false;
 };
 
 #endif
@@ -0,0 +1,306 @@
+#include "my_pipeline_library.h"
+
+// std
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+PipelineKey PipelineKey::create(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
+{
+	PipelineKey key{};
+	key.vertFilepath = vertFilepath;
+	key.fragFilepath = fragFilepath;
+
+	key.topology = configInfo.inputAssemblyInfo.topology;
+	key.primitiveRestartEnable = configInfo.inputAssemblyInfo.primitiveRestartEnable;
+
+	const auto& rasterization = configInfo.rasterizationInfo;
+	key.depthClampEnable = rasterization.depthClampEnable;
+	key.rasterizerDiscardEnable = rasterization.rasterizerDiscardEnable;
+	key.polygonMode = rasterization.polygonMode;
+	key.cullMode = rasterization.cullMode;
+	key.frontFace = rasterization.frontFace;
+	key.lineWidth = rasterization.lineWidth;
+	key.depthBiasEnable = rasterization.depthBiasEnable;
+
+	key.rasterizationSamples = configInfo.multisampleInfo.rasterizationSamples;
+	key.sampleShadingEnable = configInfo.multisampleInfo.sampleShadingEnable;
+
+	const auto& blend = configInfo.colorBlendAttachment;
+	key.blendEnable = blend.blendEnable;
+	key.colorWriteMask = blend.colorWriteMask;
+	if (blend.blendEnable)
+	{
+		key.srcColorBlendFactor = blend.srcColorBlendFactor;
+		key.dstColorBlendFactor = blend.dstColorBlendFactor;
+		key.colorBlendOp = blend.colorBlendOp;
+		key.srcAlphaBlendFactor = blend.srcAlphaBlendFactor;
+		key.dstAlphaBlendFactor = blend.dstAlphaBlendFactor;
+		key.alphaBlendOp = blend.alphaBlendOp;
+	}
+
+	const auto& depthStencil = configInfo.depthStencilInfo;
+	key.depthTestEnable = depthStencil.depthTestEnable;
+	key.stencilTestEnable = depthStencil.stencilTestEnable;
+	if (depthStencil.depthTestEnable)
+	{
+		key.depthWriteEnable = depthStencil.depthWriteEnable;
+		key.depthCompareOp = depthStencil.depthCompareOp;
+	}
+
+	// The order the dynamic states are listed in does not matter
+	key.dynamicStates = configInfo.dynamicStateEnables;
+	std::sort(key.dynamicStates.begin(), key.dynamicStates.end());
+	key.dynamicStates.erase(std::unique(key.dynamicStates.begin(), key.dynamicStates.end()), key.dynamicStates.end());
+
+	key.pipelineLayout = configInfo.pipelineLayout;
+	key.renderPass = configInfo.renderPass;
+	key.subpass = configInfo.subpass;
+	key.pointLineRendering = configInfo.pointLineRendering;
+
+	return key;
+}
+
+bool PipelineKey::operator==(const PipelineKey& other) const
+{
+	auto tie = [](const PipelineKey& key)
+	{
+		return std::tie(key.vertFilepath, key.fragFilepath, key.topology, key.primitiveRestartEnable,
+			key.depthClampEnable, key.rasterizerDiscardEnable, key.polygonMode, key.cullMode, key.frontFace,
+			key.lineWidth, key.depthBiasEnable, key.rasterizationSamples, key.sampleShadingEnable,
+			key.blendEnable, key.srcColorBlendFactor, key.dstColorBlendFactor, key.colorBlendOp,
+			key.srcAlphaBlendFactor, key.dstAlphaBlendFactor, key.alphaBlendOp, key.colorWriteMask,
+			key.depthTestEnable, key.depthWriteEnable, key.depthCompareOp, key.stencilTestEnable,
+			key.dynamicStates, key.pipelineLayout, key.renderPass, key.subpass, key.pointLineRendering);
+	};
+
+	return tie(*this) == tie(other);
+}
+
+bool MyPipelineHandle::isReady() const
+{
+	if (!m_future.valid())
+	{
+		return false;
+	}
+
+	if (m_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return false;
+	}
+
+	// Rethrow a failed compilation on the thread asking for the pipeline
+	m_future.get();
+	return true;
+}
+
+MyPipelineLibrary::MyPipelineLibrary(MyDevice& device, MyThreadPool& threadPool) :
+	m_myDevice{ device },
+	m_myThreadPool{ threadPool }
+{
+}
+
+MyPipelineLibrary::~MyPipelineLibrary()
+{
+	// The worker threads still use the shader modules and layouts while compiling
+	for (auto& kv : m_mapPipelines)
+	{
+		kv.second.wait();
+	}
+
+	// Pipelines still held by someone else keep working until they are released,
+	// but the layouts and shader modules go away with the library
+	m_mapPipelines.clear();
+
+	for (auto& kv : m_mapShaderModules)
+	{
+		vkDestroyShaderModule(m_myDevice.device(), kv.second.module, nullptr);
+	}
+
+	for (auto& kv : m_mapPipelineLayouts)
+	{
+		vkDestroyPipelineLayout(m_myDevice.device(), kv.second, nullptr);
+	}
+}
+
+VkPipelineLayout MyPipelineLibrary::getPipelineLayout(const VkPushConstantRange& pushConstantRange)
+{
+	LayoutKey layoutKey{ pushConstantRange.stageFlags, pushConstantRange.offset, pushConstantRange.size };
+
+	auto it = m_mapPipelineLayouts.find(layoutKey);
+	if (it != m_mapPipelineLayouts.end())
+	{
+		return it->second;
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 0;
+	pipelineLayoutInfo.pSetLayouts = nullptr;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkPipelineLayout pipelineLayout;
+	if (vkCreatePipelineLayout(m_myDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	m_mapPipelineLayouts[layoutKey] = pipelineLayout;
+	return pipelineLayout;
+}
+
+MyPipelineHandle MyPipelineLibrary::getPipeline(const std::string& vertFilepath, const std::string& fragFilepath, PipelineConfigInfo& configInfo)
+{
+	if (hasDynamicTopology())
+	{
+		_enableDynamicTopology(configInfo);
+	}
+
+	PipelineKey key = PipelineKey::create(vertFilepath, fragFilepath, configInfo);
+
+	auto it = m_mapPipelines.find(key);
+	if (it != m_mapPipelines.end())
+	{
+		std::cout << "Reuse pipeline (" << vertFilepath << ")" << std::endl;
+		return it->second;
+	}
+
+	// Shader modules are created here so the cache is only touched by this thread
+	VkShaderModule vertShaderModule = _getShaderModule(vertFilepath);
+	VkShaderModule fragShaderModule = _getShaderModule(fragFilepath);
+
+	// The caller's configInfo may be gone by the time a worker gets to it
+	std::shared_ptr<PipelineConfigInfo> pConfigInfo(new PipelineConfigInfo{});
+	MyPipeline::clonePipelineConfigInfo(configInfo, *pConfigInfo);
+
+	MyDevice& device = m_myDevice;
+	std::shared_future<std::shared_ptr<MyPipeline>> future = m_myThreadPool.enqueue(
+		[&device, vertShaderModule, fragShaderModule, pConfigInfo]()
+		{
+			return std::make_shared<MyPipeline>(device, vertShaderModule, fragShaderModule, *pConfigInfo);
+		}).share();
+
+	MyPipelineHandle handle{ future };
+	m_mapPipelines[key] = handle;
+	return handle;
+}
+
+void MyPipelineLibrary::waitIdle()
+{
+	for (auto& kv : m_mapPipelines)
+	{
+		kv.second.wait();
+	}
+}
+
+bool MyPipelineLibrary::isIdle() const
+{
+	for (const auto& kv : m_mapPipelines)
+	{
+		if (!kv.second.isReady())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<char> MyPipelineLibrary::_readFile(const std::string& filename)
+{
+	std::ifstream file{ filename, std::ios::ate | std::ios::binary };
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open file: " + filename);
+	}
+
+	size_t fileSize = (size_t)file.tellg();
+	std::vector<char> buffer(fileSize);
+
+	file.seekg(0);
+	file.read(buffer.data(), fileSize);
+
+	file.close();
+
+	return buffer;
+}
+
+VkShaderModule MyPipelineLibrary::_getShaderModule(const std::string& filepath)
+{
+	auto pathIt = m_mapShaderPaths.find(filepath);
+	if (pathIt != m_mapShaderPaths.end())
+	{
+		return pathIt->second;
+	}
+
+	std::vector<char> code = _readFile(filepath);
+	size_t hash = std::hash<std::string>{}(std::string(code.begin(), code.end()));
+
+	// A different path with the same SPIR-V reuses the module
+	auto range = m_mapShaderModules.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.code == code)
+		{
+			std::cout << "Reuse shader module (" << filepath << ")" << std::endl;
+			m_mapShaderPaths[filepath] = it->second.module;
+			return it->second.module;
+		}
+	}
+
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size();
+	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(m_myDevice.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create Shader Module");
+	}
+
+	std::cout << "Shader Code Size: " << code.size() << " (" << filepath << ")" << std::endl;
+
+	m_mapShaderModules.emplace(hash, ShaderModule{ std::move(code), shaderModule });
+	m_mapShaderPaths[filepath] = shaderModule;
+	return shaderModule;
+}
+
+VkPrimitiveTopology MyPipelineLibrary::_topologyClass(VkPrimitiveTopology topology)
+{
+	switch (topology)
+	{
+	case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+		return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+		return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+
+	case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+		return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+
+	default:
+		return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	}
+}
+
+void MyPipelineLibrary::_enableDynamicTopology(PipelineConfigInfo& configInfo)
+{
+	configInfo.inputAssemblyInfo.topology = _topologyClass(configInfo.inputAssemblyInfo.topology);
+
+	auto& dynamicStates = configInfo.dynamicStateEnables;
+	if (std::find(dynamicStates.begin(), dynamicStates.end(), VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT) == dynamicStates.end())
+	{
+		dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
+	}
+
+	// The vector may have moved its storage
+	configInfo.dynamicStateInfo.pDynamicStates = dynamicStates.data();
+	configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+}
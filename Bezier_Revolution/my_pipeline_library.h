@@ -0,0 +1,167 @@
+#ifndef __MY_PIPELINE_LIBRARY_H__
+#define __MY_PIPELINE_LIBRARY_H__
+
+#include "my_device.h"
+#include "my_pipeline.h"
+#include "my_thread_pool.h"
+#include "my_utils.h"
+
+// std
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+//
+// The parts of a PipelineConfigInfo and its shaders that change the compiled pipeline.
+// State that Vulkan ignores (e.g. blend factors with blending off) is zeroed so it
+// does not create different keys for the same pipeline
+//
+struct PipelineKey
+{
+	std::string                 vertFilepath;
+	std::string                 fragFilepath;
+
+	VkPrimitiveTopology         topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkBool32                    primitiveRestartEnable = VK_FALSE;
+
+	VkBool32                    depthClampEnable = VK_FALSE;
+	VkBool32                    rasterizerDiscardEnable = VK_FALSE;
+	VkPolygonMode               polygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags             cullMode = VK_CULL_MODE_NONE;
+	VkFrontFace                 frontFace = VK_FRONT_FACE_CLOCKWISE;
+	float                       lineWidth = 1.0f;
+	VkBool32                    depthBiasEnable = VK_FALSE;
+
+	VkSampleCountFlagBits       rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	VkBool32                    sampleShadingEnable = VK_FALSE;
+
+	VkBool32                    blendEnable = VK_FALSE;
+	VkBlendFactor               srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor               dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp                   colorBlendOp = VK_BLEND_OP_ADD;
+	VkBlendFactor               srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor               dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp                   alphaBlendOp = VK_BLEND_OP_ADD;
+	VkColorComponentFlags       colorWriteMask = 0;
+
+	VkBool32                    depthTestEnable = VK_FALSE;
+	VkBool32                    depthWriteEnable = VK_FALSE;
+	VkCompareOp                 depthCompareOp = VK_COMPARE_OP_NEVER;
+	VkBool32                    stencilTestEnable = VK_FALSE;
+
+	std::vector<VkDynamicState> dynamicStates;
+
+	VkPipelineLayout            pipelineLayout = VK_NULL_HANDLE;
+	VkRenderPass                renderPass = VK_NULL_HANDLE;
+	uint32_t                    subpass = 0;
+	bool                        pointLineRendering = false;
+
+	static PipelineKey create(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+
+	bool operator==(const PipelineKey& other) const;
+};
+
+namespace std {
+	template <>
+	struct hash<PipelineKey> {
+		size_t operator()(PipelineKey const& key) const {
+			size_t seed = 0;
+			myHashCombine(seed, key.vertFilepath, key.fragFilepath, key.topology, key.primitiveRestartEnable,
+				key.depthClampEnable, key.rasterizerDiscardEnable, key.polygonMode, key.cullMode, key.frontFace,
+				key.lineWidth, key.depthBiasEnable, key.rasterizationSamples, key.sampleShadingEnable,
+				key.blendEnable, key.srcColorBlendFactor, key.dstColorBlendFactor, key.colorBlendOp,
+				key.srcAlphaBlendFactor, key.dstAlphaBlendFactor, key.alphaBlendOp, key.colorWriteMask,
+				key.depthTestEnable, key.depthWriteEnable, key.depthCompareOp, key.stencilTestEnable,
+				key.pipelineLayout, key.renderPass, key.subpass, key.pointLineRendering);
+			for (auto dynamicState : key.dynamicStates)
+			{
+				myHashCombine(seed, dynamicState);
+			}
+			return seed;
+		}
+	};
+}
+
+//
+// A pipeline that may still be compiling on a worker thread
+//
+class MyPipelineHandle
+{
+public:
+	MyPipelineHandle() = default;
+	MyPipelineHandle(std::shared_future<std::shared_ptr<MyPipeline>> future) : m_future{ std::move(future) } {}
+
+	// Never blocks. Rethrows here if the compilation failed
+	bool        isReady() const;
+	void        wait()    const { m_future.wait(); }
+
+	// Blocks until the pipeline is compiled
+	MyPipeline& pipeline() const { return *m_future.get(); }
+
+private:
+	std::shared_future<std::shared_ptr<MyPipeline>> m_future;
+};
+
+//
+// Hand out shared pipelines, pipeline layouts and shader modules so render systems asking
+// for the same state get the same Vulkan objects. Pipelines are compiled on the thread pool.
+// Owned by the application and must outlive the render systems
+//
+class MyPipelineLibrary
+{
+public:
+	MyPipelineLibrary(MyDevice& device, MyThreadPool& threadPool);
+	~MyPipelineLibrary();
+
+	MyPipelineLibrary(const MyPipelineLibrary&) = delete;
+	MyPipelineLibrary& operator=(const MyPipelineLibrary&) = delete;
+
+	// Layouts with only one push constant range, which is all the render systems need
+	VkPipelineLayout            getPipelineLayout(const VkPushConstantRange& pushConstantRange);
+
+	// With dynamic topology available, configInfo is changed to use it and its topology is
+	// replaced by the first topology of the same class (point, line, triangle or patch), as
+	// Vulkan only allows switching topology within the class the pipeline was created with
+	// Returns right away, the pipeline is compiled in the background
+	MyPipelineHandle            getPipeline(const std::string& vertFilepath, const std::string& fragFilepath, PipelineConfigInfo& configInfo);
+
+	// Block until every pipeline requested so far is compiled
+	void                        waitIdle();
+
+	// True once every pipeline requested so far is compiled. Never blocks
+	bool                        isIdle() const;
+
+	bool                        hasDynamicTopology() const { return m_myDevice.hasExtendedDynamicState(); }
+
+private:
+	// stage flags, offset and size of the push constant range
+	using LayoutKey = std::tuple<VkShaderStageFlags, uint32_t, uint32_t>;
+
+	struct ShaderModule
+	{
+		std::vector<char> code;
+		VkShaderModule    module;
+	};
+
+	static VkPrimitiveTopology _topologyClass(VkPrimitiveTopology topology);
+	static std::vector<char>   _readFile(const std::string& filename);
+
+	void           _enableDynamicTopology(PipelineConfigInfo& configInfo);
+	VkShaderModule _getShaderModule(const std::string& filepath);
+
+	MyDevice&                                                 m_myDevice;
+	MyThreadPool&                                             m_myThreadPool;
+	std::map<LayoutKey, VkPipelineLayout>                     m_mapPipelineLayouts;
+	std::unordered_map<PipelineKey, MyPipelineHandle>         m_mapPipelines;
+
+	// Each file is read once. Files with the same SPIR-V share one module,
+	// the content hash is only a shortcut and the code is compared on a match
+	std::unordered_map<std::string, VkShaderModule>           m_mapShaderPaths;
+	std::unordered_multimap<size_t, ShaderModule>             m_mapShaderModules;
+};
+
+#endif
@@ -17,38 +17,30 @@ struct MyPointLinePushConstantData
     glm::vec3 push_color{ 1.0f, 0.0f, 0.0f };
 };
 
-MyPointLineRenderSystem::MyPointLineRenderSystem(MyDevice& device, VkRenderPass renderPass, VkPrimitiveTopology topology)
-    : m_myDevice{ device } 
+MyPointLineRenderSystem::MyPointLineRenderSystem(MyDevice& device, MyPipelineLibrary& pipelineLibrary, VkRenderPass renderPass, VkPrimitiveTopology topology)
+    : m_myDevice{ device },
+      m_vkTopology{ topology }
 {
-    _createPipelineLayout();
-    _createPipeline(renderPass, topology);
+    _createPipelineLayout(pipelineLibrary);
+    _createPipeline(pipelineLibrary, renderPass, topology);
 }
 
 MyPointLineRenderSystem::~MyPointLineRenderSystem()
 {
-    vkDestroyPipelineLayout(m_myDevice.device(), m_vkPipelineLayout, nullptr);
+    // The pipeline layout is owned by the pipeline library
 }
 
-void MyPointLineRenderSystem::_createPipelineLayout() 
+void MyPointLineRenderSystem::_createPipelineLayout(MyPipelineLibrary& pipelineLibrary) 
 {
     VkPushConstantRange pushConstantRange{};
     pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
     pushConstantRange.offset = 0;
     pushConstantRange.size = sizeof(MyPointLinePushConstantData);
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0;
-    pipelineLayoutInfo.pSetLayouts = nullptr;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-    if (vkCreatePipelineLayout(m_myDevice.device(), &pipelineLayoutInfo, nullptr, &m_vkPipelineLayout) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
+    m_vkPipelineLayout = pipelineLibrary.getPipelineLayout(pushConstantRange);
 }
 
-void MyPointLineRenderSystem::_createPipeline(VkRenderPass renderPass, VkPrimitiveTopology topology)
+void MyPointLineRenderSystem::_createPipeline(MyPipelineLibrary& pipelineLibrary, VkRenderPass renderPass, VkPrimitiveTopology topology)
 {
     assert(m_vkPipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
@@ -59,8 +51,8 @@ void MyPointLineRenderSystem::_createPipeline(VkRenderPass renderPass, VkPrimiti
     pipelineConfig.inputAssemblyInfo.topology = topology; // override to draw in different topology
     pipelineConfig.pointLineRendering = true;             // render points or lines
 
-    m_pMyPipeline = std::make_unique<MyPipeline>(
-        m_myDevice,
+    // Line strips and line lists get the same pipeline if the topology can be dynamic
+    m_myPipeline = pipelineLibrary.getPipeline(
         "shaders/point_line_shader.vert.spv",
         "shaders/simple_shader.frag.spv",
         pipelineConfig);
@@ -68,61 +60,73 @@ void MyPointLineRenderSystem::_createPipeline(VkRenderPass renderPass, VkPrimiti
 
 void MyPointLineRenderSystem::renderControlPoints(
     MyFrameInfo& frameInfo, 
-    std::vector<MyGameObject>& gameObjects) 
+    MyWorld& world) 
 {
-    _renderPointsLines("control_points", frameInfo, gameObjects);
+    _renderPointsLines(PointLineComponent::CONTROL_POINTS, frameInfo, world);
 }
 
 void MyPointLineRenderSystem::renderCenerLine(
     MyFrameInfo& frameInfo,
-    std::vector<MyGameObject>& gameObjects)
+    MyWorld& world)
 {
-    _renderPointsLines("centerLine", frameInfo, gameObjects);
+    _renderPointsLines(PointLineComponent::CENTER_LINE, frameInfo, world);
 }
 
 void MyPointLineRenderSystem::renderBezierCurve(
     MyFrameInfo& frameInfo,
-    std::vector<MyGameObject>& gameObjects)
+    MyWorld& world)
 {
-    _renderPointsLines("bezier_curve", frameInfo, gameObjects);
+    _renderPointsLines(PointLineComponent::BEZIER_CURVE, frameInfo, world);
 }
 
 void MyPointLineRenderSystem::renderNormals(
     MyFrameInfo& frameInfo,
-    std::vector<MyGameObject>& gameObjects)
+    MyWorld& world)
 {
-    _renderPointsLines("surface_normals", frameInfo, gameObjects);
+    _renderPointsLines(PointLineComponent::SURFACE_NORMALS, frameInfo, world);
 }
 
-void MyPointLineRenderSystem::_renderPointsLines(std::string name, MyFrameInfo& frameInfo, std::vector<MyGameObject>& gameObjects)
+void MyPointLineRenderSystem::_renderPointsLines(PointLineComponent::Kind kind, MyFrameInfo& frameInfo, MyWorld& world)
 {
-    m_pMyPipeline->bind(frameInfo.commandBuffer);
+    // Skip drawing until the pipeline is compiled instead of stalling the frame
+    if (!m_myPipeline.isReady())
+        return;
+
     auto projectionView = frameInfo.camera.projectionMatrix() * frameInfo.camera.viewMatrix();
 
-    for (auto& obj : gameObjects)
+    // Only the point and line entities are visited, chunk by chunk
+    world.each<PointLineComponent, ModelComponent, TransformComponent>(
+        [&](PointLineComponent& pointLine, ModelComponent& obj, TransformComponent& transform)
     {
-        if (obj.name() == name && obj.model != nullptr)
+        if (pointLine.kind == kind && obj.model != nullptr)
         {
             MyPointLinePushConstantData push{};
 
-            auto modelMatrix = obj.transform.mat4();
+            auto modelMatrix = transform.mat4();
 
             // Note: do this for now to perform on CPU
             // We will do it later to perform it on GPU
             push.transform = projectionView * modelMatrix;
             push.push_color = frameInfo.color;
 
-            vkCmdPushConstants(
-                frameInfo.commandBuffer,
-                m_vkPipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(MyPointLinePushConstantData),
-                &push);
-
-            obj.model->bind(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+            // Upload the latest vertices into this frame's slot here on the main thread,
+            // the render queue may record the packet on a worker thread
+            obj.model->prepareFrame(frameInfo.frameIndex);
+
+            // Recorded later by the render queue in sorted order
+            MyDrawPacket packet{};
+            packet.sortKey = MyRenderQueue::makeSortKey(
+                frameInfo.pass, 
+                m_myPipeline.pipeline().id(), 
+                obj.model->id(), 
+                MyRenderQueue::depthOf(push.transform));
+            packet.pipeline = &m_myPipeline.pipeline();
+            packet.model = obj.model.get();
+            packet.topology = m_vkTopology;
+            packet.setPushConstants(m_vkPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, push);
+
+            frameInfo.renderQueue.submit(packet);
         }
-    }
+    });
 }
 
@@ -2,8 +2,10 @@
 #define __MY_POINT_LINE_RENDER_SYSTEM_H__
 
 #include "my_device.h"
+#include "my_ecs.h"
 #include "my_game_object.h"
 #include "my_pipeline.h"
+#include "my_pipeline_library.h"
 #include "my_camera.h"
 #include "my_frame_info.h"
 
@@ -15,26 +17,28 @@
 class MyPointLineRenderSystem
 {
 public:
-	MyPointLineRenderSystem(MyDevice& device, VkRenderPass renderPass, VkPrimitiveTopology topology);
+	MyPointLineRenderSystem(MyDevice& device, MyPipelineLibrary& pipelineLibrary, VkRenderPass renderPass, VkPrimitiveTopology topology);
 	~MyPointLineRenderSystem();
 
 	MyPointLineRenderSystem(const MyPointLineRenderSystem&) = delete;
 	MyPointLineRenderSystem& operator=(const MyPointLineRenderSystem&) = delete;
 
-	void renderControlPoints(MyFrameInfo& frameInfo, std::vector<MyGameObject>& gameObjects);
-	void renderCenerLine(MyFrameInfo& frameInfo, std::vector<MyGameObject>& gameObjects);
-	void renderBezierCurve(MyFrameInfo& frameInfo, std::vector<MyGameObject>& gameObjects);
-	void renderNormals(MyFrameInfo& frameInfo, std::vector<MyGameObject>& gameObjects);
+	void renderControlPoints(MyFrameInfo& frameInfo, MyWorld& world);
+	void renderCenerLine(MyFrameInfo& frameInfo, MyWorld& world);
+	void renderBezierCurve(MyFrameInfo& frameInfo, MyWorld& world);
+	void renderNormals(MyFrameInfo& frameInfo, MyWorld& world);
 
 private:
-	void _createPipelineLayout();
-	void _createPipeline(VkRenderPass renderPass, VkPrimitiveTopology topology);
-	void _renderPointsLines(std::string name, MyFrameInfo& frameInfo, std::vector<MyGameObject>& gameObjects);
+	void _createPipelineLayout(MyPipelineLibrary& pipelineLibrary);
+	void _createPipeline(MyPipelineLibrary& pipelineLibrary, VkRenderPass renderPass, VkPrimitiveTopology topology);
+	void _renderPointsLines(PointLineComponent::Kind kind, MyFrameInfo& frameInfo, MyWorld& world);
 
 	MyDevice&                   m_myDevice;
 
-	std::unique_ptr<MyPipeline> m_pMyPipeline;
+	// Both are shared with other render systems through the pipeline library
+	MyPipelineHandle            m_myPipeline;
 	VkPipelineLayout            m_vkPipelineLayout;
+	VkPrimitiveTopology         m_vkTopology;
 };
 
 #endif
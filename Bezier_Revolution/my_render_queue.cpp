@@ -0,0 +1,313 @@
+#include "my_render_queue.h"
+#include "my_cpu_profiler.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+MyRenderStateCache::Stats& MyRenderStateCache::Stats::operator+=(const Stats& other)
+{
+	pipelineBinds += other.pipelineBinds;
+	topologyChanges += other.topologyChanges;
+	vertexBufferBinds += other.vertexBufferBinds;
+	indexBufferBinds += other.indexBufferBinds;
+	skippedBinds += other.skippedBinds;
+	return *this;
+}
+
+void MyRenderStateCache::reset()
+{
+	m_vkPipeline = VK_NULL_HANDLE;
+	m_vkTopology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+	m_vkVertexBuffer = VK_NULL_HANDLE;
+	m_vkVertexOffset = 0;
+	m_vkIndexBuffer = VK_NULL_HANDLE;
+	m_stats = Stats{};
+}
+
+void MyRenderStateCache::bindPipeline(VkCommandBuffer commandBuffer, MyPipeline& pipeline, VkPrimitiveTopology topology)
+{
+	if (pipeline.pipeline() != m_vkPipeline)
+	{
+		pipeline.bind(commandBuffer);
+		m_vkPipeline = pipeline.pipeline();
+		m_stats.pipelineBinds++;
+
+		// Only set the topology again if the new pipeline needs it
+		m_vkTopology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+	}
+	else
+	{
+		m_stats.skippedBinds++;
+	}
+
+	if (!pipeline.hasDynamicTopology() || topology == m_vkTopology)
+	{
+		return;
+	}
+
+	pipeline.setTopology(commandBuffer, topology);
+	m_vkTopology = topology;
+	m_stats.topologyChanges++;
+}
+
+void MyRenderStateCache::bindModel(VkCommandBuffer commandBuffer, MyModel& model)
+{
+	VkBuffer vertexBuffer = model.vertexBuffer();
+	VkDeviceSize vertexOffset = model.vertexOffset();
+	if (vertexBuffer != m_vkVertexBuffer || vertexOffset != m_vkVertexOffset)
+	{
+		VkDeviceSize offsets[] = { vertexOffset };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
+		m_vkVertexBuffer = vertexBuffer;
+		m_vkVertexOffset = vertexOffset;
+		m_stats.vertexBufferBinds++;
+	}
+	else
+	{
+		m_stats.skippedBinds++;
+	}
+
+	if (!model.hasIndexBuffer())
+	{
+		return;
+	}
+
+	VkBuffer indexBuffer = model.indexBuffer();
+	if (indexBuffer != m_vkIndexBuffer)
+	{
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		m_vkIndexBuffer = indexBuffer;
+		m_stats.indexBufferBinds++;
+	}
+	else
+	{
+		m_stats.skippedBinds++;
+	}
+}
+
+uint64_t MyRenderQueue::makeSortKey(uint32_t pass, uint32_t pipelineID, uint32_t modelID, float depth)
+{
+	uint64_t quantizedDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(0xFFFFFF));
+
+	return (static_cast<uint64_t>(pass & 0xFF) << 56) |
+		   (static_cast<uint64_t>(pipelineID & 0xFFFF) << 40) |
+		   (static_cast<uint64_t>(modelID & 0xFFFF) << 24) |
+		   quantizedDepth;
+}
+
+float MyRenderQueue::depthOf(const glm::mat4& transform)
+{
+	// The last column is where the origin of the model ends up in clip space
+	const glm::vec4& clip = transform[3];
+	if (clip.w <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	return clip.z / clip.w;
+}
+
+void MyRenderQueue::submit(const MyDrawPacket& packet)
+{
+	assert(packet.pipeline != nullptr && "Cannot submit a draw packet without a pipeline");
+	assert(packet.model != nullptr && "Cannot submit a draw packet without a model");
+
+	m_vPackets.push_back(packet);
+}
+
+void MyRenderQueue::setPassName(uint32_t pass, const std::string& name)
+{
+	if (pass >= m_vPassNames.size())
+	{
+		m_vPassNames.resize(pass + 1, MyNameTable::INVALID_NAME);
+	}
+	m_vPassNames[pass] = MyNameTable::instance().intern(name);
+}
+
+MyNameID MyRenderQueue::_passName(uint32_t pass)
+{
+	// A pass without a name gets its default one the first time it is flushed
+	if (pass >= m_vPassNames.size() || m_vPassNames[pass] == MyNameTable::INVALID_NAME)
+	{
+		setPassName(pass, "pass " + std::to_string(pass));
+	}
+	return m_vPassNames[pass];
+}
+
+void MyRenderQueue::flush(VkCommandBuffer commandBuffer, MyGpuProfiler* pGpuProfiler)
+{
+	m_vMyStateCaches.resize(1);
+	m_vMyStateCaches[0].reset();
+
+	if (m_vPackets.empty())
+	{
+		return;
+	}
+
+	_radixSort();
+
+	if (pGpuProfiler == nullptr)
+	{
+		_record(commandBuffer, 0, m_vSortEntries.size(), m_vMyStateCaches[0]);
+	}
+	else
+	{
+		// The packets are sorted by pass first, so each pass is one run of packets
+		size_t first = 0;
+		while (first < m_vSortEntries.size())
+		{
+			uint32_t pass = _passOf(m_vSortEntries[first].key);
+
+			size_t last = first + 1;
+			while (last < m_vSortEntries.size() && _passOf(m_vSortEntries[last].key) == pass)
+			{
+				last++;
+			}
+
+			uint32_t scope = pGpuProfiler->beginScope(commandBuffer, _passName(pass));
+			_record(commandBuffer, first, last, m_vMyStateCaches[0]);
+			pGpuProfiler->endScope(commandBuffer, scope);
+
+			first = last;
+		}
+	}
+
+	// Keep the capacity so the next frame does not allocate again
+	m_vPackets.clear();
+}
+
+void MyRenderQueue::flush(VkCommandBuffer commandBuffer, MyRenderer& renderer, MyThreadPool& threadPool)
+{
+	assert(renderer.isParallelRecording() && "Renderer was not created with recording slots");
+
+	size_t chunkCount = std::min<size_t>(
+		renderer.recordingSlots(), 
+		(m_vPackets.size() + MIN_PACKETS_PER_CHUNK - 1) / MIN_PACKETS_PER_CHUNK);
+
+	m_vMyStateCaches.resize(std::max<size_t>(chunkCount, 1));
+	for (auto& stateCache : m_vMyStateCaches)
+	{
+		stateCache.reset();
+	}
+
+	if (m_vPackets.empty())
+	{
+		return;
+	}
+
+	_radixSort();
+
+	// Chunk i is always recorded into slot i, so a slot is never used by two threads at once
+	size_t packetsPerChunk = (m_vSortEntries.size() + chunkCount - 1) / chunkCount;
+	m_vVkSecondaryCommandBuffers.resize(chunkCount);
+	m_vRecordingTasks.clear();
+
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		size_t first = chunk * packetsPerChunk;
+		size_t last = std::min(first + packetsPerChunk, m_vSortEntries.size());
+
+		m_vRecordingTasks.push_back(threadPool.enqueue([this, &renderer, chunk, first, last]()
+		{
+			MyCpuScope scope{ "record chunk" };
+
+			VkCommandBuffer secondaryCommandBuffer = renderer.beginSecondaryCommandBuffer(static_cast<uint32_t>(chunk));
+			_record(secondaryCommandBuffer, first, last, m_vMyStateCaches[chunk]);
+			renderer.endSecondaryCommandBuffer(secondaryCommandBuffer);
+
+			m_vVkSecondaryCommandBuffers[chunk] = secondaryCommandBuffer;
+		}));
+	}
+
+	// get() rethrows if recording failed on a worker thread
+	for (auto& task : m_vRecordingTasks)
+	{
+		task.get();
+	}
+
+	// Executed in chunk order, so the sort order is kept across the secondary command buffers
+	renderer.executeSecondaryCommandBuffers(commandBuffer, m_vVkSecondaryCommandBuffers);
+
+	m_vPackets.clear();
+}
+
+MyRenderStateCache::Stats MyRenderQueue::lastFlushStats() const
+{
+	MyRenderStateCache::Stats stats{};
+	for (const auto& stateCache : m_vMyStateCaches)
+	{
+		stats += stateCache.stats();
+	}
+
+	return stats;
+}
+
+void MyRenderQueue::_record(VkCommandBuffer commandBuffer, size_t first, size_t last, MyRenderStateCache& stateCache)
+{
+	for (size_t i = first; i < last; i++)
+	{
+		MyDrawPacket& packet = m_vPackets[m_vSortEntries[i].index];
+
+		stateCache.bindPipeline(commandBuffer, *packet.pipeline, packet.topology);
+
+		if (packet.pushConstantSize > 0)
+		{
+			vkCmdPushConstants(
+				commandBuffer,
+				packet.pipelineLayout,
+				packet.pushConstantStages,
+				0,
+				packet.pushConstantSize,
+				packet.pushConstantData);
+		}
+
+		stateCache.bindModel(commandBuffer, *packet.model);
+		packet.model->draw(commandBuffer);
+	}
+}
+
+void MyRenderQueue::_radixSort()
+{
+	const size_t count = m_vPackets.size();
+
+	m_vSortEntries.resize(count);
+	m_vSortScratch.resize(count);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_vSortEntries[i] = { m_vPackets[i].sortKey, i };
+	}
+
+	// LSD radix sort with 8 bits per pass. It is stable, so packets with the
+	// same key are still recorded in the order they were submitted
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t histogram[256] = {};
+		for (const auto& entry : m_vSortEntries)
+		{
+			histogram[(entry.key >> shift) & 0xFF]++;
+		}
+
+		// Every key has the same digit (e.g. the unused high bits of the pass), nothing to do
+		if (histogram[(m_vSortEntries[0].key >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (size_t& bucket : histogram)
+		{
+			size_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+
+		for (const auto& entry : m_vSortEntries)
+		{
+			m_vSortScratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+		}
+
+		m_vSortEntries.swap(m_vSortScratch);
+	}
+}
@@ -0,0 +1,153 @@
+#ifndef __MY_RENDER_QUEUE_H__
+#define __MY_RENDER_QUEUE_H__
+
+#include "my_gpu_profiler.h"
+#include "my_pipeline.h"
+#include "my_model.h"
+#include "my_name_table.h"
+#include "my_renderer.h"
+#include "my_thread_pool.h"
+
+// use radian rather degree for angle
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//
+// One draw call submitted by a render system. Nothing is recorded at submission time,
+// the render queue sorts the packets by sortKey and records them in one go
+//
+struct MyDrawPacket
+{
+	// Minimum maxPushConstantsSize guaranteed by the Vulkan spec
+	static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
+
+	uint64_t            sortKey = 0;
+	MyPipeline*         pipeline = nullptr;
+	MyModel*            model = nullptr;
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST; // only used if the pipeline has dynamic topology
+	VkPipelineLayout    pipelineLayout = VK_NULL_HANDLE;
+	VkShaderStageFlags  pushConstantStages = 0;
+	uint32_t            pushConstantSize = 0;
+	alignas(16) char    pushConstantData[MAX_PUSH_CONSTANT_SIZE];
+
+	template <typename T>
+	void setPushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, const T& data)
+	{
+		static_assert(sizeof(T) <= MAX_PUSH_CONSTANT_SIZE, "Push constant data is too big for a draw packet");
+
+		pipelineLayout = layout;
+		pushConstantStages = stages;
+		pushConstantSize = sizeof(T);
+		memcpy(pushConstantData, &data, sizeof(T));
+	}
+};
+
+//
+// Remember what is currently bound on a command buffer so the same pipeline,
+// vertex buffer or index buffer is never bound twice in a row
+//
+class MyRenderStateCache
+{
+public:
+	struct Stats
+	{
+		uint32_t pipelineBinds = 0;
+		uint32_t topologyChanges = 0;
+		uint32_t vertexBufferBinds = 0;
+		uint32_t indexBufferBinds = 0;
+		uint32_t skippedBinds = 0;
+
+		Stats& operator+=(const Stats& other);
+	};
+
+	void reset();
+	void bindPipeline(VkCommandBuffer commandBuffer, MyPipeline& pipeline, VkPrimitiveTopology topology);
+	void bindModel(VkCommandBuffer commandBuffer, MyModel& model);
+
+	const Stats& stats() const { return m_stats; }
+
+private:
+	VkPipeline          m_vkPipeline = VK_NULL_HANDLE;
+	VkPrimitiveTopology m_vkTopology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+	VkBuffer            m_vkVertexBuffer = VK_NULL_HANDLE;
+	VkDeviceSize        m_vkVertexOffset = 0;
+	VkBuffer            m_vkIndexBuffer = VK_NULL_HANDLE;
+	Stats               m_stats{};
+};
+
+//
+// Collect the draw packets of a frame, radix sort them once by their 64-bit key and
+// emit the commands through a state cache
+//
+// Sort key layout (most significant first):
+//   [63..56] pass      - the order the render systems are called in, decides what is on top
+//   [55..40] pipeline  - group the draws that share a pipeline
+//   [39..24] model     - group the draws that share vertex and index buffers
+//   [23..0]  depth     - front to back inside the same pipeline and model
+//
+class MyRenderQueue
+{
+public:
+	MyRenderQueue() = default;
+
+	MyRenderQueue(const MyRenderQueue&) = delete;
+	MyRenderQueue& operator=(const MyRenderQueue&) = delete;
+
+	static uint64_t makeSortKey(uint32_t pass, uint32_t pipelineID, uint32_t modelID, float depth);
+
+	// Normalized depth of the object origin, transform is projection * view * model
+	static float    depthOf(const glm::mat4& transform);
+
+	void   submit(const MyDrawPacket& packet);
+	size_t size() const { return m_vPackets.size(); }
+
+	// Name of the GPU profiler scope of a pass, "pass <n>" if not set
+	void   setPassName(uint32_t pass, const std::string& name);
+
+	// Record every packet into the command buffer on the calling thread.
+	// With a profiler, each pass is timed in its own scope
+	void   flush(VkCommandBuffer commandBuffer, MyGpuProfiler* pGpuProfiler = nullptr);
+
+	// Split the sorted packets into one chunk per recording slot of the renderer, record
+	// each chunk into a secondary command buffer on the thread pool and execute them in
+	// order from the primary command buffer
+	void   flush(VkCommandBuffer commandBuffer, MyRenderer& renderer, MyThreadPool& threadPool);
+
+	MyRenderStateCache::Stats lastFlushStats() const;
+
+private:
+	struct SortEntry
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	// Small chunks are not worth a secondary command buffer
+	static constexpr size_t MIN_PACKETS_PER_CHUNK = 64;
+
+	static uint32_t _passOf(uint64_t sortKey) { return static_cast<uint32_t>(sortKey >> 56); }
+
+	MyNameID        _passName(uint32_t pass);
+
+	void _radixSort();
+	void _record(VkCommandBuffer commandBuffer, size_t first, size_t last, MyRenderStateCache& stateCache);
+
+	std::vector<MyDrawPacket>       m_vPackets;
+	std::vector<SortEntry>          m_vSortEntries;
+	std::vector<SortEntry>          m_vSortScratch;
+	std::vector<MyNameID>           m_vPassNames;
+
+	// One per chunk, the secondary command buffers do not share any bound state
+	std::vector<MyRenderStateCache> m_vMyStateCaches;
+	std::vector<VkCommandBuffer>    m_vVkSecondaryCommandBuffers;
+	std::vector<std::future<void>>  m_vRecordingTasks;
+};
+
+#endif
@@ -1,13 +1,18 @@
 #include "my_renderer.h"
+#include "my_tracer.h"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <iostream>
 #include <stdexcept>
 
-MyRenderer::MyRenderer(MyWindow& window, MyDevice& device)
+MyRenderer::MyRenderer(MyWindow& window, MyDevice& device, uint32_t recordingSlots, uint32_t framesInFlight)
     : m_myWindow{ window },
-	  m_myDevice{ device }
+	  m_myDevice{ device },
+	  m_iFramesInFlight{ framesInFlight },
+	  m_iRecordingSlots{ recordingSlots }
 {
     m_iCurrentImageIndex = 0;
     m_iCurrentFrameIndex = 0;
@@ -15,13 +20,39 @@ MyRenderer::MyRenderer(MyWindow& window, MyDevice& device)
 
     _recreateSwapChain();
     _createCommandBuffers();
+    _createSecondaryCommandBuffers();
+
+    std::cout << "frame pacing: " << (m_mySwapChain->usesTimelineSemaphore() ? "timeline semaphore" : "fences")
+              << ", " << m_iFramesInFlight << " frames in flight" << std::endl;
 }
 
 MyRenderer::~MyRenderer() 
 { 
+    // The application waits for the device to be idle before it is destroyed
+    m_vPendingReleases.clear();
+
+    _destroySecondaryCommandBuffers();
     _freeCommandBuffers();
 }
 
+void MyRenderer::releaseAfterFrames(std::shared_ptr<void> resource)
+{
+    if (resource == nullptr)
+    {
+        return;
+    }
+
+    m_vPendingReleases.push_back(PendingRelease{ m_mySwapChain->frameNumber(), std::move(resource) });
+}
+
+void MyRenderer::_releaseCompletedResources()
+{
+    m_vPendingReleases.erase(
+        std::remove_if(m_vPendingReleases.begin(), m_vPendingReleases.end(),
+            [this](const PendingRelease& pending) { return m_mySwapChain->isFrameComplete(pending.frameNumber); }),
+        m_vPendingReleases.end());
+}
+
 void MyRenderer::_recreateSwapChain()
 {
     // make sure the window's size is not 0
@@ -32,11 +63,13 @@ void MyRenderer::_recreateSwapChain()
         m_myWindow.waitEvents();
     }
 
+    MY_TRACE_SCOPE_ARGS("swapchain", "recreateSwapChain", "extent=%ux%u", extent.width, extent.height);
+
     vkDeviceWaitIdle(m_myDevice.device());
 
     if (m_mySwapChain == nullptr)
     {
-        m_mySwapChain = std::make_unique<MySwapChain>(m_myDevice, extent);
+        m_mySwapChain = std::make_unique<MySwapChain>(m_myDevice, extent, m_iFramesInFlight);
     }
     else
     {
@@ -52,7 +85,7 @@ void MyRenderer::_recreateSwapChain()
 
 void MyRenderer::_createCommandBuffers()
 {
-    m_vVkCommandBuffers.resize(MySwapChain::MAX_FRAMES_IN_FLIGHT);
+    m_vVkCommandBuffers.resize(m_iFramesInFlight);
 
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -77,6 +110,58 @@ void MyRenderer::_freeCommandBuffers()
     m_vVkCommandBuffers.clear();
 }
 
+void MyRenderer::_createSecondaryCommandBuffers()
+{
+    if (m_iRecordingSlots == 0)
+    {
+        return;
+    }
+
+    // Command pools are externally synchronized, so every slot of every frame gets its own
+    // pool. Then the threads never share a pool and a whole frame can be reset at once
+    QueueFamilyIndices queueFamilyIndices = m_myDevice.findPhysicalQueueFamilies();
+    uint32_t count = m_iFramesInFlight * m_iRecordingSlots;
+
+    m_vVkSecondaryCommandPools.resize(count);
+    m_vVkSecondaryCommandBuffers.resize(count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        if (vkCreateCommandPool(m_myDevice.device(), &poolInfo, nullptr, &m_vVkSecondaryCommandPools[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create secondary command pool!");
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandPool = m_vVkSecondaryCommandPools[i];
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(m_myDevice.device(), &allocInfo, &m_vVkSecondaryCommandBuffers[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate secondary command buffers!");
+        }
+    }
+}
+
+void MyRenderer::_destroySecondaryCommandBuffers()
+{
+    // Destroying the pool frees its command buffers as well
+    for (auto commandPool : m_vVkSecondaryCommandPools)
+    {
+        vkDestroyCommandPool(m_myDevice.device(), commandPool, nullptr);
+    }
+
+    m_vVkSecondaryCommandPools.clear();
+    m_vVkSecondaryCommandBuffers.clear();
+}
+
 VkCommandBuffer MyRenderer::beginFrame()
 {
     assert(!m_bIsFrameStarted && "Can't call beginFrame while already in progress");
@@ -94,6 +179,19 @@ VkCommandBuffer MyRenderer::beginFrame()
     }
 
     m_bIsFrameStarted = true;
+    m_iCurrentFrameIndex = m_mySwapChain->frameIndex();
+
+    _releaseCompletedResources();
+
+    // The frame that last used this frame index has been waited in acquireNextImage, so the
+    // GPU is done with the secondary command buffers recorded the last time it was used
+    for (uint32_t slot = 0; slot < m_iRecordingSlots; slot++)
+    {
+        vkResetCommandPool(
+            m_myDevice.device(), 
+            m_vVkSecondaryCommandPools[m_iCurrentFrameIndex * m_iRecordingSlots + slot], 
+            0);
+    }
 
     auto commandBuffer = _currentCommandBuffer();
     VkCommandBufferBeginInfo beginInfo{};
@@ -128,7 +226,6 @@ void MyRenderer::endFrame()
     }
 
     m_bIsFrameStarted = false;
-    m_iCurrentFrameIndex = (m_iCurrentFrameIndex + 1) % MySwapChain::MAX_FRAMES_IN_FLIGHT;
 }
 
 void MyRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
@@ -152,8 +249,20 @@ void MyRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
+    // With parallel recording the primary command buffer only executes the secondary
+    // command buffers, which set their own viewport and scissor
+    if (isParallelRecording())
+    {
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        return;
+    }
+
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    _setViewportScissor(commandBuffer);
+}
 
+void MyRenderer::_setViewportScissor(VkCommandBuffer commandBuffer)
+{
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -175,3 +284,56 @@ void MyRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer)
     vkCmdEndRenderPass(commandBuffer);
 }
 
+VkCommandBuffer MyRenderer::beginSecondaryCommandBuffer(uint32_t slot)
+{
+    assert(m_bIsFrameStarted && "Can't call beginSecondaryCommandBuffer if frame is not in progress");
+    assert(slot < m_iRecordingSlots && "Secondary command buffer slot out of range");
+
+    auto commandBuffer = m_vVkSecondaryCommandBuffers[m_iCurrentFrameIndex * m_iRecordingSlots + slot];
+
+    // Secondary command buffers continue the swap chain render pass
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = m_mySwapChain->renderPass();
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = m_mySwapChain->frameBuffer(m_iCurrentImageIndex);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to begin recording secondary command buffer!");
+    }
+
+    // Dynamic states are not inherited from the primary command buffer
+    _setViewportScissor(commandBuffer);
+
+    return commandBuffer;
+}
+
+void MyRenderer::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to record secondary command buffer!");
+    }
+}
+
+void MyRenderer::executeSecondaryCommandBuffers(VkCommandBuffer commandBuffer, const std::vector<VkCommandBuffer>& secondaryCommandBuffers)
+{
+    assert(m_bIsFrameStarted && "Can't call executeSecondaryCommandBuffers if frame is not in progress");
+    assert(
+        commandBuffer == _currentCommandBuffer() &&
+        "Can't execute secondary command buffers on command buffer from a different frame");
+
+    if (secondaryCommandBuffers.empty())
+    {
+        return;
+    }
+
+    vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+}
+
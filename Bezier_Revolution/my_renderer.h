@@ -14,7 +14,13 @@
 class MyRenderer 
 {
 public:
-    MyRenderer(MyWindow& window, MyDevice& device);
+    // recordingSlots > 0 enables parallel recording: each slot gets its own command pool
+    // per frame in flight and records into a secondary command buffer
+    MyRenderer(
+        MyWindow& window, 
+        MyDevice& device, 
+        uint32_t recordingSlots = 0, 
+        uint32_t framesInFlight = MySwapChain::DEFAULT_FRAMES_IN_FLIGHT);
     ~MyRenderer();
 
     MyRenderer(const MyRenderer&) = delete;
@@ -28,16 +34,38 @@ public:
     void            beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
     void            endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+    // Parallel recording. Different slots can be recorded on different threads at the
+    // same time, but one slot must only be used by one thread within a frame
+    bool            isParallelRecording() const { return m_iRecordingSlots > 0; }
+    uint32_t        recordingSlots()      const { return m_iRecordingSlots; }
+    VkCommandBuffer beginSecondaryCommandBuffer(uint32_t slot);
+    void            endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+    void            executeSecondaryCommandBuffers(VkCommandBuffer commandBuffer, const std::vector<VkCommandBuffer>& secondaryCommandBuffers);
+
     int frameIndex() const 
 	{
         assert(m_bIsFrameStarted && "Cannot get frame index when frame not in progress");
         return m_iCurrentFrameIndex;
     }
+
+    // GPU progress. Any subsystem can remember frameNumber() when it last used a resource
+    // and later ask isFrameComplete, which never blocks
+    uint32_t framesInFlight()                      const { return m_mySwapChain->framesInFlight(); }
+    uint64_t frameNumber()                         const { return m_mySwapChain->frameNumber(); }
+    bool     isFrameComplete(uint64_t frameNumber) const { return m_mySwapChain->isFrameComplete(frameNumber); }
+
+    // Keeps the resource alive until every frame submitted so far, and the one being
+    // recorded, is complete. For models and buffers replaced while frames are in flight
+    void     releaseAfterFrames(std::shared_ptr<void> resource);
 	
 private:
     void _createCommandBuffers();
     void _freeCommandBuffers();
+    void _createSecondaryCommandBuffers();
+    void _destroySecondaryCommandBuffers();
+    void _setViewportScissor(VkCommandBuffer commandBuffer);
     void _recreateSwapChain();
+    void _releaseCompletedResources();
 
     VkCommandBuffer _currentCommandBuffer() const
     {
@@ -45,11 +73,24 @@ private:
         return m_vVkCommandBuffers[m_iCurrentFrameIndex];
     }
 
+    struct PendingRelease
+    {
+        uint64_t              frameNumber;
+        std::shared_ptr<void> resource;
+    };
+
     MyWindow&                    m_myWindow;
     MyDevice&                    m_myDevice;
+    uint32_t                     m_iFramesInFlight;
     std::unique_ptr<MySwapChain> m_mySwapChain;
+    std::vector<PendingRelease>  m_vPendingReleases;
     std::vector<VkCommandBuffer> m_vVkCommandBuffers;
 
+    // Indexed by frameIndex * m_iRecordingSlots + slot
+    uint32_t                     m_iRecordingSlots;
+    std::vector<VkCommandPool>   m_vVkSecondaryCommandPools;
+    std::vector<VkCommandBuffer> m_vVkSecondaryCommandBuffers;
+
     uint32_t                     m_iCurrentImageIndex;
     int                          m_iCurrentFrameIndex;
     bool                         m_bIsFrameStarted;
@@ -17,38 +17,29 @@ struct MySimplePushConstantData
     glm::mat4 modelMatrix{ 1.0f };
 };
 
-MySimpleRenderSystem::MySimpleRenderSystem(MyDevice& device, VkRenderPass renderPass)
+MySimpleRenderSystem::MySimpleRenderSystem(MyDevice& device, MyPipelineLibrary& pipelineLibrary, VkRenderPass renderPass)
     : m_myDevice{ device } 
 {
-    _createPipelineLayout();
-    _createPipeline(renderPass);
+    _createPipelineLayout(pipelineLibrary);
+    _createPipeline(pipelineLibrary, renderPass);
 }
 
 MySimpleRenderSystem::~MySimpleRenderSystem()
 {
-    vkDestroyPipelineLayout(m_myDevice.device(), m_vkPipelineLayout, nullptr);
+    // The pipeline layout is owned by the pipeline library
 }
 
-void MySimpleRenderSystem::_createPipelineLayout() 
+void MySimpleRenderSystem::_createPipelineLayout(MyPipelineLibrary& pipelineLibrary) 
 {
     VkPushConstantRange pushConstantRange{};
     pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
     pushConstantRange.offset = 0;
     pushConstantRange.size = sizeof(MySimplePushConstantData);
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0;
-    pipelineLayoutInfo.pSetLayouts = nullptr;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-    if (vkCreatePipelineLayout(m_myDevice.device(), &pipelineLayoutInfo, nullptr, &m_vkPipelineLayout) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
+    m_vkPipelineLayout = pipelineLibrary.getPipelineLayout(pushConstantRange);
 }
 
-void MySimpleRenderSystem::_createPipeline(VkRenderPass renderPass)
+void MySimpleRenderSystem::_createPipeline(MyPipelineLibrary& pipelineLibrary, VkRenderPass renderPass)
 {
     assert(m_vkPipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
@@ -57,30 +48,34 @@ void MySimpleRenderSystem::_createPipeline(VkRenderPass renderPass)
     pipelineConfig.renderPass = renderPass;
     pipelineConfig.pipelineLayout = m_vkPipelineLayout;
 
-    m_pMyPipeline = std::make_unique<MyPipeline>(
-        m_myDevice,
+    m_myPipeline = pipelineLibrary.getPipeline(
         "shaders/simple_shader.vert.spv",
         "shaders/simple_shader.frag.spv",
         pipelineConfig);
 }
 
-void MySimpleRenderSystem::renderGameObjects(MyFrameInfo& frameInfo, std::vector<MyGameObject>& gameObjects)
+void MySimpleRenderSystem::renderGameObjects(MyFrameInfo& frameInfo, MyWorld& world)
 {
-    m_pMyPipeline->bind(frameInfo.commandBuffer);
+    // Skip drawing until the pipeline is compiled instead of stalling the frame
+    if (!m_myPipeline.isReady())
+        return;
+
     auto projectionView = frameInfo.camera.projectionMatrix() * frameInfo.camera.viewMatrix();
 
-    for (auto& obj : gameObjects)
+    // Only the surface entities are visited
+    world.each<SurfaceComponent, ModelComponent, TransformComponent>(
+        [&](SurfaceComponent&, ModelComponent& obj, TransformComponent& transform)
     {
         // Note: X to the right, Y up and Z out of the screen
-        // obj.transform.rotation.y = glm::mod(obj.transform.rotation.y + 0.0005f, glm::two_pi<float>());  // Y up
-        // obj.transform.rotation.x = glm::mod(obj.transform.rotation.x + 0.0005f, glm::two_pi<float>());  // X to the right
-        // obj.transform.rotation.z = glm::mod(obj.transform.rotation.z + 0.0005f, glm::two_pi<float>());  // Z out of the screen
+        // transform.rotation.y = glm::mod(transform.rotation.y + 0.0005f, glm::two_pi<float>());  // Y up
+        // transform.rotation.x = glm::mod(transform.rotation.x + 0.0005f, glm::two_pi<float>());  // X to the right
+        // transform.rotation.z = glm::mod(transform.rotation.z + 0.0005f, glm::two_pi<float>());  // Z out of the screen
 
-        if (obj.name() == std::string("bezier_surface") && obj.model != nullptr)
+        if (obj.model != nullptr)
         {
             MySimplePushConstantData push{};
 
-            auto modelMatrix = obj.transform.mat4();
+            auto modelMatrix = transform.mat4();
 
             // test
             //modelMatrix = glm::mat4(1.0f);
@@ -93,17 +88,23 @@ void MySimpleRenderSystem::renderGameObjects(MyFrameInfo& frameInfo, std::vector
             push.transform = projectionView * modelMatrix;
             push.modelMatrix = modelMatrix;
 
-            vkCmdPushConstants(
-                frameInfo.commandBuffer,
-                m_vkPipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(MySimplePushConstantData),
-                &push);
-
-            obj.model->bind(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+            // Upload any updated vertex range here on the main thread,
+            // the render queue may record the packet on a worker thread
+            obj.model->prepareFrame(frameInfo.frameIndex);
+
+            // Recorded later by the render queue in sorted order
+            MyDrawPacket packet{};
+            packet.sortKey = MyRenderQueue::makeSortKey(
+                frameInfo.pass, 
+                m_myPipeline.pipeline().id(), 
+                obj.model->id(), 
+                MyRenderQueue::depthOf(push.transform));
+            packet.pipeline = &m_myPipeline.pipeline();
+            packet.model = obj.model.get();
+            packet.setPushConstants(m_vkPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, push);
+
+            frameInfo.renderQueue.submit(packet);
         }
-    }
+    });
 }
 
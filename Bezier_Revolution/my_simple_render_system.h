@@ -2,8 +2,10 @@
 #define __MY_SIMPLE_RENDER_SYSTEM_H__
 
 #include "my_device.h"
+#include "my_ecs.h"
 #include "my_game_object.h"
 #include "my_pipeline.h"
+#include "my_pipeline_library.h"
 #include "my_camera.h"
 #include "my_frame_info.h"
 
@@ -15,21 +17,22 @@
 class MySimpleRenderSystem
 {
 public:
-	MySimpleRenderSystem(MyDevice& device, VkRenderPass renderPass);
+	MySimpleRenderSystem(MyDevice& device, MyPipelineLibrary& pipelineLibrary, VkRenderPass renderPass);
 	~MySimpleRenderSystem();
 
 	MySimpleRenderSystem(const MySimpleRenderSystem&) = delete;
 	MySimpleRenderSystem& operator=(const MySimpleRenderSystem&) = delete;
 
-	void renderGameObjects(MyFrameInfo& frameInfo, std::vector<MyGameObject>& gameObjects);
+	void renderGameObjects(MyFrameInfo& frameInfo, MyWorld& world);
 
 private:
-	void _createPipelineLayout();
-	void _createPipeline(VkRenderPass renderPass);
+	void _createPipelineLayout(MyPipelineLibrary& pipelineLibrary);
+	void _createPipeline(MyPipelineLibrary& pipelineLibrary, VkRenderPass renderPass);
 
 	MyDevice&                   m_myDevice;
 
-	std::unique_ptr<MyPipeline> m_pMyPipeline;
+	// Both are shared with other render systems through the pipeline library
+	MyPipelineHandle            m_myPipeline;
 	VkPipelineLayout            m_vkPipelineLayout;
 };
 
@@ -1,26 +1,33 @@
 #include "my_swap_chain.h"
+#include "my_cpu_profiler.h"
 
 // std
 #include <array>
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <limits>
 #include <set>
 #include <stdexcept>
+#include <string>
 
 
-MySwapChain::MySwapChain(MyDevice &deviceRef, VkExtent2D extent)
+MySwapChain::MySwapChain(MyDevice &deviceRef, VkExtent2D extent, uint32_t framesInFlight)
     : m_myDevice{deviceRef}, 
-      m_vkWindowExtent{extent}
+      m_vkWindowExtent{extent},
+      m_iFramesInFlight{framesInFlight}
 {
+    assert(framesInFlight >= 2 && framesInFlight <= MAX_FRAMES_IN_FLIGHT && "Frames in flight must be between 2 and 4");
     _init();
 }
 
 MySwapChain::MySwapChain(MyDevice& deviceRef, VkExtent2D extent, std::shared_ptr<MySwapChain> previous)
     : m_myDevice{ deviceRef }, 
       m_vkWindowExtent{ extent },
-      m_pMyOldSwapChain{ previous }
+      m_pMyOldSwapChain{ previous },
+      m_iFramesInFlight{ previous->m_iFramesInFlight },
+      m_iFrameNumber{ previous->m_iFrameNumber }
 {
     _init();
 
@@ -30,7 +37,11 @@ MySwapChain::MySwapChain(MyDevice& deviceRef, VkExtent2D extent, std::shared_ptr
 
 void MySwapChain::_init()
 {
-    _createSwapChain();
+    if (m_myDevice.isHeadless())
+        _createOffscreenImages();
+    else
+        _createSwapChain();
+
     _createImageViews();
     _createRenderPass();
     _createDepthResources();
@@ -53,11 +64,17 @@ MySwapChain::~MySwapChain()
         m_vkSwapChain = nullptr;
     }
     
-    for (int i = 0; i < m_vVkDepthImages.size(); i++)
+    for (size_t i = 0; i < m_vVkSwapChainImageMemorys.size(); i++)
+    {
+        vkDestroyImage(m_myDevice.device(), m_vVkSwapChainImages[i], nullptr);
+        m_myDevice.freeMemory(m_vVkSwapChainImageMemorys[i]);
+    }
+    
+    for (size_t i = 0; i < m_vVkDepthImages.size(); i++)
     {
         vkDestroyImageView(m_myDevice.device(), m_vVkDepthImageViews[i], nullptr);
         vkDestroyImage(m_myDevice.device(), m_vVkDepthImages[i], nullptr);
-        vkFreeMemory(m_myDevice.device(), m_vVkDepthImageMemorys[i], nullptr);
+        m_myDevice.freeMemory(m_vVkDepthImageMemorys[i]);
     }
     
     for (auto framebuffer : m_vVkSwapChainFramebuffers)
@@ -68,29 +85,100 @@ MySwapChain::~MySwapChain()
     vkDestroyRenderPass(m_myDevice.device(), m_vkRenderPass, nullptr);
     
     // cleanup synchronization objects
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (size_t i = 0; i < m_iFramesInFlight; i++)
     {
         vkDestroySemaphore(m_myDevice.device(), m_vVkRenderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(m_myDevice.device(), m_vVkImageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(m_myDevice.device(), m_vVkInFlightFences[i], nullptr);
+    }
+    
+    for (auto fence : m_vVkInFlightFences)
+    {
+        vkDestroyFence(m_myDevice.device(), fence, nullptr);
+    }
+    
+    if (m_vkTimelineSemaphore != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(m_myDevice.device(), m_vkTimelineSemaphore, nullptr);
+    }
+}
+
+bool MySwapChain::isFrameComplete(uint64_t frameNumber) const
+{
+    if (frameNumber >= m_iFrameNumber)
+    {
+        return false;  // not submitted yet
+    }
+    
+    if (m_vkTimelineSemaphore != VK_NULL_HANDLE)
+    {
+        uint64_t completed = 0;
+        vkGetSemaphoreCounterValue(m_myDevice.device(), m_vkTimelineSemaphore, &completed);
+        return completed >= frameNumber;
+    }
+    
+    // The fence was reused by a later frame, which waited for this one first, or the frame
+    // was submitted before the swap chain was recreated, which waits for the device to be idle
+    size_t slot = frameNumber % m_iFramesInFlight;
+    if (m_vSlotFrameNumbers[slot] != frameNumber)
+    {
+        return true;
+    }
+    
+    return vkGetFenceStatus(m_myDevice.device(), m_vVkInFlightFences[slot]) == VK_SUCCESS;
+}
+
+void MySwapChain::_waitForFrame(uint64_t frameNumber)
+{
+    if (frameNumber == 0 || isFrameComplete(frameNumber))
+    {
+        return;
+    }
+    
+    if (m_vkTimelineSemaphore != VK_NULL_HANDLE)
+    {
+        VkSemaphoreWaitInfo waitInfo = {};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_vkTimelineSemaphore;
+        waitInfo.pValues = &frameNumber;
+        vkWaitSemaphores(m_myDevice.device(), &waitInfo, std::numeric_limits<uint64_t>::max());
+    }
+    else
+    {
+        vkWaitForFences(
+            m_myDevice.device(),
+            1,
+            &m_vVkInFlightFences[frameNumber % m_iFramesInFlight],
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max());
     }
 }
 
 VkResult MySwapChain::acquireNextImage(uint32_t *imageIndex)
 {
-    // Note: CPU will wait here at fences
-    vkWaitForFences(
-        m_myDevice.device(),
-        1,
-        &m_vVkInFlightFences[m_iCurrentFrame],
-        VK_TRUE,
-        std::numeric_limits<uint64_t>::max());
+    // Note: CPU will wait here for the frame that last used this frame index
+    {
+        MyCpuScope scope{ "fence wait" };
+        if (m_iFrameNumber > m_iFramesInFlight)
+        {
+            _waitForFrame(m_iFrameNumber - m_iFramesInFlight);
+        }
+    }
+    
+    // The offscreen images are used in turn, there is nothing to wait for
+    if (m_myDevice.isHeadless())
+    {
+        *imageIndex = m_iNextOffscreenImage;
+        m_iNextOffscreenImage = (m_iNextOffscreenImage + 1) % static_cast<uint32_t>(imageCount());
+        return VK_SUCCESS;
+    }
     
+    MyCpuScope scope{ "acquire" };
     VkResult result = vkAcquireNextImageKHR(
         m_myDevice.device(),
         m_vkSwapChain,
         std::numeric_limits<uint64_t>::max(),
-        m_vVkImageAvailableSemaphores[m_iCurrentFrame],  // must be a not signaled semaphore
+        m_vVkImageAvailableSemaphores[frameIndex()],  // must be a not signaled semaphore
         VK_NULL_HANDLE,
         imageIndex);
     
@@ -99,40 +187,75 @@ VkResult MySwapChain::acquireNextImage(uint32_t *imageIndex)
 
 VkResult MySwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex)
 {
-    if (m_vVkImagesInFlight[*imageIndex] != VK_NULL_HANDLE)
-    {
-        vkWaitForFences(m_myDevice.device(), 1, &m_vVkImagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-    }
+    // The image may still be rendered by an earlier frame with a different frame index
+    _waitForFrame(m_vImageFrameNumbers[*imageIndex]);
+    m_vImageFrameNumbers[*imageIndex] = m_iFrameNumber;
     
-    m_vVkImagesInFlight[*imageIndex] = m_vVkInFlightFences[m_iCurrentFrame];
+    int frame = frameIndex();
     
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     
-    VkSemaphore waitSemaphores[] = {m_vVkImageAvailableSemaphores[m_iCurrentFrame]};
+    // Nothing is acquired or presented when headless, so only the
+    // timeline semaphore or the fence is signaled
+    uint32_t semaphoreCount = m_myDevice.isHeadless() ? 0 : 1;
+    
+    VkSemaphore waitSemaphores[] = {m_vVkImageAvailableSemaphores[frame]};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = semaphoreCount;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
     
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = buffers;
     
-    VkSemaphore signalSemaphores[] = {m_vVkRenderFinishedSemaphores[m_iCurrentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    // The timeline semaphore goes after the binary one, whose signal value is ignored
+    VkSemaphore signalSemaphores[] = {m_vVkRenderFinishedSemaphores[frame], m_vkTimelineSemaphore};
+    uint64_t signalValues[] = {0, m_iFrameNumber};
+    
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    
+    VkFence fence = VK_NULL_HANDLE;
+    if (m_vkTimelineSemaphore != VK_NULL_HANDLE)
+    {
+        uint32_t signalCount = semaphoreCount + 1;
+        timelineInfo.signalSemaphoreValueCount = signalCount;
+        timelineInfo.pSignalSemaphoreValues = signalValues + (1 - semaphoreCount);
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.signalSemaphoreCount = signalCount;
+        submitInfo.pSignalSemaphores = signalSemaphores + (1 - semaphoreCount);
+    }
+    else
+    {
+        submitInfo.signalSemaphoreCount = semaphoreCount;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+        
+        fence = m_vVkInFlightFences[frame];
+        vkResetFences(m_myDevice.device(), 1, &fence);
+        m_vSlotFrameNumbers[frame] = m_iFrameNumber;
+    }
+    
+    {
+        MyCpuScope scope{ "submit" };
+        if (vkQueueSubmit(m_myDevice.graphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS) 
+        {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+    }
+    
+    m_iFrameNumber++;
     
-    vkResetFences(m_myDevice.device(), 1, &m_vVkInFlightFences[m_iCurrentFrame]);
-    if (vkQueueSubmit(m_myDevice.graphicsQueue(), 1, &submitInfo, m_vVkInFlightFences[m_iCurrentFrame]) != VK_SUCCESS) 
+    if (m_myDevice.isHeadless())
     {
-        throw std::runtime_error("failed to submit draw command buffer!");
+        return VK_SUCCESS;
     }
     
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.pWaitSemaphores = &m_vVkRenderFinishedSemaphores[frame];
     
     VkSwapchainKHR swapChains[] = { m_vkSwapChain };
     presentInfo.swapchainCount = 1;
@@ -140,9 +263,11 @@ VkResult MySwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint3
     
     presentInfo.pImageIndices = imageIndex;
     
-    auto result = vkQueuePresentKHR(m_myDevice.presentQueue(), &presentInfo);
-    
-    m_iCurrentFrame = (m_iCurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    VkResult result;
+    {
+        MyCpuScope scope{ "present" };
+        result = vkQueuePresentKHR(m_myDevice.presentQueue(), &presentInfo);
+    }
     
     return result;
 }
@@ -214,6 +339,49 @@ void MySwapChain::_createSwapChain()
     m_vkSwapChainExtent = extent;
 }
 
+void MySwapChain::_createOffscreenImages()
+{
+    // Same format the swap chain prefers, so the pipelines and the output match
+    VkFormat format = m_myDevice.findSupportedFormat(
+        {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+    
+    m_vVkSwapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+    m_vVkSwapChainImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+    
+    for (size_t i = 0; i < m_vVkSwapChainImages.size(); i++)
+    {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = m_vkWindowExtent.width;
+        imageInfo.extent.height = m_vkWindowExtent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // can be read back
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.flags = 0;
+        
+        m_myDevice.createImageWithInfo(
+            imageInfo,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            m_vVkSwapChainImages[i],
+            m_vVkSwapChainImageMemorys[i],
+            "offscreen image " + std::to_string(i));
+    }
+    
+    std::cout << "Present mode: Headless" << std::endl;
+    
+    m_vkSwapChainImageFormat = format;
+    m_vkSwapChainExtent = m_vkWindowExtent;
+}
+
 void MySwapChain::_createImageViews() 
 {
     m_vVkSwapChainImageViews.resize(m_vVkSwapChainImages.size());
@@ -261,7 +429,7 @@ void MySwapChain::_createRenderPass()
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = m_myDevice.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
     
     VkAttachmentReference colorAttachmentRef = {};
     colorAttachmentRef.attachment = 0;
@@ -337,7 +505,7 @@ void MySwapChain::_createDepthResources()
     m_vVkDepthImageMemorys.resize(imageCount());
     m_vVkDepthImageViews.resize(imageCount());
 
-    for (int i = 0; i < m_vVkDepthImages.size(); i++)
+    for (size_t i = 0; i < m_vVkDepthImages.size(); i++)
     {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -359,7 +527,8 @@ void MySwapChain::_createDepthResources()
             imageInfo,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             m_vVkDepthImages[i],
-            m_vVkDepthImageMemorys[i]);
+            m_vVkDepthImageMemorys[i],
+            "depth image " + std::to_string(i));
 
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -381,25 +550,54 @@ void MySwapChain::_createDepthResources()
 
 void MySwapChain::_createSyncObjects()
 {
-    m_vVkImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_vVkRenderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_vVkInFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    m_vVkImagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+    m_vVkImageAvailableSemaphores.resize(m_iFramesInFlight);
+    m_vVkRenderFinishedSemaphores.resize(m_iFramesInFlight);
+    m_vImageFrameNumbers.resize(imageCount(), 0);
     
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     
+    for (size_t i = 0; i < m_iFramesInFlight; i++)
+    {
+        if (vkCreateSemaphore(m_myDevice.device(), &semaphoreInfo, nullptr, &m_vVkImageAvailableSemaphores[i]) !=
+              VK_SUCCESS ||
+          vkCreateSemaphore(m_myDevice.device(), &semaphoreInfo, nullptr, &m_vVkRenderFinishedSemaphores[i]) !=
+              VK_SUCCESS) 
+        {
+            throw std::runtime_error("failed to create synchronization objects for a frame!");
+        }
+    }
+    
+    if (m_myDevice.hasTimelineSemaphore())
+    {
+        // The previous swap chain is idle, so every frame before this one is complete
+        VkSemaphoreTypeCreateInfo typeInfo = {};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = m_iFrameNumber - 1;
+        
+        VkSemaphoreCreateInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        timelineInfo.pNext = &typeInfo;
+        
+        if (vkCreateSemaphore(m_myDevice.device(), &timelineInfo, nullptr, &m_vkTimelineSemaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timeline semaphore!");
+        }
+        
+        return;
+    }
+    
+    m_vVkInFlightFences.resize(m_iFramesInFlight);
+    m_vSlotFrameNumbers.resize(m_iFramesInFlight, 0);
+    
     VkFenceCreateInfo fenceInfo = {};
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
     
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (size_t i = 0; i < m_iFramesInFlight; i++)
     {
-        if (vkCreateSemaphore(m_myDevice.device(), &semaphoreInfo, nullptr, &m_vVkImageAvailableSemaphores[i]) !=
-              VK_SUCCESS ||
-          vkCreateSemaphore(m_myDevice.device(), &semaphoreInfo, nullptr, &m_vVkRenderFinishedSemaphores[i]) !=
-              VK_SUCCESS ||
-          vkCreateFence(m_myDevice.device(), &fenceInfo, nullptr, &m_vVkInFlightFences[i]) != VK_SUCCESS) 
+        if (vkCreateFence(m_myDevice.device(), &fenceInfo, nullptr, &m_vVkInFlightFences[i]) != VK_SUCCESS) 
         {
             throw std::runtime_error("failed to create synchronization objects for a frame!");
         }
@@ -12,15 +12,27 @@
 #include <vector>
 
 
+//
+// When the device is headless, the swap chain images are replaced by a ring of offscreen
+// color images that are left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL and never presented.
+//
+// Every submitted frame gets the next frame number, starting at 1. With Vulkan 1.2 the GPU
+// progress is a single timeline semaphore whose value is the last completed frame number,
+// otherwise each frame in flight has a fence as before. Either way isFrameComplete tells
+// whether frame N is done without blocking
+//
 class MySwapChain 
 {
 public:
   
-    // Don't worry about synchronizaiton yet, just remener at most
-    // 2 frames can be submitted for rendering at once
-    static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+    // At most framesInFlight frames, between 2 and MAX_FRAMES_IN_FLIGHT, can be
+    // submitted for rendering at once. Per frame resources are indexed by frameIndex
+    static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+    static constexpr int DEFAULT_FRAMES_IN_FLIGHT = 2;
     
-    MySwapChain(MyDevice &deviceRef, VkExtent2D windowExtent);
+    MySwapChain(MyDevice &deviceRef, VkExtent2D windowExtent, uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
+
+    // Keeps the frames in flight and the frame numbers of previous, which must be idle
     MySwapChain(MyDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<MySwapChain> previous);
     
     ~MySwapChain();
@@ -46,6 +58,13 @@ public:
     
     VkResult acquireNextImage(uint32_t *imageIndex);
     VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+
+    // Frame pacing. frameNumber is the frame the next submit belongs to
+    uint32_t framesInFlight()        const { return m_iFramesInFlight; }
+    uint64_t frameNumber()           const { return m_iFrameNumber; }
+    int      frameIndex()            const { return static_cast<int>(m_iFrameNumber % m_iFramesInFlight); }
+    bool     usesTimelineSemaphore() const { return m_vkTimelineSemaphore != VK_NULL_HANDLE; }
+    bool     isFrameComplete(uint64_t frameNumber) const;
     
     bool compareSwapFormats(const MySwapChain& swapChain) const
     {
@@ -56,11 +75,13 @@ public:
 private:
     void _init();
     void _createSwapChain();
+    void _createOffscreenImages();
     void _createImageViews();
     void _createDepthResources();
     void _createRenderPass();
     void _createFramebuffers();
     void _createSyncObjects();
+    void _waitForFrame(uint64_t frameNumber);
     
     // Helper functions
     VkSurfaceFormatKHR _chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats);
@@ -78,19 +99,28 @@ private:
     std::vector<VkDeviceMemory>  m_vVkDepthImageMemorys;
     std::vector<VkImageView>     m_vVkDepthImageViews;
     std::vector<VkImage>         m_vVkSwapChainImages;
+    std::vector<VkDeviceMemory>  m_vVkSwapChainImageMemorys; // only the offscreen images own their memory
     std::vector<VkImageView>     m_vVkSwapChainImageViews;
     
     MyDevice                    &m_myDevice;
     VkExtent2D                   m_vkWindowExtent;
     
-    VkSwapchainKHR               m_vkSwapChain;
+    VkSwapchainKHR               m_vkSwapChain = VK_NULL_HANDLE;
     std::shared_ptr<MySwapChain> m_pMyOldSwapChain;
     
     std::vector<VkSemaphore>     m_vVkImageAvailableSemaphores;
     std::vector<VkSemaphore>     m_vVkRenderFinishedSemaphores;
+    uint32_t                     m_iFramesInFlight;
+    uint64_t                     m_iFrameNumber = 1;
+    std::vector<uint64_t>        m_vImageFrameNumbers;    // last frame rendered to each image, 0 if none
+    uint32_t                     m_iNextOffscreenImage = 0;
+
+    // Timeline semaphore mode, the value is the last completed frame number
+    VkSemaphore                  m_vkTimelineSemaphore = VK_NULL_HANDLE;
+
+    // Fence mode, used without timeline semaphore support
     std::vector<VkFence>         m_vVkInFlightFences;
-    std::vector<VkFence>         m_vVkImagesInFlight;
-    size_t                       m_iCurrentFrame = 0;
+    std::vector<uint64_t>        m_vSlotFrameNumbers;     // last frame submitted with each fence
 };
 
 #endif
@@ -0,0 +1,66 @@
+#include "my_thread_pool.h"
+#include "my_tracer.h"
+
+// std
+#include <stdexcept>
+
+MyThreadPool::MyThreadPool(uint32_t threadCount)
+{
+	if (threadCount == 0)
+	{
+		throw std::runtime_error("thread pool needs at least one thread!");
+	}
+
+	m_vThreads.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		m_vThreads.emplace_back(&MyThreadPool::_workerLoop, this);
+	}
+}
+
+MyThreadPool::~MyThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_bStopping = true;
+	}
+	m_condition.notify_all();
+
+	// Tasks that are already queued still run before the threads exit
+	for (auto& thread : m_vThreads)
+	{
+		thread.join();
+	}
+}
+
+uint32_t MyThreadPool::defaultThreadCount()
+{
+	// hardware_concurrency returns 0 if it cannot tell
+	uint32_t coreCount = std::thread::hardware_concurrency();
+	return coreCount > 1 ? coreCount - 1 : 1;
+}
+
+void MyThreadPool::_workerLoop()
+{
+	MY_TRACE_THREAD_NAME("worker");
+
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock{ m_mutex };
+			m_condition.wait(lock, [this]() { return m_bStopping || !m_qTasks.empty(); });
+
+			if (m_qTasks.empty())
+			{
+				return;
+			}
+
+			task = std::move(m_qTasks.front());
+			m_qTasks.pop();
+		}
+
+		task();
+	}
+}
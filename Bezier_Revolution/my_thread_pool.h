@@ -0,0 +1,63 @@
+#ifndef __MY_THREAD_POOL_H__
+#define __MY_THREAD_POOL_H__
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+//
+// A fixed number of worker threads pulling tasks from one queue.
+// The threads are started in the constructor and joined in the destructor
+//
+class MyThreadPool
+{
+public:
+	MyThreadPool(uint32_t threadCount);
+	~MyThreadPool();
+
+	MyThreadPool(const MyThreadPool&) = delete;
+	MyThreadPool& operator=(const MyThreadPool&) = delete;
+
+	// The returned future becomes ready once the task has run, holds what the task
+	// returned and rethrows the exception if the task threw one
+	template <typename F>
+	auto enqueue(F&& task) -> std::future<decltype(task())>
+	{
+		using ResultType = decltype(task());
+
+		// std::function needs a copyable target, packaged_task is move only
+		auto packagedTask = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(task));
+		std::future<ResultType> future = packagedTask->get_future();
+
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_qTasks.push([packagedTask]() { (*packagedTask)(); });
+		}
+		m_condition.notify_one();
+
+		return future;
+	}
+
+	uint32_t threadCount() const { return static_cast<uint32_t>(m_vThreads.size()); }
+
+	// One thread per core, leaving one for the main thread, and at least one
+	static uint32_t defaultThreadCount();
+
+private:
+	void _workerLoop();
+
+	std::vector<std::thread>               m_vThreads;
+	std::queue<std::function<void()>>      m_qTasks;
+	std::mutex                             m_mutex;
+	std::condition_variable                m_condition;
+	bool                                   m_bStopping = false;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "my_tracer.h"
+
+#ifdef MY_ENABLE_TRACING
+
+// std
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+MyTracer& MyTracer::instance()
+{
+	static MyTracer tracer;
+	return tracer;
+}
+
+MyTracer::MyTracer() :
+	m_startTime{ std::chrono::steady_clock::now() }
+{
+}
+
+uint64_t MyTracer::now() const
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - m_startTime).count());
+}
+
+MyTracer::ThreadBuffer& MyTracer::_threadBuffer()
+{
+	// The buffer is owned by the tracer so the events of a thread that
+	// has exited still end up in the trace
+	thread_local ThreadBuffer* pThreadBuffer = nullptr;
+
+	if (pThreadBuffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		auto threadBuffer = std::make_unique<ThreadBuffer>();
+		threadBuffer->threadID = static_cast<uint32_t>(m_vThreadBuffers.size());
+		threadBuffer->pEvents = std::make_unique<Event[]>(BUFFER_SIZE);
+
+		pThreadBuffer = threadBuffer.get();
+		m_vThreadBuffers.push_back(std::move(threadBuffer));
+	}
+
+	return *pThreadBuffer;
+}
+
+void MyTracer::record(const char* category, const char* name, uint64_t startNs, uint64_t endNs, const char* args)
+{
+	ThreadBuffer& threadBuffer = _threadBuffer();
+
+	// Only the owning thread writes, the release store publishes the
+	// event to writeTrace once it is complete
+	uint32_t index = threadBuffer.count.load(std::memory_order_relaxed);
+	if (index >= BUFFER_SIZE)
+	{
+		threadBuffer.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Event& event = threadBuffer.pEvents[index];
+	event.category = category;
+	event.name = name;
+	event.startNs = startNs;
+	event.durationNs = endNs - startNs;
+	std::snprintf(event.args, MAX_ARGS_LENGTH, "%s", args);
+
+	threadBuffer.count.store(index + 1, std::memory_order_release);
+}
+
+void MyTracer::setThreadName(const char* name)
+{
+	_threadBuffer().name = name;
+}
+
+static void writeEscaped(std::ostream& out, const char* text)
+{
+	for (const char* c = text; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			out << '\\' << *c;
+		}
+		else if (static_cast<unsigned char>(*c) < 0x20)
+		{
+			out << ' ';
+		}
+		else
+		{
+			out << *c;
+		}
+	}
+}
+
+void MyTracer::writeTrace(const std::string& filepath)
+{
+	std::ofstream file{ filepath };
+	if (!file.is_open())
+	{
+		std::cout << "failed to open file: " << filepath << std::endl;
+		return;
+	}
+
+	// Complete events ("ph":"X") and thread names ("ph":"M"), the timestamps are in microseconds
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	file << std::fixed << std::setprecision(3);
+
+	bool     bFirst = true;
+	uint32_t eventCount = 0;
+	uint32_t droppedCount = 0;
+
+	std::lock_guard<std::mutex> lock{ m_mutex };
+	for (auto& threadBuffer : m_vThreadBuffers)
+	{
+		if (threadBuffer->name != nullptr)
+		{
+			file << (bFirst ? "\n" : ",\n");
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadBuffer->threadID
+				<< ",\"args\":{\"name\":\"";
+			writeEscaped(file, threadBuffer->name);
+			file << "\"}}";
+			bFirst = false;
+		}
+
+		uint32_t count = threadBuffer->count.load(std::memory_order_acquire);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const Event& event = threadBuffer->pEvents[i];
+
+			file << (bFirst ? "\n" : ",\n");
+			file << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadBuffer->threadID
+				<< ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0;
+			if (event.args[0] != '\0')
+			{
+				file << ",\"args\":{\"detail\":\"";
+				writeEscaped(file, event.args);
+				file << "\"}";
+			}
+			file << "}";
+			bFirst = false;
+		}
+
+		eventCount += count;
+		droppedCount += threadBuffer->dropped.load(std::memory_order_relaxed);
+	}
+
+	file << "\n]}\n";
+
+	std::cout << "Trace of " << eventCount << " events written to " << filepath;
+	if (droppedCount > 0)
+	{
+		std::cout << " (" << droppedCount << " dropped, the buffers are full)";
+	}
+	std::cout << std::endl;
+}
+
+MyTraceScope::MyTraceScope(const char* category, const char* name) :
+	m_pCategory{ category },
+	m_pName{ name },
+	m_iStartNs{ MyTracer::instance().now() }
+{
+	m_args[0] = '\0';
+}
+
+MyTraceScope::MyTraceScope(const char* category, const char* name, const char* format, ...) :
+	m_pCategory{ category },
+	m_pName{ name }
+{
+	// Formatted before the start time so it is not part of the event
+	va_list args;
+	va_start(args, format);
+	std::vsnprintf(m_args, MyTracer::MAX_ARGS_LENGTH, format, args);
+	va_end(args);
+
+	m_iStartNs = MyTracer::instance().now();
+}
+
+MyTraceScope::~MyTraceScope()
+{
+	MyTracer& tracer = MyTracer::instance();
+	tracer.record(m_pCategory, m_pName, m_iStartNs, tracer.now(), m_args);
+}
+
+#endif
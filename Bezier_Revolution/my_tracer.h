@@ -0,0 +1,108 @@
+#ifndef __MY_TRACER_H__
+#define __MY_TRACER_H__
+
+//
+// Trace of one-off expensive events (pipeline creation, uploads, model loading, surface
+// rebuilds, swap chain recreation), written as Chrome/Perfetto trace event JSON.
+// Everything below compiles to nothing unless MY_ENABLE_TRACING is defined
+//
+#ifdef MY_ENABLE_TRACING
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class MyTracer
+{
+public:
+	// Events per thread. A thread that fills its buffer drops the rest of its events
+	static constexpr uint32_t BUFFER_SIZE = 65536;
+	static constexpr size_t   MAX_ARGS_LENGTH = 128;
+
+	struct Event
+	{
+		const char* category;    // must outlive the tracer, string literals only
+		const char* name;        // must outlive the tracer, string literals only
+		uint64_t    startNs;
+		uint64_t    durationNs;
+		char        args[MAX_ARGS_LENGTH];
+	};
+
+	static MyTracer& instance();
+
+	MyTracer(const MyTracer&) = delete;
+	MyTracer& operator=(const MyTracer&) = delete;
+
+	// Nanoseconds since the tracer was created
+	uint64_t now() const;
+
+	// Never blocks once the thread has recorded its first event
+	void     record(const char* category, const char* name, uint64_t startNs, uint64_t endNs, const char* args);
+	void     setThreadName(const char* name);
+
+	// Can be called while other threads are recording, their newer events are left out
+	void     writeTrace(const std::string& filepath);
+
+private:
+	struct ThreadBuffer
+	{
+		uint32_t                 threadID;
+		const char*              name = nullptr;
+		std::unique_ptr<Event[]> pEvents;
+		std::atomic<uint32_t>    count{ 0 };   // events [0, count) are complete, written by the owning thread only
+		std::atomic<uint32_t>    dropped{ 0 };
+	};
+
+	MyTracer();
+
+	ThreadBuffer& _threadBuffer();
+
+	std::chrono::steady_clock::time_point      m_startTime;
+	std::mutex                                 m_mutex;    // guards m_vThreadBuffers, only taken once per thread
+	std::vector<std::unique_ptr<ThreadBuffer>> m_vThreadBuffers;
+};
+
+//
+// Records the enclosing block as one event. The optional printf style arguments are
+// formatted into the event and shown as its "args" in the trace viewer
+//
+class MyTraceScope
+{
+public:
+	MyTraceScope(const char* category, const char* name);
+	MyTraceScope(const char* category, const char* name, const char* format, ...);
+	~MyTraceScope();
+
+	MyTraceScope(const MyTraceScope&) = delete;
+	MyTraceScope& operator=(const MyTraceScope&) = delete;
+
+private:
+	const char* m_pCategory;
+	const char* m_pName;
+	uint64_t    m_iStartNs;
+	char        m_args[MyTracer::MAX_ARGS_LENGTH];
+};
+
+#define MY_TRACE_CONCAT_(a, b) a##b
+#define MY_TRACE_CONCAT(a, b) MY_TRACE_CONCAT_(a, b)
+
+#define MY_TRACE_SCOPE(category, name) MyTraceScope MY_TRACE_CONCAT(myTraceScope, __LINE__){ category, name }
+#define MY_TRACE_SCOPE_ARGS(category, name, ...) MyTraceScope MY_TRACE_CONCAT(myTraceScope, __LINE__){ category, name, __VA_ARGS__ }
+#define MY_TRACE_THREAD_NAME(name) MyTracer::instance().setThreadName(name)
+#define MY_TRACE_WRITE(filepath) MyTracer::instance().writeTrace(filepath)
+
+#else
+
+#define MY_TRACE_SCOPE(category, name) ((void)0)
+#define MY_TRACE_SCOPE_ARGS(category, name, ...) ((void)0)
+#define MY_TRACE_THREAD_NAME(name) ((void)0)
+#define MY_TRACE_WRITE(filepath) ((void)0)
+
+#endif
+
+#endif
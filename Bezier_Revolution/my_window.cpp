@@ -4,21 +4,37 @@
 #include <stdexcept>
 #include <iostream>
 
-MyWindow::MyWindow(int w, int h, std::string name) : 
+MyWindow::MyWindow(int w, int h, std::string name, bool bHeadless) : 
 	m_iWidth(w),
 	m_iHeight(h),
+	m_bframeBufferResize(false),
+	m_bHeadless(bHeadless),
 	m_sWindowName(name),
 	m_pWindow(nullptr),
-	m_bframeBufferResize(false),
 	m_pMyApplication(nullptr)
 {
-	_initWindow();
+	// No display is needed to render offscreen
+	if (!m_bHeadless)
+	{
+		_initWindow();
+	}
 }
 
 MyWindow::~MyWindow()
 {
-	glfwDestroyWindow(m_pWindow);
-	glfwTerminate();
+	if (!m_bHeadless)
+	{
+		glfwDestroyWindow(m_pWindow);
+		glfwTerminate();
+	}
+}
+
+void MyWindow::requestClose()
+{
+	if (m_bHeadless)
+		m_bCloseRequested = true;
+	else
+		glfwSetWindowShouldClose(m_pWindow, 1);
 }
 
 void MyWindow::_initWindow()
@@ -47,10 +63,18 @@ void MyWindow::_initWindow()
 	
 	// Register mouse button callback
 	glfwSetMouseButtonCallback(m_pWindow, s_mouseButtonCallback);
+
+	// Redraw when the content of the window is damaged, e.g. uncovered by another window
+	glfwSetWindowRefreshCallback(m_pWindow, s_windowRefreshCallback);
 }
 
 void MyWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
 {
+	if (m_bHeadless)
+	{
+		throw std::runtime_error("Headless window has no surface");
+	}
+
 	if (glfwCreateWindowSurface(instance, m_pWindow, nullptr, surface) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create window");
@@ -63,6 +87,13 @@ void MyWindow::s_frameBufferResizeCallback(GLFWwindow* window, int width, int he
 	mywindow->m_bframeBufferResize = true;
 	mywindow->m_iWidth = width;
 	mywindow->m_iHeight = height;
+	mywindow->invalidate();
+}
+
+void MyWindow::s_windowRefreshCallback(GLFWwindow* window)
+{
+	auto mywindow = reinterpret_cast<MyWindow*>(glfwGetWindowUserPointer(window));
+	mywindow->invalidate();
 }
 
 void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -72,8 +103,11 @@ void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int
 	
 	if ( key == GLFW_KEY_C || key == GLFW_KEY_ESCAPE ||                                                           // Default operation
 		 key == GLFW_KEY_F || key == GLFW_KEY_R || key == GLFW_KEY_P || key == GLFW_KEY_Z || key == GLFW_KEY_T || // Camera operation
-		 key == GLFW_KEY_B || key == GLFW_KEY_SPACE || key == GLFW_KEY_N || key == GLFW_KEY_M )                   // Surface operation
+		 key == GLFW_KEY_B || key == GLFW_KEY_SPACE || key == GLFW_KEY_N || key == GLFW_KEY_M ||                  // Surface operation
+		 key == GLFW_KEY_G || key == GLFW_KEY_H || key == GLFW_KEY_J || key == GLFW_KEY_K || key == GLFW_KEY_V )  // Profiling
 	{
+		mywindow->invalidate();
+
 		if (action == GLFW_PRESS)
 			mywindow->keyboardEvent(key, true);
 		if (action == GLFW_RELEASE)
@@ -83,11 +117,33 @@ void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int
 
 void MyWindow::pollEvents()
 {
+	if (m_bHeadless) return;
+
 	glfwPollEvents();
-	
+	_dispatchMouseMotion();
+}
+
+void MyWindow::waitEventsTimeout(double seconds)
+{
+	if (m_bHeadless) return;
+
+	glfwWaitEventsTimeout(seconds);
+	_dispatchMouseMotion();
+}
+
+void MyWindow::_dispatchMouseMotion()
+{
 	double xpos = 0.0, ypos = 0.0;
 	glfwGetCursorPos(m_pWindow, &xpos, &ypos);
 
+	// A cursor that has not moved changes nothing, and would keep an idle application busy
+	if (xpos == m_dCursorX && ypos == m_dCursorY)
+	{
+		return;
+	}
+	m_dCursorX = xpos;
+	m_dCursorY = ypos;
+
 	float fMousePos[2];
 	fMousePos[0] = (float)xpos / (float)m_iWidth;
 	fMousePos[1] = (float)ypos / (float)m_iHeight;
@@ -97,11 +153,20 @@ void MyWindow::pollEvents()
 
 void MyWindow::waitEvents()
 {
+	if (m_bHeadless) return;
+
 	glfwWaitEvents();
 }
 
 const char** MyWindow::getRequiredInstanceExtensions(uint32_t* extensionCount)
 {
+	// Without a surface no window system extension is needed
+	if (m_bHeadless)
+	{
+		*extensionCount = 0;
+		return nullptr;
+	}
+
 	return glfwGetRequiredInstanceExtensions(extensionCount);
 }
 
@@ -158,11 +223,32 @@ void MyWindow::keyboardEvent(int key, bool bKeyDown)
 	{
 		m_pMyApplication->showHideSurface(); 
 	}
+	else if (key == GLFW_KEY_G && bKeyDown)
+	{
+		m_pMyApplication->printGpuProfile();
+	}
+	else if (key == GLFW_KEY_H && bKeyDown)
+	{
+		m_pMyApplication->writeGpuProfileCsv();
+	}
+	else if (key == GLFW_KEY_J && bKeyDown)
+	{
+		m_pMyApplication->writeCpuTrace();
+	}
+	else if (key == GLFW_KEY_K && bKeyDown)
+	{
+		m_pMyApplication->writeTrace();
+	}
+	else if (key == GLFW_KEY_V && bKeyDown)
+	{
+		m_pMyApplication->printMemoryReport();
+	}
 }
 
 void MyWindow::s_mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
 	auto mywindow = reinterpret_cast<MyWindow*>(glfwGetWindowUserPointer(window));
+	mywindow->invalidate();
 
 	double xpos, ypos;
 	glfwGetCursorPos(window, &xpos, &ypos);
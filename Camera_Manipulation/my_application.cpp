@@ -3,6 +3,7 @@
 // Render system
 #include "my_simple_render_system.h"
 #include "my_keyboard_controller.h"
+#include "my_bvh.h"
 
 // use radian rather degree for angle
 #define GLM_FORCE_RADIANS
@@ -17,7 +18,9 @@
 #include <iostream>
 #include <algorithm>
 
-MyApplication::MyApplication() :
+MyApplication::MyApplication(uint32_t headlessFrames) :
+    m_iHeadlessFrames(headlessFrames),
+    m_myWindow{ WIDTH, HEIGHT, "Camera_Manipulation", headlessFrames > 0 },
     m_bPerspectiveProjection(true)
 {
     _loadGameObjects();
@@ -41,13 +44,32 @@ void MyApplication::run()
 
     auto currentTime = std::chrono::high_resolution_clock::now();
 
+    auto startTime = std::chrono::high_resolution_clock::now();
+    uint32_t frameCount = 0;
+
     while (!m_myWindow.shouldClose()) 
     {
         // Note: depending on the platforms (PC, Linux or Mac), this function
         // will cause the event proecssing to block during a Window move, resize or
         // menu operation. Users can use the "window refresh callback" to redraw the
         // contents of the window when necessary during such operation.
-        m_myWindow.pollEvents();
+        // Headless runs draw every frame
+        if (m_myWindow.isHeadless() || m_myWindow.isDirty())
+        {
+            m_myWindow.pollEvents();
+        }
+        else
+        {
+            // Nothing changed since the last frame, sleep until an event arrives
+            m_myWindow.waitEventsTimeout(IDLE_TIMEOUT);
+            if (!m_myWindow.isDirty())
+            {
+                continue;
+            }
+
+            // The time spent waiting is not part of the frame
+            currentTime = std::chrono::high_resolution_clock::now();
+        }
 
         // Need to get the call after glfwPollEvants because the call above may take time
         auto newTime = std::chrono::high_resolution_clock::now();
@@ -70,19 +92,46 @@ void MyApplication::run()
         // if the swapChain needs to be recreated
         if (auto commandBuffer = m_myRenderer.beginFrame())
 		{
+            // Everything that changed so far is in this frame
+            m_myWindow.clearDirty();
+
             // In case we have multiple render passes for the current frame
             // begin offsreen shadow pass
             // render shadow casting objects
             // end offscreen shadow pass
 
+            // Keep rotating the colored cube. It is animated, so the next frame is drawn
+            // without waiting for input for as long as the cube exists
+            if (MyGameObject* pCube = m_myGameObjects.get(m_myCubeHandle))
+            {
+                pCube->transform.rotation.x += 0.01f;
+                pCube->transform.rotation.y += 0.01f;
+                pCube->transform.rotation.z += 0.01f;
+                m_mySceneBounds.setTransform(m_myCubeHandle, pCube->transform.mat4());
+                m_myWindow.invalidate();
+            }
+
             m_myRenderer.beginSwapChainRenderPass(commandBuffer);
-            simpleRenderSystem.renderGameObjects(commandBuffer, m_vMyGameObjects, m_myCamera);
+            simpleRenderSystem.renderGameObjects(commandBuffer, m_myGameObjects, m_myCamera);
             m_myRenderer.endSwapChainRenderPass(commandBuffer);
 
             m_myRenderer.endFrame();
+
+            if (m_myWindow.isHeadless() && ++frameCount >= m_iHeadlessFrames)
+            {
+                m_myWindow.requestClose();
+            }
         }
     }
 
+    if (m_myWindow.isHeadless())
+    {
+        float totalTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+        std::cout << "Headless: " << frameCount << " frames in " << totalTime << " ms ("
+                  << totalTime / std::max(frameCount, 1u) << " ms per frame)" << std::endl;
+    }
+
     // GPU will block until all CPU is complete
     vkDeviceWaitIdle(m_myDevice.device());
 }
@@ -95,96 +144,129 @@ void MyApplication::switchProjectionMatrix()
 
 void MyApplication::_loadGameObjects()
 {
-    glm::vec3 cup_min, cup_max, teapot_max, teapot_min, cube_min, cube_max, min, max; 
-
-    glm::vec4 affine_cup_min, affine_cup_max, affine_teapot_min, affine_teapot_max; 
-
-    glm::mat4 cupMat, teapotMat; 
-
     // create cup model from obj file 
-    std::shared_ptr<MyModel> cupModel = MyModel::createModelFromFile(m_myDevice, "models/Cup.obj", cup_min, cup_max);
-    affine_cup_min = {cup_min, 1.0f}; 
-    affine_cup_max = {cup_max, 1.0f}; 
-
-    glm::vec3 cup_mid = (cup_min + cup_max) / 2.0f; 
-
     auto cup_obj = MyGameObject::createGameObject(); 
-
-    cup_obj.model = cupModel; 
     cup_obj.transform.translation = { 3.0f, 0.0f, 0.0f }; // for perspective
     cup_obj.transform.scale = glm::vec3(0.2f);
-
-    cupMat = cup_obj.transform.mat4();
-
-    affine_cup_min = cupMat * affine_cup_min; 
-    affine_cup_max = cupMat * affine_cup_max; 
-    cup_min = {affine_cup_min.x, affine_cup_min.y, affine_cup_min.z};
-    cup_max = {affine_cup_max.x, affine_cup_max.y, affine_cup_max.z};
-
-    m_vMyGameObjects.push_back(std::move(cup_obj));
+    _addGameObject(std::move(cup_obj), "models/Cup.obj");
 
     // create cube model from obj file 
-    std::shared_ptr<MyModel> cubeModel = MyModel::createModelFromFile(m_myDevice, "models/colored_cube.obj", cube_min, cube_max);
-    auto cube_obj = MyGameObject::createGameObject(); 
-
     // same transformation as cup object but with smaller scaling to make the cube be inside the cup
-    cube_obj.model = cubeModel; 
+    auto cube_obj = MyGameObject::createGameObject(); 
     cube_obj.transform.translation = { 3.0f, 0.5f, 0.0f }; // for perspective
     cube_obj.transform.scale = glm::vec3(0.1f);
-
-    m_vMyGameObjects.push_back(std::move(cube_obj));
+    m_myCubeHandle = _addGameObject(std::move(cube_obj), "models/colored_cube.obj");
 
     // create teapot model from obj file 
-    std::shared_ptr<MyModel> teapotModel = MyModel::createModelFromFile(m_myDevice, "models/teapot.obj", teapot_min, teapot_max);
-    affine_teapot_min = {teapot_min, 1.0f}; 
-    affine_teapot_max = {teapot_max, 1.0f}; 
-
     auto teapot_obj = MyGameObject::createGameObject(); 
-
-    teapot_obj.model = teapotModel; 
     teapot_obj.transform.translation = { -1.5f, 2.0f, 0.0f }; // for perspective
     teapot_obj.transform.scale = glm::vec3(1.0f);
     float theta = -glm::pi<float>() / 4.0f; 
-	teapot_obj.transform.rotation.z = theta; 
+    teapot_obj.transform.rotation.z = theta; 
+    _addGameObject(std::move(teapot_obj), "models/teapot.obj");
 
-    teapotMat = teapot_obj.transform.mat4();
-    affine_teapot_min = teapotMat * affine_teapot_min; 
-    affine_teapot_max = teapotMat * affine_teapot_max; 
-    teapot_min = {affine_teapot_min.x, affine_teapot_min.y, affine_teapot_min.z};
-    teapot_max = {affine_teapot_max.x, affine_teapot_max.y, affine_teapot_max.z};
+    setCameraNavigationMode(MyCamera::MYCAMERA_FITALL); // fit all to ensure object is at center of screen when program starts
+}
 
-    m_vMyGameObjects.push_back(std::move(teapot_obj));
+MySlotHandle MyApplication::_addGameObject(MyGameObject obj, const std::string& filepath)
+{
+    // The scene bounds use every vertex after the transform, the object space box is not needed
+    glm::vec3 min, max;
+    MyModel::Builder builder{};
+    builder.loadModel(filepath, min, max);
+
+    obj.model = std::make_shared<MyModel>(m_myDevice, builder);
+    glm::mat4 transform = obj.transform.mat4();
+
+    MySlotHandle handle = m_myGameObjects.insert(std::move(obj));
+    m_mySceneBounds.setPoints(handle, builder.vertices);
+    m_mySceneBounds.setTransform(handle, transform);
+    return handle;
+}
 
-    // Calculate the overall scene's min and max
-    for (int i = 0; i < 3; i++)
+void MyApplication::mouseButtonEvent(bool bMouseDown, float posx, float posy)
+{
+    m_bMouseButtonPress = bMouseDown;
+    m_myCamera.setButton(m_bMouseButtonPress, posx, posy);
+
+    // Pick the object under the cursor
+    if (bMouseDown)
     {
-        min[i] = std::min(teapot_min[i], cup_min[i]); 
-        max[i] = std::max(teapot_max[i], cup_max[i]); 
-    }
-    
-    // std::cout << "Min: " << min.x << ", " << min.y << ", " << min.z << std::endl;
-    // std::cout << "Max: " << max.x << ", " << max.y << ", " << max.z << std::endl;
+        auto startTime = std::chrono::high_resolution_clock::now();
 
-    // Offset both min and max's y-component so that initially when twisting the camera, the scene fits the window screen. 
-    min.y += 1.2f;
-    max.y += 1.2f; 
+        glm::vec3 origin, direction;
+        m_myCamera.screenRay(posx, posy, origin, direction);
+        RayHit rayHit{};
+        bool bHit = _castRay(origin, direction, rayHit);
 
-    m_myCamera.setSceneMinMax(min, max);
-    setCameraNavigationMode(MyCamera::MYCAMERA_FITALL); // fit all to ensure object is at center of screen when program starts
+        float pickTime = std::chrono::duration<float, std::chrono::microseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+
+        if (bHit)
+        {
+            std::cout << "Picked object " << m_myGameObjects.get(rayHit.object)->getID() << ", triangle " << rayHit.triangle
+                      << ", distance " << rayHit.distance << " (" << pickTime << " us)" << std::endl;
+        }
+        else
+        {
+            std::cout << "Picked nothing (" << pickTime << " us)" << std::endl;
+        }
+    }
 }
 
-void MyApplication::mouseButtonEvent(bool bMouseDown, float posx, float posy)
+bool MyApplication::_castRay(const glm::vec3& origin, const glm::vec3& direction, RayHit& rayHit)
 {
-    m_bMouseButtonPress = bMouseDown;
-    m_myCamera.setButton(m_bMouseButtonPress, posx, posy);
+    // Every model is tested in its object space. The direction is transformed but not
+    // normalized, so t means the same for all objects and the hits compare directly
+    MyBvh::Hit closestHit{};
+    bool bHit = false;
+
+    m_myGameObjects.forEach([&](MySlotHandle handle, MyGameObject& obj)
+    {
+        const MyBvh* pBvh = obj.model ? obj.model->bvh() : nullptr;
+        if (pBvh == nullptr)
+        {
+            return;
+        }
+
+        glm::mat4 worldToObject = glm::inverse(obj.transform.mat4());
+        glm::vec3 objectOrigin = glm::vec3(worldToObject * glm::vec4(origin, 1.0f));
+        glm::vec3 objectDirection = glm::vec3(worldToObject * glm::vec4(direction, 0.0f));
+
+        if (pBvh->intersect(objectOrigin, objectDirection, closestHit))
+        {
+            rayHit.object = handle;
+            rayHit.triangle = closestHit.triangle;
+            bHit = true;
+        }
+    });
+
+    if (bHit)
+    {
+        rayHit.distance = closestHit.t * glm::length(direction);
+    }
+    return bHit;
 }
 
 void MyApplication::mouseMotionEvent(float posx, float posy)
 {
     m_myCamera.setMotion(m_bMouseButtonPress, posx, posy);
+
+    // The camera only moves while the mouse is dragged
+    if (m_bMouseButtonPress)
+    {
+        m_myWindow.invalidate();
+    }
 }
 
 void MyApplication::setCameraNavigationMode(MyCamera::MyCameraMode mode)
 {
+    // Every navigation starts here, the sphere is only recomputed if something moved since the last one
+    const MySphere& sceneSphere = m_mySceneBounds.sceneSphere();
+    if (!sceneSphere.isEmpty())
+    {
+        m_myCamera.setSceneSphere(sceneSphere.center, sceneSphere.radius);
+    }
+
     m_myCamera.setMode(mode);   
 }
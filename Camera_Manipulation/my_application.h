@@ -5,6 +5,8 @@
 #include "my_device.h"
 #include "my_renderer.h"
 #include "my_game_object.h"
+#include "my_slot_map.h"
+#include "my_bounds.h"
 #include "my_camera.h"
 
 #include <memory>
@@ -16,7 +18,13 @@ public:
 	static constexpr int WIDTH = 800;
 	static constexpr int HEIGHT = 600;
 
-	MyApplication();
+	// Frames are only drawn when something changed, the rotating cube changes every
+	// frame. Without events the loop still wakes up after this many seconds
+	static constexpr double IDLE_TIMEOUT = 0.5;
+
+	// With headlessFrames > 0 nothing is shown, the given number of frames
+	// are rendered offscreen and run() returns
+	MyApplication(uint32_t headlessFrames = 0);
 	~MyApplication();
 
 	MyApplication(const MyApplication&) = delete;
@@ -31,13 +39,29 @@ public:
 	void setCameraNavigationMode(MyCamera::MyCameraMode mode);
 
 private:
+	struct RayHit
+	{
+		MySlotHandle object;         // the closest object along the ray
+		uint32_t     triangle = 0;   // triangle of the object's model, see MyBvh::Hit
+		float        distance = 0.0f;
+	};
+
 	void _loadGameObjects();
 
+	// Loads the model of the object from an obj file, the object and its vertices go into the scene
+	MySlotHandle _addGameObject(MyGameObject obj, const std::string& filepath);
+
+	// Closest triangle of all objects along the world space ray, false if nothing is hit
+	bool _castRay(const glm::vec3& origin, const glm::vec3& direction, RayHit& rayHit);
+
+	uint32_t                  m_iHeadlessFrames;
 	MyWindow                  m_myWindow{ WIDTH, HEIGHT, "Camera_Manipulation" };
 	MyDevice                  m_myDevice{ m_myWindow };
 	MyRenderer                m_myRenderer{ m_myWindow, m_myDevice };
 
-	std::vector<MyGameObject> m_vMyGameObjects;
+	MySlotMap<MyGameObject>   m_myGameObjects;
+	MySlotHandle              m_myCubeHandle;      // the cube keeps rotating
+	MySceneBounds             m_mySceneBounds;
 	MyCamera                  m_myCamera{};
 	bool                      m_bPerspectiveProjection;
 	bool                      m_bMouseButtonPress = false;
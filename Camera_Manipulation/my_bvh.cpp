@@ -0,0 +1,360 @@
+#include "my_bvh.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <future>
+#include <thread>
+
+static float surfaceArea(const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec3 extent = max - min;
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+MyBvh::MyBvh(const MyModel::Builder& builder)
+{
+	// A builder without indices is a plain triangle list
+	bool bIndexed = !builder.indices.empty();
+	uint32_t triangleCount = static_cast<uint32_t>((bIndexed ? builder.indices.size() : builder.vertices.size()) / 3);
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	auto position = [&](uint32_t triangle, uint32_t corner) -> const glm::vec3&
+	{
+		uint32_t i = 3 * triangle + corner;
+		return builder.vertices[bIndexed ? builder.indices[i] : i].position;
+	};
+
+	BuildData data;
+	data.vCentroids.resize(triangleCount);
+	data.vMin.resize(triangleCount);
+	data.vMax.resize(triangleCount);
+	m_vTriangleIndices.resize(triangleCount);
+
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		const glm::vec3& a = position(i, 0);
+		const glm::vec3& b = position(i, 1);
+		const glm::vec3& c = position(i, 2);
+
+		data.vMin[i] = glm::min(a, glm::min(b, c));
+		data.vMax[i] = glm::max(a, glm::max(b, c));
+		data.vCentroids[i] = (a + b + c) / 3.0f;
+		m_vTriangleIndices[i] = i;
+	}
+
+	// Enough parallel levels to give every core a subtree
+	uint32_t coreCount = std::max(std::thread::hardware_concurrency(), 1u);
+	while ((1u << data.iParallelDepth) < coreCount)
+	{
+		data.iParallelDepth++;
+	}
+
+	// A binary tree with one triangle per leaf has 2n - 1 nodes, the children of a node
+	// are allocated by bumping the node count, so the threads never share a node
+	m_vNodes.resize(2 * triangleCount - 1);
+	Node& root = m_vNodes[0];
+	root.leftFirst = 0;
+	root.count = triangleCount;
+	data.iNodeCount = 1;
+
+	_subdivide(data, 0, 0);
+	m_vNodes.resize(data.iNodeCount);
+	m_vNodes.shrink_to_fit();
+
+	// Copy the triangles in leaf order, a leaf then reads one contiguous range
+	m_vTriangles.resize(triangleCount);
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		uint32_t triangle = m_vTriangleIndices[i];
+		const glm::vec3& v0 = position(triangle, 0);
+		m_vTriangles[i] = Triangle{ v0, position(triangle, 1) - v0, position(triangle, 2) - v0 };
+	}
+}
+
+void MyBvh::_updateBounds(const BuildData& data, Node& node) const
+{
+	node.min = glm::vec3(std::numeric_limits<float>::max());
+	node.max = glm::vec3(-std::numeric_limits<float>::max());
+
+	for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+	{
+		uint32_t triangle = m_vTriangleIndices[i];
+		node.min = glm::min(node.min, data.vMin[triangle]);
+		node.max = glm::max(node.max, data.vMax[triangle]);
+	}
+}
+
+void MyBvh::_subdivide(BuildData& data, uint32_t nodeIndex, uint32_t depth)
+{
+	Node& node = m_vNodes[nodeIndex];
+	_updateBounds(data, node);
+
+	if (node.count <= MAX_LEAF_TRIANGLES || depth + 1 >= MAX_DEPTH)
+	{
+		return;
+	}
+
+	uint32_t first = node.leftFirst;
+	uint32_t last = first + node.count;
+
+	// Triangles are binned by their centroid, so the bins split the centroid bounds
+	glm::vec3 centroidMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 centroidMax = glm::vec3(-std::numeric_limits<float>::max());
+	for (uint32_t i = first; i < last; i++)
+	{
+		const glm::vec3& centroid = data.vCentroids[m_vTriangleIndices[i]];
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	struct Bin
+	{
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+		uint32_t  count = 0;
+	};
+
+	// The cost of a node is its surface area times its triangle count, the cost of
+	// the traversal step itself is left out
+	float    bestCost = surfaceArea(node.min, node.max) * node.count;
+	int      bestAxis = -1;
+	uint32_t bestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		Bin bins[BIN_COUNT];
+		float scale = BIN_COUNT / extent;
+		for (uint32_t i = first; i < last; i++)
+		{
+			uint32_t triangle = m_vTriangleIndices[i];
+			uint32_t bin = std::min(static_cast<uint32_t>((data.vCentroids[triangle][axis] - centroidMin[axis]) * scale), BIN_COUNT - 1);
+			bins[bin].min = glm::min(bins[bin].min, data.vMin[triangle]);
+			bins[bin].max = glm::max(bins[bin].max, data.vMax[triangle]);
+			bins[bin].count++;
+		}
+
+		// Sweep from the left and from the right, the split s puts bins [0, s) to the left
+		float    leftArea[BIN_COUNT - 1];
+		uint32_t leftCount[BIN_COUNT - 1];
+		Bin      left;
+		for (uint32_t s = 1; s < BIN_COUNT; s++)
+		{
+			left.min = glm::min(left.min, bins[s - 1].min);
+			left.max = glm::max(left.max, bins[s - 1].max);
+			left.count += bins[s - 1].count;
+			leftArea[s - 1] = left.count > 0 ? surfaceArea(left.min, left.max) : 0.0f;
+			leftCount[s - 1] = left.count;
+		}
+
+		Bin right;
+		for (uint32_t s = BIN_COUNT - 1; s > 0; s--)
+		{
+			right.min = glm::min(right.min, bins[s].min);
+			right.max = glm::max(right.max, bins[s].max);
+			right.count += bins[s].count;
+
+			if (leftCount[s - 1] == 0 || right.count == 0)
+			{
+				continue;
+			}
+
+			float cost = leftArea[s - 1] * leftCount[s - 1] + surfaceArea(right.min, right.max) * right.count;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = s;
+			}
+		}
+	}
+
+	// No split is cheaper than intersecting all triangles of the node
+	if (bestAxis < 0)
+	{
+		return;
+	}
+
+	// Same binning as above, so both sides get exactly the triangles that were counted
+	float scale = BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	uint32_t* pMiddle = std::partition(
+		m_vTriangleIndices.data() + first,
+		m_vTriangleIndices.data() + last,
+		[&](uint32_t triangle)
+		{
+			uint32_t bin = std::min(static_cast<uint32_t>((data.vCentroids[triangle][bestAxis] - centroidMin[bestAxis]) * scale), BIN_COUNT - 1);
+			return bin < bestSplit;
+		});
+	uint32_t leftCount = static_cast<uint32_t>(pMiddle - m_vTriangleIndices.data()) - first;
+	assert(leftCount > 0 && leftCount < node.count && "A split must leave triangles on both sides");
+
+	uint32_t leftIndex = data.iNodeCount.fetch_add(2);
+	m_vNodes[leftIndex].leftFirst = first;
+	m_vNodes[leftIndex].count = leftCount;
+	m_vNodes[leftIndex + 1].leftFirst = first + leftCount;
+	m_vNodes[leftIndex + 1].count = node.count - leftCount;
+	node.leftFirst = leftIndex;
+	node.count = 0;
+
+	// The children work on their own ranges of triangles and allocate their own nodes
+	if (depth < data.iParallelDepth && m_vNodes[leftIndex].count >= PARALLEL_MIN_TRIANGLES)
+	{
+		std::future<void> left = std::async(std::launch::async, [&data, this, leftIndex, depth]()
+		{
+			_subdivide(data, leftIndex, depth + 1);
+		});
+		_subdivide(data, leftIndex + 1, depth + 1);
+		left.get();
+	}
+	else
+	{
+		_subdivide(data, leftIndex, depth + 1);
+		_subdivide(data, leftIndex + 1, depth + 1);
+	}
+}
+
+float MyBvh::_intersectBounds(const Node& node, const glm::vec3& origin, const glm::vec3& invDirection, float tMax)
+{
+	// Slab test, a zero direction component gives infinite distances which still compare right
+	glm::vec3 t0 = (node.min - origin) * invDirection;
+	glm::vec3 t1 = (node.max - origin) * invDirection;
+	glm::vec3 tEnter = glm::min(t0, t1);
+	glm::vec3 tExit = glm::max(t0, t1);
+
+	float tNear = std::max(std::max(tEnter.x, tEnter.y), std::max(tEnter.z, 0.0f));
+	float tFar = std::min(std::min(tExit.x, tExit.y), std::min(tExit.z, tMax));
+	return tNear <= tFar ? tNear : std::numeric_limits<float>::max();
+}
+
+bool MyBvh::_intersectTriangle(const Triangle& triangle, const glm::vec3& origin, const glm::vec3& direction, Hit& hit)
+{
+	// Moller-Trumbore
+	glm::vec3 p = glm::cross(direction, triangle.e2);
+	float det = glm::dot(triangle.e1, p);
+	if (det == 0.0f)
+	{
+		// Parallel to the triangle, or a degenerate triangle
+		return false;
+	}
+
+	float invDet = 1.0f / det;
+	glm::vec3 s = origin - triangle.v0;
+	float u = glm::dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+
+	glm::vec3 q = glm::cross(s, triangle.e1);
+	float v = glm::dot(direction, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+
+	float t = glm::dot(triangle.e2, q) * invDet;
+	if (t < 0.0f || t >= hit.t)
+	{
+		return false;
+	}
+
+	hit.t = t;
+	hit.u = u;
+	hit.v = v;
+	return true;
+}
+
+bool MyBvh::intersect(const glm::vec3& origin, const glm::vec3& direction, Hit& hit) const
+{
+	static constexpr float MISS = std::numeric_limits<float>::max();
+
+	if (m_vNodes.empty())
+	{
+		return false;
+	}
+
+	glm::vec3 invDirection = 1.0f / direction;
+	if (_intersectBounds(m_vNodes[0], origin, invDirection, hit.t) == MISS)
+	{
+		return false;
+	}
+
+	// Far children waiting to be visited, with their entry distance. The tree is at most
+	// MAX_DEPTH deep and every level pushes at most one node
+	struct StackEntry
+	{
+		uint32_t node;
+		float    t;
+	};
+	StackEntry stack[MAX_DEPTH];
+	uint32_t   stackSize = 0;
+
+	uint32_t nodeIndex = 0;
+	uint32_t hitIndex = INVALID_TRIANGLE;
+	while (true)
+	{
+		const Node& node = m_vNodes[nodeIndex];
+		if (node.count > 0)
+		{
+			for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+			{
+				if (_intersectTriangle(m_vTriangles[i], origin, direction, hit))
+				{
+					hitIndex = i;
+				}
+			}
+		}
+		else
+		{
+			// Visit the nearer child first, the hit found there culls the other one
+			uint32_t nearIndex = node.leftFirst;
+			uint32_t farIndex = node.leftFirst + 1;
+			float tNear = _intersectBounds(m_vNodes[nearIndex], origin, invDirection, hit.t);
+			float tFar = _intersectBounds(m_vNodes[farIndex], origin, invDirection, hit.t);
+			if (tFar < tNear)
+			{
+				std::swap(nearIndex, farIndex);
+				std::swap(tNear, tFar);
+			}
+
+			if (tNear != MISS)
+			{
+				if (tFar != MISS)
+				{
+					assert(stackSize < MAX_DEPTH && "BVH traversal stack overflow");
+					stack[stackSize++] = StackEntry{ farIndex, tFar };
+				}
+				nodeIndex = nearIndex;
+				continue;
+			}
+		}
+
+		// Skip the nodes that start behind the closest hit so far
+		while (stackSize > 0 && stack[stackSize - 1].t >= hit.t)
+		{
+			stackSize--;
+		}
+		if (stackSize == 0)
+		{
+			break;
+		}
+		nodeIndex = stack[--stackSize].node;
+	}
+
+	if (hitIndex == INVALID_TRIANGLE)
+	{
+		return false;
+	}
+
+	hit.triangle = m_vTriangleIndices[hitIndex];
+	return true;
+}
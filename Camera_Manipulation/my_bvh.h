@@ -0,0 +1,91 @@
+#ifndef __MY_BVH_H__
+#define __MY_BVH_H__
+
+#include "my_model.h"
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+//
+// Bounding volume hierarchy over the triangles of a MyModel::Builder, in the object space of
+// the model. It is built once at load time by splitting at the bin boundary with the lowest
+// surface area heuristic cost, large subtrees are built on their own threads. Ray queries only
+// read the tree and can run on any number of threads at the same time
+//
+class MyBvh
+{
+public:
+	static constexpr uint32_t BIN_COUNT = 12;                   // split candidates per axis
+	static constexpr uint32_t MAX_LEAF_TRIANGLES = 4;           // larger leaves are only kept if no split is cheaper
+	static constexpr uint32_t MAX_DEPTH = 64;                   // deeper nodes become leaves, bounds the traversal stack
+	static constexpr uint32_t PARALLEL_MIN_TRIANGLES = 8192;    // smaller subtrees are built on the thread of their parent
+	static constexpr uint32_t INVALID_TRIANGLE = UINT32_MAX;
+
+	struct Hit
+	{
+		float    t = std::numeric_limits<float>::max();  // the hit point is origin + t * direction
+		uint32_t triangle = INVALID_TRIANGLE;            // the triangle made of indices[3 * triangle] ... [3 * triangle + 2]
+		float    u = 0.0f;                               // barycentric coordinates of the hit point
+		float    v = 0.0f;
+	};
+
+	explicit MyBvh(const MyModel::Builder& builder);
+
+	MyBvh(const MyBvh&) = delete;
+	MyBvh& operator=(const MyBvh&) = delete;
+
+	// Finds the closest triangle with 0 <= t < hit.t, both sides of a triangle are hit.
+	// The direction does not need to be normalized, t is in units of its length.
+	// Returns false and leaves hit untouched if there is no closer triangle
+	bool      intersect(const glm::vec3& origin, const glm::vec3& direction, Hit& hit) const;
+
+	uint32_t  triangleCount() const { return static_cast<uint32_t>(m_vTriangles.size()); }
+	uint32_t  nodeCount() const { return static_cast<uint32_t>(m_vNodes.size()); }
+
+private:
+	//
+	// 32 bytes, two nodes per cache line. The two children of an inner node are next to each
+	// other, so one index addresses both of them
+	//
+	struct Node
+	{
+		glm::vec3 min;
+		uint32_t  leftFirst;    // inner node: index of the left child, leaf: first triangle
+		glm::vec3 max;
+		uint32_t  count;        // triangles of a leaf, 0 for an inner node
+	};
+
+	// A corner and the two edges from it, what the intersection test needs, in leaf order
+	struct Triangle
+	{
+		glm::vec3 v0;
+		glm::vec3 e1;
+		glm::vec3 e2;
+	};
+
+	// Per triangle data that is only needed while building
+	struct BuildData
+	{
+		std::vector<glm::vec3> vCentroids;
+		std::vector<glm::vec3> vMin;
+		std::vector<glm::vec3> vMax;
+		std::atomic<uint32_t>  iNodeCount{ 0 };
+		uint32_t               iParallelDepth = 0;  // nodes above it build their children in parallel
+	};
+
+	void  _subdivide(BuildData& data, uint32_t nodeIndex, uint32_t depth);
+	void  _updateBounds(const BuildData& data, Node& node) const;
+
+	// Returns the entry distance, or the max float if the ray misses the node before tMax
+	static float _intersectBounds(const Node& node, const glm::vec3& origin, const glm::vec3& invDirection, float tMax);
+	static bool  _intersectTriangle(const Triangle& triangle, const glm::vec3& origin, const glm::vec3& direction, Hit& hit);
+
+	std::vector<Node>     m_vNodes;               // the root is the first node
+	std::vector<Triangle> m_vTriangles;           // in leaf order
+	std::vector<uint32_t> m_vTriangleIndices;     // leaf order to the triangle index of the builder
+};
+
+#endif
@@ -11,6 +11,7 @@
 #include <glm/gtx/io.hpp>
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <limits>
 #include <iostream>
@@ -48,6 +49,9 @@ void MyCamera::setPerspectiveProjection(float fovy, float aspect, float near, fl
 {
     assert(glm::abs(aspect - std::numeric_limits<float>::epsilon()) > 0.0f);
 
+    m_fFovy = fovy;
+    m_fAspect = aspect;
+
     // Use OpenGL matrix but follow Vulkan's convention that Y is down
     const float tanHalfFovy = tan(fovy / 2.f);
 
@@ -165,10 +169,22 @@ void MyCamera::setMode(MyCameraMode mode)
     }
 }
 
-void MyCamera::setSceneMinMax(glm::vec3 min, glm::vec3 max)
+void MyCamera::screenRay(float x, float y, glm::vec3& origin, glm::vec3& direction) const
+{
+    // The viewport maps the top of the window to y = -1, and both projection
+    // matrices map the near plane to z = -1 and the far plane to z = 1
+    glm::mat4 inverseProjectionView = glm::inverse(m_m4ProjectionMatrix * m_m4ViewMatrix);
+    glm::vec4 nearPoint = inverseProjectionView * glm::vec4{ 2.0f * x - 1.0f, 2.0f * y - 1.0f, -1.0f, 1.0f };
+    glm::vec4 farPoint = inverseProjectionView * glm::vec4{ 2.0f * x - 1.0f, 2.0f * y - 1.0f, 1.0f, 1.0f };
+
+    origin = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::vec3(farPoint) / farPoint.w - origin;
+}
+
+void MyCamera::setSceneSphere(glm::vec3 center, float radius)
 {
-    m_vSceneMin = min;
-    m_vSceneMax = max;
+    m_vSceneCenter = center;
+    m_fSceneRadius = radius;
 }
 
 void MyCamera::setButton(bool buttonPress, float x, float y)
@@ -242,7 +258,7 @@ void MyCamera::setMotion(bool buttonPress, float x, float y)
         _twist(delta.x, delta.y);
     }
 
-    glm::vec3 mid = (m_vSceneMax + m_vSceneMin) / 2.0f;  // Mid of scene
+    glm::vec3 mid = m_vSceneCenter;  // Mid of scene
 
     glm::mat4 offset_mat = {
         {1.0f, 0.0f, 0.0f, 0.0f}, 
@@ -296,9 +312,7 @@ void MyCamera::setMotion(bool buttonPress, float x, float y)
 
 void MyCamera::_pan(float dx, float dy)
 {
-    glm::vec3 mid = (m_vSceneMax + m_vSceneMin) / 2.0f; // Midpoint of scene 
-
-    float radius = glm::length(m_vSceneMax - mid); // radius of scene
+    float radius = m_fSceneRadius; // radius of scene
 
     float diameter = 2 * radius; // diameter of the scene
 
@@ -319,11 +333,7 @@ void MyCamera::_zoom(float dx, float dy)
     // positive y is up and negative y is down since we set it as such in the projection matrix of the camera
     float m = 1.0f / (1.0f + dy * 2.0f);
 
-    glm::vec3 mid = (m_vSceneMax + m_vSceneMin) / 2.0f; // Midpoint of Scene 
-
-    float radius = glm::length(m_vSceneMax - mid); // radius of scene to be looked at
-
-    float curr_view_dist = radius / (glm::tan(glm::radians(25.f))); // viewing distance that is needed to look at all scene
+    float curr_view_dist = _fitDistance(); // viewing distance that is needed to look at all scene
 
     float new_view_dist = curr_view_dist * m; 
 
@@ -407,7 +417,7 @@ void MyCamera::_fitAll()
     // Reset delta matrix first
     m_m4TempTransform = glm::mat4(1.0f);
 
-    glm::vec3 mid = (m_vSceneMax + m_vSceneMin) / 2.0f; // Midpoint of Scene 
+    glm::vec3 mid = m_vSceneCenter; // Midpoint of Scene 
 
     glm::mat4 offset_mat = { // offset matrix to make object at origin
         {1.0f, 0.0f, 0.0f, 0.0f}, 
@@ -427,11 +437,7 @@ void MyCamera::_fitAll()
     m_m4ViewMatrix[3][1] = 0.0f; 
     m_m4ViewMatrix[3][2] = 0.0f; 
 
-    // float scale_factor = 1.0f; // optional scaling factor to determine how much space the scene should occupy when this function is called
-
-    float radius = glm::length(m_vSceneMax - mid); // multiply scale_factor if desired
-
-    float view_dist = radius / (glm::tan(glm::radians(25.f))); // viewing distance that is needed to look at all scene
+    float view_dist = _fitDistance(); // viewing distance that is needed to look at all scene
 
     glm::vec3 view_vec = {0.0f, 0.0f, 1.0f}; 
 
@@ -449,6 +455,16 @@ void MyCamera::_fitAll()
     m_m4ViewMatrix = m_m4TempTransform * inverse_offset_mat * m_m4ViewMatrix * offset_mat; 
 } 
 
+float MyCamera::_fitDistance() const
+{
+    // The sphere touches the sides of the narrower half of the field of view,
+    // which is the horizontal one when the window is taller than wide
+    float half_fovy = m_fFovy / 2.0f;
+    float half_fovx = atanf(tanf(half_fovy) * m_fAspect);
+
+    return m_fSceneRadius / sinf(std::min(half_fovy, half_fovx));
+}
+
 void MyCamera::_getScreenXYZ(glm::vec3& sx, glm::vec3& sy, glm::vec3& sz)
 {
     sx.x = m_m4ViewMatrix[0][0];
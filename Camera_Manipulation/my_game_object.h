@@ -5,6 +5,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
+#include <atomic>
 #include <memory>
 
 struct TransformComponent
@@ -77,9 +78,10 @@ class MyGameObject
 public:
 	using id_t = unsigned int;
 
+	// Can be called from any thread, e.g. while loading models in the background
 	static MyGameObject createGameObject()
 	{
-		static id_t currentID = 0;
+		static std::atomic<id_t> currentID{ 0 };
 		return MyGameObject{ currentID++ };
 	}
 
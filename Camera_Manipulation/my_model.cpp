@@ -1,4 +1,5 @@
 #include "my_model.h"
+#include "my_bvh.h"
 #include "my_utils.h"
 
 // libs
@@ -34,7 +35,8 @@ MyModel::MyModel(MyDevice& device, const std::vector<Vertex>& vertices) :
 
 MyModel::MyModel(MyDevice& device, const MyModel::Builder& builder) : 
 	m_myDevice{ device },
-	m_iVertexCount{ 0 }
+	m_iVertexCount{ 0 },
+	m_pBvh{ std::make_unique<MyBvh>(builder) }
 {
 	_createVertexBuffer(builder.vertices, true);
 	_createIndexBuffers(builder.indices);
@@ -235,12 +237,12 @@ void MyModel::Builder::loadModel(const std::string& filepath, glm::vec3& min, gl
 	std::unordered_map<Vertex, uint32_t> uniqueVertices{};
 
 	// Assigment: get min and max out of obj
-	float fmin = std::numeric_limits<float>::min();
+	// Note: numeric_limits<float>::min() is the smallest positive float, the lowest is -max()
 	float fmax = std::numeric_limits<float>::max();
 
 	// Initialize min max variables
 	min = glm::vec3(fmax, fmax, fmax);
-	max = glm::vec3(fmin, fmin, fmin);
+	max = glm::vec3(-fmax, -fmax, -fmax);
 
 	for (const auto& shape : shapes)
 	{
@@ -12,6 +12,8 @@
 #include <memory>
 #include <vector>
 
+class MyBvh;
+
 // Read vertex data from CPU and copy the data into GPU
 class MyModel
 {
@@ -56,6 +58,9 @@ public:
 	void bind(VkCommandBuffer commandBuffer);
 	void draw(VkCommandBuffer commandBuffer);
 
+	// Triangles of the model for ray queries, nullptr if the model was not made from a Builder
+	const MyBvh* bvh() const { return m_pBvh.get(); }
+
 private:
 
 	void _createVertexBuffer(const std::vector<Vertex>& vertices, bool bUseIndexBuffer = false);
@@ -70,6 +75,8 @@ private:
 	VkBuffer       m_vkIndexBuffer;
 	VkDeviceMemory m_vkIndexBufferMemory;
 	uint32_t       m_iIndexCount;
+
+	std::unique_ptr<MyBvh> m_pBvh;
 };
 
 #endif
@@ -66,13 +66,13 @@ void MySimpleRenderSystem::_createPipeline(VkRenderPass renderPass)
 
 void MySimpleRenderSystem::renderGameObjects(
     VkCommandBuffer commandBuffer, 
-    std::vector<MyGameObject>& gameObjects,
+    MySlotMap<MyGameObject>& gameObjects,
     const MyCamera &camera) 
 {
     m_pMyPipeline->bind(commandBuffer);
     auto projectionView = camera.projectionMatrix() * camera.viewMatrix();
 
-    for (auto& obj : gameObjects)
+    gameObjects.forEach([&](MySlotHandle, MyGameObject& obj)
     {
         // Note: X to the right, Y up and Z out of the screen
         // obj.transform.rotation.y = glm::mod(obj.transform.rotation.y + 0.0005f, glm::two_pi<float>());  // Y up
@@ -81,13 +81,6 @@ void MySimpleRenderSystem::renderGameObjects(
 
         MySimplePushConstantData push{};
 
-        // Keep rotating the colored cube
-        if (obj.getID() == 1)
-        {
-            obj.transform.rotation.x += 0.01f;
-            obj.transform.rotation.y += 0.01f;
-            obj.transform.rotation.z += 0.01f;
-        }
         auto modelMatrix = obj.transform.mat4();
 
         // Note: do this for now to perform on CPU
@@ -105,6 +98,6 @@ void MySimpleRenderSystem::renderGameObjects(
 
         obj.model->bind(commandBuffer);
         obj.model->draw(commandBuffer);
-    }
+    });
 }
 
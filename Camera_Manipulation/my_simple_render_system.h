@@ -3,6 +3,7 @@
 
 #include "my_device.h"
 #include "my_game_object.h"
+#include "my_slot_map.h"
 #include "my_pipeline.h"
 #include "my_camera.h"
 
@@ -20,7 +21,7 @@ public:
 	MySimpleRenderSystem(const MySimpleRenderSystem&) = delete;
 	MySimpleRenderSystem& operator=(const MySimpleRenderSystem&) = delete;
 
-	void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<MyGameObject>& gameObjects, const MyCamera &camera);
+	void renderGameObjects(VkCommandBuffer commandBuffer, MySlotMap<MyGameObject>& gameObjects, const MyCamera &camera);
 
 private:
 	void _createPipelineLayout();
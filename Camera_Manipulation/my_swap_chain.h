@@ -12,6 +12,10 @@
 #include <vector>
 
 
+//
+// When the device is headless, the swap chain images are replaced by a ring of offscreen
+// color images that are left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL and never presented
+//
 class MySwapChain 
 {
 public:
@@ -56,6 +60,7 @@ public:
 private:
     void _init();
     void _createSwapChain();
+    void _createOffscreenImages();
     void _createImageViews();
     void _createDepthResources();
     void _createRenderPass();
@@ -78,12 +83,13 @@ private:
     std::vector<VkDeviceMemory>  m_vVkDepthImageMemorys;
     std::vector<VkImageView>     m_vVkDepthImageViews;
     std::vector<VkImage>         m_vVkSwapChainImages;
+    std::vector<VkDeviceMemory>  m_vVkSwapChainImageMemorys; // only the offscreen images own their memory
     std::vector<VkImageView>     m_vVkSwapChainImageViews;
     
     MyDevice                    &m_myDevice;
     VkExtent2D                   m_vkWindowExtent;
     
-    VkSwapchainKHR               m_vkSwapChain;
+    VkSwapchainKHR               m_vkSwapChain = VK_NULL_HANDLE;
     std::shared_ptr<MySwapChain> m_pMyOldSwapChain;
     
     std::vector<VkSemaphore>     m_vVkImageAvailableSemaphores;
@@ -91,6 +97,7 @@ private:
     std::vector<VkFence>         m_vVkInFlightFences;
     std::vector<VkFence>         m_vVkImagesInFlight;
     size_t                       m_iCurrentFrame = 0;
+    uint32_t                     m_iNextOffscreenImage = 0;
 };
 
 #endif
@@ -4,21 +4,37 @@
 #include <stdexcept>
 #include <iostream>
 
-MyWindow::MyWindow(int w, int h, std::string name) : 
+MyWindow::MyWindow(int w, int h, std::string name, bool bHeadless) : 
 	m_iWidth(w),
 	m_iHeight(h),
+	m_bframeBufferResize(false),
+	m_bHeadless(bHeadless),
 	m_sWindowName(name),
 	m_pWindow(nullptr),
-	m_bframeBufferResize(false),
 	m_pMyApplication(nullptr)
 {
-	_initWindow();
+	// No display is needed to render offscreen
+	if (!m_bHeadless)
+	{
+		_initWindow();
+	}
 }
 
 MyWindow::~MyWindow()
 {
-	glfwDestroyWindow(m_pWindow);
-	glfwTerminate();
+	if (!m_bHeadless)
+	{
+		glfwDestroyWindow(m_pWindow);
+		glfwTerminate();
+	}
+}
+
+void MyWindow::requestClose()
+{
+	if (m_bHeadless)
+		m_bCloseRequested = true;
+	else
+		glfwSetWindowShouldClose(m_pWindow, 1);
 }
 
 void MyWindow::_initWindow()
@@ -47,10 +63,18 @@ void MyWindow::_initWindow()
 	
 	// Register mouse button callback
 	glfwSetMouseButtonCallback(m_pWindow, s_mouseButtonCallback);
+
+	// Redraw when the content of the window is damaged, e.g. uncovered by another window
+	glfwSetWindowRefreshCallback(m_pWindow, s_windowRefreshCallback);
 }
 
 void MyWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
 {
+	if (m_bHeadless)
+	{
+		throw std::runtime_error("Headless window has no surface");
+	}
+
 	if (glfwCreateWindowSurface(instance, m_pWindow, nullptr, surface) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create window");
@@ -63,6 +87,13 @@ void MyWindow::s_frameBufferResizeCallback(GLFWwindow* window, int width, int he
 	mywindow->m_bframeBufferResize = true;
 	mywindow->m_iWidth = width;
 	mywindow->m_iHeight = height;
+	mywindow->invalidate();
+}
+
+void MyWindow::s_windowRefreshCallback(GLFWwindow* window)
+{
+	auto mywindow = reinterpret_cast<MyWindow*>(glfwGetWindowUserPointer(window));
+	mywindow->invalidate();
 }
 
 void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -73,6 +104,8 @@ void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int
 	if ((key == GLFW_KEY_C || key == GLFW_KEY_ESCAPE ||
 		 key == GLFW_KEY_F || key == GLFW_KEY_R || key == GLFW_KEY_P || key == GLFW_KEY_Z || key == GLFW_KEY_T))
 	{
+		mywindow->invalidate();
+
 		if (action == GLFW_PRESS)
 			mywindow->keyboardEvent(key, true);
 		if (action == GLFW_RELEASE)
@@ -82,11 +115,33 @@ void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int
 
 void MyWindow::pollEvents()
 {
+	if (m_bHeadless) return;
+
 	glfwPollEvents();
-	
+	_dispatchMouseMotion();
+}
+
+void MyWindow::waitEventsTimeout(double seconds)
+{
+	if (m_bHeadless) return;
+
+	glfwWaitEventsTimeout(seconds);
+	_dispatchMouseMotion();
+}
+
+void MyWindow::_dispatchMouseMotion()
+{
 	double xpos = 0.0, ypos = 0.0;
 	glfwGetCursorPos(m_pWindow, &xpos, &ypos);
 
+	// A cursor that has not moved changes nothing, and would keep an idle application busy
+	if (xpos == m_dCursorX && ypos == m_dCursorY)
+	{
+		return;
+	}
+	m_dCursorX = xpos;
+	m_dCursorY = ypos;
+
 	float fMousePos[2];
 	fMousePos[0] = (float)xpos / (float)m_iWidth;
 	fMousePos[1] = (float)ypos / (float)m_iHeight;
@@ -96,11 +151,20 @@ void MyWindow::pollEvents()
 
 void MyWindow::waitEvents()
 {
+	if (m_bHeadless) return;
+
 	glfwWaitEvents();
 }
 
 const char** MyWindow::getRequiredInstanceExtensions(uint32_t* extensionCount)
 {
+	// Without a surface no window system extension is needed
+	if (m_bHeadless)
+	{
+		*extensionCount = 0;
+		return nullptr;
+	}
+
 	return glfwGetRequiredInstanceExtensions(extensionCount);
 }
 
@@ -146,6 +210,7 @@ void MyWindow::keyboardEvent(int key, bool bKeyDown)
 void MyWindow::s_mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
 	auto mywindow = reinterpret_cast<MyWindow*>(glfwGetWindowUserPointer(window));
+	mywindow->invalidate();
 
 	double xpos, ypos;
 	glfwGetCursorPos(window, &xpos, &ypos);
@@ -9,10 +9,14 @@
 
 class MyApplication;
 
+//
+// A headless window has no GLFW window and no surface. It only keeps the extent
+// to render offscreen at, and is closed by the application calling requestClose()
+//
 class MyWindow
 {
 public:
-	MyWindow(int w, int h, std::string name);
+	MyWindow(int w, int h, std::string name, bool bHeadless = false);
 	~MyWindow();
 
 	// Cannot do copy contrucror or assignment
@@ -20,7 +24,9 @@ public:
 	MyWindow(const MyWindow&) = delete;
 	MyWindow& operator=(const MyWindow&) = delete;
 
-	bool       shouldClose()            { return glfwWindowShouldClose(m_pWindow); }
+	bool       shouldClose()            { return m_bHeadless ? m_bCloseRequested : glfwWindowShouldClose(m_pWindow); }
+	bool       isHeadless()       const { return m_bHeadless; }
+	void       requestClose();
 	VkExtent2D extent()                 { return { static_cast<uint32_t>(m_iWidth), static_cast<uint32_t>(m_iHeight) }; };
 	bool       wasWindowResized()       { return m_bframeBufferResize; }
 	GLFWwindow* glfwWindow()      const { return m_pWindow; }
@@ -30,6 +36,13 @@ public:
 	void       pollEvents();
 	void       waitEvents();
 
+	// Idle rendering. Input marks the window dirty, the application marks it dirty when
+	// anything else changes what is drawn and clears it once a frame has been drawn
+	void       waitEventsTimeout(double seconds);
+	void       invalidate()             { m_bDirty = true; }
+	bool       isDirty()          const { return m_bDirty; }
+	void       clearDirty()             { m_bDirty = false; }
+
 	const char** getRequiredInstanceExtensions(uint32_t *extensionCount);
 
 	// Application specific functions
@@ -38,15 +51,23 @@ public:
 
 private:
 	static void s_keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void s_windowRefreshCallback(GLFWwindow* window);
 	static void s_frameBufferResizeCallback(GLFWwindow* window, int width, int height);
 	static void s_mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 
 	void _initWindow();
+	void _dispatchMouseMotion();
 
 	int            m_iWidth;
 	int            m_iHeight;
 	bool           m_bframeBufferResize = false;
 
+	bool           m_bHeadless;
+	bool           m_bCloseRequested = false;
+	bool           m_bDirty = true;     // the first frame is always drawn
+	double         m_dCursorX = -1.0;   // last cursor position given to the application
+	double         m_dCursorY = -1.0;
+
 	std::string    m_sWindowName;
 	GLFWwindow*    m_pWindow;
 
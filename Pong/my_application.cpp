@@ -3,6 +3,8 @@
 // Render system
 #include "my_simple_render_system.h"
 
+#include "my_cpu_profiler.h"
+
 // use radian rather degree for angle
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -11,13 +13,17 @@
 
 // Std
 #include <stdexcept>
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <iostream>
 #include <time.h>
 #include <cstdlib>
 #include <windows.h>
 
-MyApplication::MyApplication()
+MyApplication::MyApplication(uint32_t headlessFrames) :
+    m_iHeadlessFrames(headlessFrames),
+    m_myWindow{ WIDTH, HEIGHT, "Assignment 2", headlessFrames > 0 }
 {
     _loadGameObjects();
 }
@@ -40,8 +46,16 @@ void MyApplication::run()
 
     time(&start); //start timer
 
+    auto startTime = std::chrono::high_resolution_clock::now();
+    uint32_t frameCount = 0;
+
+    // Phases of the frame, reported every MyCpuProfiler::DEFAULT_REPORT_INTERVAL frames
+    MyCpuProfiler& cpuProfiler = MyCpuProfiler::instance();
+
     while (!m_myWindow.shouldClose()) 
     {
+        uint64_t frameStart = cpuProfiler.now();
+
         time(&end); 
         elapsed = difftime(end, start); //calculate elapsed time in seconds. 
 
@@ -59,25 +73,65 @@ void MyApplication::run()
         // will cause the event proecssing to block during a Window move, resize or
         // menu operation. Users can use the "window refresh callback" to redraw the
         // contents of the window when necessary during such operation.
-        m_myWindow.pollEvents();
+        // The ball moves every frame, so unlike the other applications Pong never
+        // waits for events and always renders continuously
+        {
+            MyCpuScope scope{ "pollEvents" };
+            m_myWindow.pollEvents();
+        }
 		
-        _updateGameLogic();
+        {
+            MyCpuScope scope{ "update" };
+            _updateGameLogic();
+        }
 
         // Please note that commandBuffer could be null pointer
-        // if the swapChain needs to be recreated
-        if (auto commandBuffer = m_myRenderer.beginFrame())
+        // if the swapChain needs to be recreated.
+        // Includes the wait for the fence of the frame in flight
+        VkCommandBuffer commandBuffer;
+        {
+            MyCpuScope scope{ "beginFrame" };
+            commandBuffer = m_myRenderer.beginFrame();
+        }
+
+        if (commandBuffer)
 		{
+            uint64_t recordStart = cpuProfiler.now();
+
             // In case we have multiple render passes for the current frame
             // begin offsreen shadow pass
             // render shadow casting objects
             // end offscreen shadow pass
 
             m_myRenderer.beginSwapChainRenderPass(commandBuffer);
-            simpleRenderSystem.renderGameObjects(commandBuffer, m_vMyGameObjects);
+            simpleRenderSystem.renderGameObjects(commandBuffer, m_myWorld);
             m_myRenderer.endSwapChainRenderPass(commandBuffer);
 
-            m_myRenderer.endFrame();
+            cpuProfiler.record("record", recordStart, cpuProfiler.now());
+
+            {
+                MyCpuScope scope{ "endFrame" };
+                m_myRenderer.endFrame();
+            }
+
+            if (m_myWindow.isHeadless() && ++frameCount >= m_iHeadlessFrames)
+            {
+                m_myWindow.requestClose();
+            }
         }
+
+        cpuProfiler.record("frame", frameStart, cpuProfiler.now());
+        cpuProfiler.endFrame();
+    }
+
+    if (m_myWindow.isHeadless())
+    {
+        float totalTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+        std::cout << "Headless: " << frameCount << " frames in " << totalTime << " ms ("
+                  << totalTime / std::max(frameCount, 1u) << " ms per frame)" << std::endl;
+        cpuProfiler.printReport(std::cout);
+        cpuProfiler.writeChromeTrace("cpu_trace.json");
     }
 
     // GPU will block until all CPU is complete
@@ -104,16 +158,15 @@ void MyApplication::_loadGameObjects()
 
     auto model1 = std::make_shared<MyModel>(m_myDevice, vertices1);
 
-    auto paddle1 = MyGameObject::createGameObject("paddle1");
-    paddle1.half_width = half_width; 
-    paddle1.top_y = top_y; 
-    paddle1.bottom_y = bottom_y; 
-    paddle1.model = model1;
-    paddle1.transform2d.translation.x = 0.0f; 
-    paddle1.transform2d.scale = {1.0f, 1.0f};
-    paddle1.transform2d.rotation = 0.0f * glm::two_pi<float>(); // 90 degree rotation
+    Transform2dComponent transform1{};
+    transform1.translation.x = 0.0f; 
+    transform1.scale = {1.0f, 1.0f};
+    transform1.rotation = 0.0f * glm::two_pi<float>(); // 90 degree rotation
 
-    m_vMyGameObjects.push_back(std::move(paddle1));
+    m_myPaddleEntities[0] = m_myWorld.create(
+        PaddleComponent{ half_width, top_y, bottom_y }, 
+        ModelComponent{ model1 }, 
+        transform1);
 
 ////////////////////////////////////////////////////////////////////////////
 
@@ -133,16 +186,15 @@ void MyApplication::_loadGameObjects()
 
     auto model2 = std::make_shared<MyModel>(m_myDevice, vertices2);
 
-    auto paddle2 = MyGameObject::createGameObject("paddle2");
-    paddle2.half_width = half_width; 
-    paddle2.top_y = top_y; 
-    paddle2.bottom_y = bottom_y; 
-    paddle2.model = model2;
-    paddle2.transform2d.translation.x = 0.0f; 
-    paddle2.transform2d.scale = {1.0f, 1.0f};
-    paddle2.transform2d.rotation = 0.0f * glm::two_pi<float>(); // 90 degree rotation
+    Transform2dComponent transform2{};
+    transform2.translation.x = 0.0f; 
+    transform2.scale = {1.0f, 1.0f};
+    transform2.rotation = 0.0f * glm::two_pi<float>(); // 90 degree rotation
 
-    m_vMyGameObjects.push_back(std::move(paddle2));
+    m_myPaddleEntities[1] = m_myWorld.create(
+        PaddleComponent{ half_width, top_y, bottom_y }, 
+        ModelComponent{ model2 }, 
+        transform2);
 
 ////////////////////////////////////////////////////////////////////////////
 
@@ -168,49 +220,38 @@ void MyApplication::_loadGameObjects()
 
     auto model3 = std::make_shared<MyModel>(m_myDevice, vertices3);
 
-    auto ball = MyGameObject::createGameObject("ball");
+    Transform2dComponent transform3{};
+    transform3.translation.x = 0.0f; 
+    transform3.scale = {1.0f, 1.0f};
+    transform3.rotation = 0.0f * glm::two_pi<float>(); // 90 degree rotation
+
+    BallComponent ball{};
     ball.half_width = half_width; 
-    ball.top_y = top_y; 
-    ball.bottom_y = bottom_y; 
-    ball.model = model3;
-    ball.transform2d.translation.x = 0.0f; 
-    ball.transform2d.scale = {1.0f, 1.0f};
-    ball.transform2d.rotation = 0.0f * glm::two_pi<float>(); // 90 degree rotation
-
-    m_vMyGameObjects.push_back(std::move(ball));
+
+    MyEntity ballEntity = m_myWorld.create(ball, ModelComponent{ model3 }, transform3);
+
+    // Named for lookups outside the frame, the game logic only uses the handles
+    MyNameTable& nameTable = MyNameTable::instance();
+    m_myWorld.setName(m_myPaddleEntities[0], nameTable.intern("paddle1"));
+    m_myWorld.setName(m_myPaddleEntities[1], nameTable.intern("paddle2"));
+    m_myWorld.setName(ballEntity, nameTable.intern("ball"));
 }
 
 void MyApplication::_updateGameLogic()
 {
-    MyPaddle* pPaddle1, * pPaddle2; 
-    MyBall* pBall; 
-
-    for (auto& obj : m_vMyGameObjects)
-    {
-        if (obj.getName() == "paddle1")
-        {
-            pPaddle1 = (MyPaddle*)&obj; 
-        }
-        else if (obj.getName() == "paddle2")
-        {
-            pPaddle2 = (MyPaddle*)&obj; 
-        }
-        else if (obj.getName() == "ball")
-        {
-            pBall = (MyBall*)&obj; 
-        }
-    }
-
-    pBall -> UpdateGameLogic(pPaddle1, pPaddle2, m_speed_multiplier); 
-    
+    MyPongSystem::updateBalls(m_myWorld, m_myPaddleEntities[0], m_myPaddleEntities[1], m_speed_multiplier); 
 }
 
 
 void MyApplication::movePaddle(int index, bool moveLeftOrRight)
 {
     // As per construction, the top paddle has index 0 and the bottom paddle has index 1
-    MyPaddle* pPaddle = (MyPaddle*)&m_vMyGameObjects[index];
-    pPaddle -> UpdateGameLogic(0.3f, moveLeftOrRight, m_paddle_speed); 
+    MyEntity paddle = m_myPaddleEntities[index];
+    MyPongSystem::movePaddle(
+        m_myWorld.get<Transform2dComponent>(paddle), 
+        m_myWorld.get<PaddleComponent>(paddle), 
+        moveLeftOrRight, 
+        m_paddle_speed); 
 
 }
 
@@ -218,11 +259,10 @@ void MyApplication::resetGame()
 {
     std::cout << "Reset game!" << std::endl;
 
-    for (auto& obj : m_vMyGameObjects)
+    m_myWorld.each<Transform2dComponent>([](Transform2dComponent& transform2d)
     {
-        obj.setX(0.0f);    
-        obj.setY(0.0f);   
-    }
+        transform2d.translation = glm::vec2(0.0f, 0.0f);   
+    });
 
     m_speed_multiplier = 1.0f; 
     m_paddle_speed = 0.01f;
@@ -4,6 +4,7 @@
 #include "my_window.h"
 #include "my_device.h"
 #include "my_renderer.h"
+#include "my_ecs.h"
 #include "my_game_object.h"
 
 #include <memory>
@@ -15,7 +16,9 @@ public:
 	static constexpr int WIDTH = 1000;
 	static constexpr int HEIGHT = 1000;
 
-	MyApplication();
+	// With headlessFrames > 0 nothing is shown, the given number of frames
+	// are rendered offscreen and run() returns
+	MyApplication(uint32_t headlessFrames = 0);
 	~MyApplication();
 
 	MyApplication(const MyApplication&) = delete;
@@ -29,11 +32,13 @@ private:
     void _loadGameObjects();
 	void _updateGameLogic();
 
+	uint32_t                  m_iHeadlessFrames;
 	MyWindow                  m_myWindow{ WIDTH, HEIGHT, "Assignment 2" };
 	MyDevice                  m_myDevice{ m_myWindow };
 	MyRenderer                m_myRenderer{ m_myWindow, m_myDevice };
 
-	std::vector<MyGameObject> m_vMyGameObjects;
+	MyWorld                   m_myWorld;
+	MyEntity                  m_myPaddleEntities[2];   // 0 is the top paddle and 1 the bottom one, as indexed by movePaddle
 	float m_speed_multiplier = 1.0f; 
 	float m_paddle_speed = 0.01f; 
 };
@@ -0,0 +1,153 @@
+#include "my_cpu_profiler.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+MyCpuProfiler& MyCpuProfiler::instance()
+{
+	static MyCpuProfiler profiler;
+	return profiler;
+}
+
+MyCpuProfiler::MyCpuProfiler() :
+	m_startTime{ std::chrono::steady_clock::now() }
+{
+}
+
+uint64_t MyCpuProfiler::now() const
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - m_startTime).count());
+}
+
+MyCpuProfiler::ThreadRing& MyCpuProfiler::_threadRing()
+{
+	// The ring is owned by the profiler so the events of a thread that
+	// has exited are still there for the report and the trace
+	thread_local ThreadRing* pThreadRing = nullptr;
+
+	if (pThreadRing == nullptr)
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		auto threadRing = std::make_unique<ThreadRing>();
+		threadRing->threadID = static_cast<uint32_t>(m_vThreadRings.size());
+		threadRing->vEvents.resize(RING_SIZE);
+
+		pThreadRing = threadRing.get();
+		m_vThreadRings.push_back(std::move(threadRing));
+	}
+
+	return *pThreadRing;
+}
+
+void MyCpuProfiler::record(const char* name, uint64_t startNs, uint64_t endNs)
+{
+	ThreadRing& threadRing = _threadRing();
+
+	// Only contended while a report or trace is being written
+	std::lock_guard<std::mutex> lock{ threadRing.mutex };
+	threadRing.vEvents[threadRing.written % RING_SIZE] = Event{ name, startNs, endNs - startNs };
+	threadRing.written++;
+}
+
+void MyCpuProfiler::endFrame()
+{
+	m_iFrameCount++;
+
+	if (m_iReportInterval > 0 && m_iFrameCount % m_iReportInterval == 0)
+	{
+		printReport(std::cout);
+	}
+}
+
+void MyCpuProfiler::printReport(std::ostream& out)
+{
+	uint64_t reportNs = now();
+
+	// Durations of every scope name since the last report, ordered by name
+	std::map<std::string, std::vector<float>> samples;
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		for (auto& threadRing : m_vThreadRings)
+		{
+			std::lock_guard<std::mutex> ringLock{ threadRing->mutex };
+
+			uint64_t count = std::min<uint64_t>(threadRing->written, RING_SIZE);
+			for (uint64_t i = threadRing->written - count; i < threadRing->written; i++)
+			{
+				const Event& event = threadRing->vEvents[i % RING_SIZE];
+				if (event.startNs >= m_iLastReportNs)
+				{
+					samples[event.name].push_back(event.durationNs / 1000000.0f);
+				}
+			}
+		}
+	}
+
+	m_iLastReportNs = reportNs;
+
+	out << "CPU time per phase (ms)" << std::endl;
+	out << std::left << std::setw(24) << "phase" << std::right << std::setw(8) << "count"
+		<< std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::endl;
+
+	auto percentile = [](const std::vector<float>& sorted, double p)
+	{
+		size_t index = static_cast<size_t>(std::ceil(p * sorted.size()));
+		return sorted[std::max<size_t>(index, 1) - 1];
+	};
+
+	out << std::fixed << std::setprecision(3);
+	for (auto& kv : samples)
+	{
+		std::vector<float>& durations = kv.second;
+		std::sort(durations.begin(), durations.end());
+
+		out << std::left << std::setw(24) << kv.first << std::right << std::setw(8) << durations.size()
+			<< std::setw(10) << percentile(durations, 0.50)
+			<< std::setw(10) << percentile(durations, 0.95)
+			<< std::setw(10) << percentile(durations, 0.99) << std::endl;
+	}
+	out << std::defaultfloat;
+}
+
+void MyCpuProfiler::writeChromeTrace(const std::string& filepath)
+{
+	std::ofstream file{ filepath };
+	if (!file.is_open())
+	{
+		std::cout << "failed to open file: " << filepath << std::endl;
+		return;
+	}
+
+	// Complete events ("ph":"X"), the timestamps are in microseconds
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	file << std::fixed << std::setprecision(3);
+
+	bool bFirst = true;
+	std::lock_guard<std::mutex> lock{ m_mutex };
+	for (auto& threadRing : m_vThreadRings)
+	{
+		std::lock_guard<std::mutex> ringLock{ threadRing->mutex };
+
+		uint64_t count = std::min<uint64_t>(threadRing->written, RING_SIZE);
+		for (uint64_t i = threadRing->written - count; i < threadRing->written; i++)
+		{
+			const Event& event = threadRing->vEvents[i % RING_SIZE];
+
+			file << (bFirst ? "\n" : ",\n");
+			file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadRing->threadID
+				<< ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+			bFirst = false;
+		}
+	}
+
+	file << "\n]}\n";
+
+	std::cout << "CPU trace written to " << filepath << std::endl;
+}
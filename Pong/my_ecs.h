@@ -0,0 +1,290 @@
+#ifndef __MY_ECS_H__
+#define __MY_ECS_H__
+
+#include "my_name_table.h"
+#include "my_slot_map.h"
+
+// std
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Handle of an entity in a MyWorld, a destroyed entity never matches a newer one
+using MyEntity = MySlotHandle;
+
+using MyComponentID = uint32_t;
+using MyComponentMask = uint64_t;
+
+//
+// Process wide ids of the component types, a type gets its id the first time it is used
+//
+class MyComponentRegistry
+{
+public:
+	static constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+
+	struct Info
+	{
+		size_t size;
+		size_t alignment;
+		void (*moveConstruct)(void* dst, void* src);
+		void (*destroy)(void* component);
+	};
+
+	template<typename T>
+	static MyComponentID id()
+	{
+		static const MyComponentID s_iID = _register(Info{ sizeof(T), alignof(T), &_moveConstruct<T>, &_destroy<T> });
+		return s_iID;
+	}
+
+	template<typename... Ts>
+	static MyComponentMask mask()
+	{
+		MyComponentMask result = 0;
+		int unused[] = { 0, (result |= MyComponentMask{ 1 } << id<typename std::decay<Ts>::type>(), 0)... };
+		(void)unused;
+		return result;
+	}
+
+	static const Info& info(MyComponentID id);
+
+private:
+	template<typename T>
+	static void _moveConstruct(void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); }
+
+	template<typename T>
+	static void _destroy(void* component) { static_cast<T*>(component)->~T(); }
+
+	static MyComponentID _register(const Info& info);
+};
+
+//
+// All the entities with exactly the same set of components. They are stored in fixed size
+// chunks, each chunk holds one contiguous array per component and one of the entity handles,
+// so a query walks every array linearly. Removing a row moves the last row of the archetype into it
+//
+class MyArchetype
+{
+public:
+	// Bytes of one chunk, a row bigger than this gets a chunk of its own
+	static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+	MyArchetype(MyComponentMask mask);
+	~MyArchetype();
+
+	MyArchetype(const MyArchetype&) = delete;
+	MyArchetype& operator=(const MyArchetype&) = delete;
+
+	MyComponentMask mask()                const { return m_iMask; }
+	bool            has(MyComponentID id) const { return (m_iMask >> id) & 1; }
+	uint32_t        chunkCount()          const { return static_cast<uint32_t>(m_vChunks.size()); }
+	uint32_t        rowCount(uint32_t chunk) const { return m_vChunks[chunk].count; }
+	uint32_t        rowsPerChunk()        const { return m_iRowsPerChunk; }
+	const std::vector<MyComponentID>& componentIDs() const { return m_vComponentIDs; }
+
+	MyEntity*       entities(uint32_t chunk) { return reinterpret_cast<MyEntity*>(m_vChunks[chunk].pData.get()); }
+	void*           component(MyComponentID id, uint32_t chunk, uint32_t row);
+
+	template<typename T>
+	T*              components(uint32_t chunk)
+	{
+		MyComponentID id = MyComponentRegistry::id<T>();
+		assert(has(id) && "Archetype does not have the component");
+		return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(m_vChunks[chunk].pData.get()) + m_vOffsets[id]);
+	}
+
+	// Appends a row for entity whose components are left unconstructed,
+	// the caller constructs every one of them
+	void            allocateRow(MyEntity entity, uint32_t& chunk, uint32_t& row);
+
+	// Destroys the components of the row and fills the hole with the last row. Returns
+	// the entity that was moved into the row, or an invalid entity if it was the last one
+	MyEntity        removeRow(uint32_t chunk, uint32_t row);
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<std::max_align_t[]> pData;
+		uint32_t                            count = 0;
+	};
+
+	MyComponentMask            m_iMask;
+	std::vector<MyComponentID> m_vComponentIDs;
+	std::vector<size_t>        m_vOffsets;      // offset of the array of each component in a chunk, indexed by component id
+	uint32_t                   m_iRowsPerChunk = 0;
+	size_t                     m_iChunkBytes = 0;
+	std::vector<Chunk>         m_vChunks;       // all full except the last one
+};
+
+//
+// Owns the entities and their components. Components are plain structs, an entity has at
+// most one of each type. Adding or removing a component moves the entity to another archetype,
+// so it must not happen inside each()
+//
+class MyWorld
+{
+public:
+	MyWorld() = default;
+
+	MyWorld(const MyWorld&) = delete;
+	MyWorld& operator=(const MyWorld&) = delete;
+
+	template<typename... Ts>
+	MyEntity create(Ts&&... components)
+	{
+		assert(!m_bIterating && "Entities cannot be created inside each()");
+
+		MyArchetype* pArchetype = _archetype(MyComponentRegistry::mask<Ts...>());
+		MyEntity entity = m_myEntities.emplace();
+
+		EntityRecord& record = *m_myEntities.get(entity);
+		record.pArchetype = pArchetype;
+		pArchetype->allocateRow(entity, record.chunk, record.row);
+
+		int unused[] = { 0, (_construct(*pArchetype, record.chunk, record.row, std::forward<Ts>(components)), 0)... };
+		(void)unused;
+		return entity;
+	}
+
+	void destroy(MyEntity entity);
+	bool isAlive(MyEntity entity) const;
+	size_t size() const { return m_myEntities.size(); }
+
+	// Index of the entities by their interned name, one entity per name. Naming another
+	// entity with a name that is taken moves the name to it
+	void     setName(MyEntity entity, MyNameID name);
+	MyNameID nameOf(MyEntity entity) const { return _record(entity).name; }
+
+	// An invalid entity if no entity has the name
+	MyEntity find(MyNameID name) const;
+
+	template<typename T>
+	bool has(MyEntity entity) const
+	{
+		return _record(entity).pArchetype->has(MyComponentRegistry::id<T>());
+	}
+
+	template<typename T>
+	T& get(MyEntity entity)
+	{
+		T* pComponent = tryGet<T>(entity);
+		assert(pComponent != nullptr && "Entity does not have the component");
+		return *pComponent;
+	}
+
+	template<typename T>
+	T* tryGet(MyEntity entity)
+	{
+		const EntityRecord& record = _record(entity);
+		MyComponentID id = MyComponentRegistry::id<T>();
+		if (!record.pArchetype->has(id))
+		{
+			return nullptr;
+		}
+		return static_cast<T*>(record.pArchetype->component(id, record.chunk, record.row));
+	}
+
+	// Adds the component, or replaces it if the entity already has one
+	template<typename T>
+	T& add(MyEntity entity, T component)
+	{
+		if (T* pComponent = tryGet<T>(entity))
+		{
+			*pComponent = std::move(component);
+			return *pComponent;
+		}
+
+		const EntityRecord& record = _moveToArchetype(entity, _record(entity).pArchetype->mask() | MyComponentRegistry::mask<T>());
+		return *_construct(*record.pArchetype, record.chunk, record.row, std::move(component));
+	}
+
+	template<typename T>
+	void remove(MyEntity entity)
+	{
+		if (has<T>(entity))
+		{
+			_moveToArchetype(entity, _record(entity).pArchetype->mask() & ~MyComponentRegistry::mask<T>());
+		}
+	}
+
+	// Calls fn(Ts&...) for every entity that has all of Ts, chunk by chunk
+	template<typename... Ts, typename Fn>
+	void each(Fn&& fn)
+	{
+		MyComponentMask mask = MyComponentRegistry::mask<Ts...>();
+
+		bool bWasIterating = m_bIterating;
+		m_bIterating = true;
+		for (auto& pArchetype : m_vArchetypes)
+		{
+			if ((pArchetype->mask() & mask) != mask)
+			{
+				continue;
+			}
+
+			for (uint32_t chunk = 0; chunk < pArchetype->chunkCount(); chunk++)
+			{
+				_eachRow(fn, pArchetype->rowCount(chunk),
+					std::make_tuple(pArchetype->template components<Ts>(chunk)...),
+					std::index_sequence_for<Ts...>{});
+			}
+		}
+		m_bIterating = bWasIterating;
+	}
+
+private:
+	struct EntityRecord
+	{
+		MyArchetype* pArchetype = nullptr;
+		uint32_t     chunk = 0;
+		uint32_t     row = 0;
+		MyNameID     name = MyNameTable::INVALID_NAME;
+	};
+
+	const EntityRecord& _record(MyEntity entity) const
+	{
+		const EntityRecord* pRecord = m_myEntities.get(entity);
+		assert(pRecord != nullptr && "Entity was destroyed");
+		return *pRecord;
+	}
+
+	template<typename T>
+	typename std::decay<T>::type* _construct(MyArchetype& archetype, uint32_t chunk, uint32_t row, T&& component)
+	{
+		using Component = typename std::decay<T>::type;
+		void* pMemory = archetype.component(MyComponentRegistry::id<Component>(), chunk, row);
+		return new (pMemory) Component(std::forward<T>(component));
+	}
+
+	template<typename Fn, typename Arrays, size_t... Is>
+	static void _eachRow(Fn& fn, uint32_t rowCount, Arrays arrays, std::index_sequence<Is...>)
+	{
+		for (uint32_t row = 0; row < rowCount; row++)
+		{
+			fn(std::get<Is>(arrays)[row]...);
+		}
+	}
+
+	MyArchetype*        _archetype(MyComponentMask mask);
+
+	// Moves the components the two archetypes have in common, the ones only in
+	// the new archetype are left unconstructed for the caller
+	const EntityRecord& _moveToArchetype(MyEntity entity, MyComponentMask mask);
+	void                _removeRow(MyArchetype& archetype, uint32_t chunk, uint32_t row);
+
+	MySlotMap<EntityRecord>                                 m_myEntities;
+	std::unordered_map<MyNameID, MyEntity>                  m_mapNamedEntities;
+	std::vector<std::unique_ptr<MyArchetype>>               m_vArchetypes;
+	std::unordered_map<MyComponentMask, MyArchetype*>       m_mapArchetypes;
+	bool                                                    m_bIterating = false;
+};
+
+#endif
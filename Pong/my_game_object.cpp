@@ -1,96 +1,85 @@
 #include "my_game_object.h"
 
-float MyGameObject::getX()
+void MyPongSystem::movePaddle(Transform2dComponent& transform, const PaddleComponent& paddle, bool movingLeft, float paddle_speed)
 {
-    return transform2d.translation.x; 
-}
-
-float MyGameObject::getY()
-{
-    return transform2d.translation.y;
-}
-
-void MyGameObject::setX(float x)
-{
-    transform2d.translation.x = x; 
-}
-
-void MyGameObject::setY(float y)
-{
-    transform2d.translation.y = y; 
-}
+    float& x = transform.translation.x;
 
-void MyGameObject::translate_X_by(float direction)
-{
-    transform2d.translation.x += direction; 
-}
-
-void MyGameObject::translate_Y_by(float direction)
-{
-    transform2d.translation.y += direction;
-}
-
-void MyPaddle::UpdateGameLogic(float offset_in_x, bool movingLeft, float paddle_speed)
-{
     if (movingLeft)
     {
-        if (getX() - offset_in_x <= -1.0f)
+        if (x - paddle.half_width <= -1.0f)
         {
-            setX(-1.0f + offset_in_x); 
+            x = -1.0f + paddle.half_width;
         }
         else
         {
-            translate_X_by(-paddle_speed); 
+            x -= paddle_speed;
         }
     }
     else
     {
-        if (getX() + offset_in_x >= 1.0f)
+        if (x + paddle.half_width >= 1.0f)
         {
-            setX(1.0f - offset_in_x);  
+            x = 1.0f - paddle.half_width;
         }
         else
         {
-            translate_X_by(paddle_speed);
+            x += paddle_speed;
         }
     }
-} 
+}
 
-void MyBall::UpdateGameLogic(MyPaddle *top_paddle, MyPaddle *bottom_paddle, float m_speed_multiplier){
+void MyPongSystem::updateBalls(MyWorld& world, MyEntity top_paddle, MyEntity bottom_paddle, float speed_multiplier)
+{
+    const glm::vec2 left_norm = {1.0f, 0.0f};
+    const glm::vec2 right_norm = {-1.0f, 0.0f};
+    const glm::vec2 top_norm = {0.0f, 1.0f};
+    const glm::vec2 bottom_norm = {0.0f, -1.0f};
 
-    transform2d.rotation = glm::mod(transform2d.rotation + 0.5f, glm::two_pi<float>());
+    // Copied once, the balls never move a paddle
+    const PaddleComponent top = world.get<PaddleComponent>(top_paddle);
+    const PaddleComponent bottom = world.get<PaddleComponent>(bottom_paddle);
+    const float top_x = world.get<Transform2dComponent>(top_paddle).translation.x;
+    const float bottom_x = world.get<Transform2dComponent>(bottom_paddle).translation.x;
 
-    // If ball hit bottom paddle top side
-    if (getY() >= (bottom_paddle->top_y - half_width) && 
-        getY() <= (bottom_paddle->top_y) && 
-        getX() >= bottom_paddle->getX() - bottom_paddle->half_width && 
-        getX() <= bottom_paddle->getX() + bottom_paddle->half_width)  
+    world.each<BallComponent, Transform2dComponent>([&](BallComponent& ball, Transform2dComponent& transform)
     {
-        direction = direction - 2 * glm::dot(bottom_norm , direction) * bottom_norm; 
-    }
+        glm::vec2& position = transform.translation;
+        glm::vec2& direction = ball.direction;
 
-    // If ball hit top paddle bottom side
-    if (getY() <= (top_paddle->bottom_y + half_width) && 
-        getY() >= (top_paddle->bottom_y) && 
-        getX() >= top_paddle->getX() - top_paddle->half_width && 
-        getX() <= top_paddle->getX() + top_paddle->half_width)
-    {
-        direction = direction - 2 * glm::dot(top_norm , direction) * top_norm; 
-    }
+        transform.rotation = glm::mod(transform.rotation + 0.5f, glm::two_pi<float>());
 
-    // If ball hit right wall
-    if (getX() >= 1.0f - half_width)
-    {
-        direction = direction - 2 * glm::dot(right_norm , direction) * right_norm; 
-    }
+        // If ball hit bottom paddle top side
+        if (position.y >= (bottom.top_y - ball.half_width) &&
+            position.y <= (bottom.top_y) &&
+            position.x >= bottom_x - bottom.half_width &&
+            position.x <= bottom_x + bottom.half_width)
+        {
+            direction = direction - 2 * glm::dot(bottom_norm , direction) * bottom_norm;
+        }
 
-    // If ball hit left wall
-    if (getX() <= -1.0f + half_width)
-    { 
-        direction = direction - 2 * glm::dot(left_norm , direction) * left_norm; 
-    }
+        // If ball hit top paddle bottom side
+        if (position.y <= (top.bottom_y + ball.half_width) &&
+            position.y >= (top.bottom_y) &&
+            position.x >= top_x - top.half_width &&
+            position.x <= top_x + top.half_width)
+        {
+            direction = direction - 2 * glm::dot(top_norm , direction) * top_norm;
+        }
+
+        // If ball hit right wall
+        if (position.x >= 1.0f - ball.half_width)
+        {
+            direction = direction - 2 * glm::dot(right_norm , direction) * right_norm;
+        }
 
-    // Move ball correspondingly
-    translate_X_by(direction.x);
-    translate_Y_by(direction.y * m_speed_multiplier); 
-}
\ No newline at end of file
+        // If ball hit left wall
+        if (position.x <= -1.0f + ball.half_width)
+        {
+            direction = direction - 2 * glm::dot(left_norm , direction) * left_norm;
+        }
+
+        // Move ball correspondingly
+        position.x += direction.x;
+        position.y += direction.y * speed_multiplier;
+    });
+}
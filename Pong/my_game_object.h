@@ -1,6 +1,7 @@
 #ifndef __MY_GAMEOBJECT_H__
 #define __MY_GAMEOBJECT_H__
 
+#include "my_ecs.h"
 #include "my_model.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
@@ -26,68 +27,37 @@ struct Transform2dComponent
 	}
 };
 
-class MyGameObject
+//
+// Components of the entities in MyWorld, each system only iterates the ones it needs
+//
+struct ModelComponent
 {
-public:
-	using id_t = unsigned int;
-
-	static MyGameObject createGameObject(std::string name)
-	{
-		static id_t currentID = 0;
-		return MyGameObject(currentID++, name);
-	}
-
-	MyGameObject(const MyGameObject&) = delete;
-	MyGameObject& operator=(const MyGameObject&) = delete;
-	MyGameObject(MyGameObject&&) = default;
-	MyGameObject& operator=(MyGameObject&&) = default;
-
-	std::string              getName() const { return m_sName; };
-	id_t                     getID()   const { return m_iID; }
 	std::shared_ptr<MyModel> model{};
-	Transform2dComponent     transform2d{};
-	float                    half_width; 
-	float                    top_y; 
-	float                    bottom_y; 
-
-	float getX();
-	float getY();
-	void setX(float x);
-	void setY(float y);
-	void translate_X_by(float direction);
-	void translate_Y_by(float direction);
-
-protected:
-	MyGameObject(id_t objID, std::string name) : m_iID{ objID }, m_sName{ name } {}
-	id_t m_iID;
-	std::string m_sName;
-	
-	glm::vec2 left_norm = {1.0f, 0.0f}; 
-	glm::vec2 right_norm = {-1.0f, 0.0f}; 
-	glm::vec2 top_norm = {0.0f, 1.0f}; 
-	glm::vec2 bottom_norm = {0.0f, -1.0f}; 
-
-	glm::vec2 direction{ 0.01f, 0.005f };
 };
 
-
-class MyPaddle : public MyGameObject
+struct PaddleComponent
 {
-
-public:
-	MyPaddle(); 
-
-	void UpdateGameLogic(float offset_in_x, bool movingLeft, float paddle_speed);
+	float half_width;
+	float top_y;
+	float bottom_y;
 };
 
-class MyBall : public MyGameObject
+struct BallComponent
 {
+	float     half_width;
+	glm::vec2 direction{ 0.01f, 0.005f };
+};
 
+//
+// The game logic, each system only touches the components it needs
+//
+class MyPongSystem
+{
 public:
-	MyBall(); 
+	static void movePaddle(Transform2dComponent& transform, const PaddleComponent& paddle, bool movingLeft, float paddle_speed);
 
-	void UpdateGameLogic(MyPaddle *top_paddle, MyPaddle *bottom_paddle, float m_speed_multiplier);
+	// Bounces every ball off the walls and the two paddles and moves it
+	static void updateBalls(MyWorld& world, MyEntity top_paddle, MyEntity bottom_paddle, float speed_multiplier);
 };
-#endif
-
 
+#endif
@@ -65,15 +65,15 @@ void MySimpleRenderSystem::_createPipeline(VkRenderPass renderPass)
 }
 
 void MySimpleRenderSystem::renderGameObjects(
-    VkCommandBuffer commandBuffer, std::vector<MyGameObject>& gameObjects)
+    VkCommandBuffer commandBuffer, MyWorld& world)
 {
     m_pMyPipeline->bind(commandBuffer);
 
-    for (auto& obj : gameObjects)
+    world.each<Transform2dComponent, ModelComponent>([&](Transform2dComponent& transform2d, ModelComponent& obj)
     {    
         MySimplePushConstantData push{};
-        push.offset = obj.transform2d.translation;
-        push.transform = obj.transform2d.mat2();
+        push.offset = transform2d.translation;
+        push.transform = transform2d.mat2();
 
         vkCmdPushConstants(
             commandBuffer,
@@ -85,6 +85,6 @@ void MySimpleRenderSystem::renderGameObjects(
 
         obj.model->bind(commandBuffer);
         obj.model->draw(commandBuffer);
-    }
+    });
 }
 
@@ -2,6 +2,7 @@
 #define __MY_SIMPLE_RENDER_SYSTEM_H__
 
 #include "my_device.h"
+#include "my_ecs.h"
 #include "my_game_object.h"
 #include "my_pipeline.h"
 
@@ -19,7 +20,7 @@ public:
 	MySimpleRenderSystem(const MySimpleRenderSystem&) = delete;
 	MySimpleRenderSystem& operator=(const MySimpleRenderSystem&) = delete;
 
-	void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<MyGameObject>& gameObjects);
+	void renderGameObjects(VkCommandBuffer commandBuffer, MyWorld& world);
 
 private:
 	void _createPipelineLayout();
@@ -0,0 +1,210 @@
+#ifndef __MY_SLOT_MAP_H__
+#define __MY_SLOT_MAP_H__
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//
+// Handle of an element in a MySlotMap. The generation of a live element is odd, it is bumped
+// when the element is removed and again when its slot is reused, so an old handle never
+// matches a newer element
+//
+struct MySlotHandle
+{
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	uint32_t index = INVALID_INDEX;
+	uint32_t generation = 0;
+
+	bool isValid() const { return index != INVALID_INDEX; }
+	bool operator==(const MySlotHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const MySlotHandle& other) const { return !(*this == other); }
+};
+
+//
+// Elements in fixed size pages that are never moved, so a reference stays valid until its own
+// element is removed. insert and remove can be called from any thread, they are serialized by
+// a mutex. get is lock free and O(1): the page table never reallocates and a slot's generation
+// is published after its element was constructed. An element must not be removed while
+// another thread still uses it
+//
+template<typename T>
+class MySlotMap
+{
+public:
+	using Handle = MySlotHandle;
+
+	static constexpr uint32_t PAGE_SIZE = 256;     // slots per page
+	static constexpr uint32_t MAX_PAGES = 4096;    // at most PAGE_SIZE * MAX_PAGES elements
+
+	MySlotMap() :
+		m_pPages{ new std::atomic<Page*>[MAX_PAGES] }
+	{
+		for (uint32_t i = 0; i < MAX_PAGES; i++)
+		{
+			m_pPages[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	~MySlotMap()
+	{
+		clear();
+		for (uint32_t i = 0; i < m_iPageCount; i++)
+		{
+			delete m_pPages[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	MySlotMap(const MySlotMap&) = delete;
+	MySlotMap& operator=(const MySlotMap&) = delete;
+
+	template<typename... Args>
+	Handle emplace(Args&&... args)
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		uint32_t index = _allocateSlot();
+		Slot& slot = _slot(index);
+		new (&slot.storage) T(std::forward<Args>(args)...);
+
+		// Readers that see the odd generation also see the constructed element
+		uint32_t generation = slot.generation.load(std::memory_order_relaxed) + 1;
+		slot.generation.store(generation, std::memory_order_release);
+		m_iSize.fetch_add(1, std::memory_order_relaxed);
+
+		return Handle{ index, generation };
+	}
+
+	Handle insert(T value) { return emplace(std::move(value)); }
+
+	// Returns false if the handle was already stale
+	bool remove(Handle handle)
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		if (get(handle) == nullptr)
+		{
+			return false;
+		}
+
+		Slot& slot = _slot(handle.index);
+		slot.generation.store(handle.generation + 1, std::memory_order_release);
+		_element(slot)->~T();
+
+		slot.nextFree = m_iFirstFree;
+		m_iFirstFree = handle.index;
+		m_iSize.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// nullptr if the element was removed. An even generation never names a live element, even
+	// when it matches the slot of a removed one
+	T* get(Handle handle)
+	{
+		if ((handle.generation & 1) == 0 || handle.index >= m_iSlotCount.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		Slot& slot = _slot(handle.index);
+		if (slot.generation.load(std::memory_order_acquire) != handle.generation)
+		{
+			return nullptr;
+		}
+		return _element(slot);
+	}
+
+	const T* get(Handle handle) const { return const_cast<MySlotMap*>(this)->get(handle); }
+	bool     contains(Handle handle) const { return get(handle) != nullptr; }
+	size_t   size() const { return m_iSize.load(std::memory_order_relaxed); }
+
+	// Calls fn(Handle, T&) for every element in slot order. Must not run at the same time as
+	// insert or remove, fn itself must not insert or remove either
+	template<typename Fn>
+	void forEach(Fn&& fn)
+	{
+		uint32_t slotCount = m_iSlotCount.load(std::memory_order_acquire);
+		for (uint32_t index = 0; index < slotCount; index++)
+		{
+			Slot& slot = _slot(index);
+			uint32_t generation = slot.generation.load(std::memory_order_acquire);
+			if (generation & 1)
+			{
+				fn(Handle{ index, generation }, *_element(slot));
+			}
+		}
+	}
+
+	void clear()
+	{
+		std::vector<Handle> handles;
+		forEach([&](Handle handle, T&) { handles.push_back(handle); });
+		for (const Handle& handle : handles)
+		{
+			remove(handle);
+		}
+	}
+
+private:
+	struct Slot
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+		std::atomic<uint32_t> generation{ 0 };
+		uint32_t              nextFree = MySlotHandle::INVALID_INDEX;
+	};
+
+	struct Page
+	{
+		Slot slots[PAGE_SIZE];
+	};
+
+	Slot& _slot(uint32_t index)
+	{
+		return m_pPages[index / PAGE_SIZE].load(std::memory_order_acquire)->slots[index % PAGE_SIZE];
+	}
+
+	static T* _element(Slot& slot) { return reinterpret_cast<T*>(&slot.storage); }
+
+	// Called with the mutex held
+	uint32_t _allocateSlot()
+	{
+		if (m_iFirstFree != MySlotHandle::INVALID_INDEX)
+		{
+			uint32_t index = m_iFirstFree;
+			m_iFirstFree = _slot(index).nextFree;
+			return index;
+		}
+
+		uint32_t index = m_iSlotCount.load(std::memory_order_relaxed);
+		if (index == m_iPageCount * PAGE_SIZE)
+		{
+			if (m_iPageCount == MAX_PAGES)
+			{
+				throw std::runtime_error("slot map is full!");
+			}
+			m_pPages[m_iPageCount].store(new Page{}, std::memory_order_release);
+			m_iPageCount++;
+		}
+
+		// The slot is not visible to get until its generation is odd
+		m_iSlotCount.store(index + 1, std::memory_order_release);
+		return index;
+	}
+
+	std::unique_ptr<std::atomic<Page*>[]> m_pPages;
+	uint32_t                              m_iPageCount = 0;
+	std::atomic<uint32_t>                 m_iSlotCount{ 0 };
+	std::atomic<size_t>                   m_iSize{ 0 };
+	uint32_t                              m_iFirstFree = MySlotHandle::INVALID_INDEX;
+	std::mutex                            m_mutex;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "my_swap_chain.h"
+#include "my_cpu_profiler.h"
 
 // std
 #include <array>
@@ -30,7 +31,11 @@ MySwapChain::MySwapChain(MyDevice& deviceRef, VkExtent2D extent, std::shared_ptr
 
 void MySwapChain::_init()
 {
-    _createSwapChain();
+    if (m_myDevice.isHeadless())
+        _createOffscreenImages();
+    else
+        _createSwapChain();
+
     _createImageViews();
     _createRenderPass();
     _createDepthResources();
@@ -53,7 +58,13 @@ MySwapChain::~MySwapChain()
         m_vkSwapChain = nullptr;
     }
     
-    for (int i = 0; i < m_vVkDepthImages.size(); i++)
+    for (size_t i = 0; i < m_vVkSwapChainImageMemorys.size(); i++)
+    {
+        vkDestroyImage(m_myDevice.device(), m_vVkSwapChainImages[i], nullptr);
+        vkFreeMemory(m_myDevice.device(), m_vVkSwapChainImageMemorys[i], nullptr);
+    }
+    
+    for (size_t i = 0; i < m_vVkDepthImages.size(); i++)
     {
         vkDestroyImageView(m_myDevice.device(), m_vVkDepthImageViews[i], nullptr);
         vkDestroyImage(m_myDevice.device(), m_vVkDepthImages[i], nullptr);
@@ -79,13 +90,25 @@ MySwapChain::~MySwapChain()
 VkResult MySwapChain::acquireNextImage(uint32_t *imageIndex)
 {
     // Note: CPU will wait here at fences
-    vkWaitForFences(
-        m_myDevice.device(),
-        1,
-        &m_vVkInFlightFences[m_iCurrentFrame],
-        VK_TRUE,
-        std::numeric_limits<uint64_t>::max());
+    {
+        MyCpuScope scope{ "fence wait" };
+        vkWaitForFences(
+            m_myDevice.device(),
+            1,
+            &m_vVkInFlightFences[m_iCurrentFrame],
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max());
+    }
+    
+    // The offscreen images are used in turn, there is nothing to wait for
+    if (m_myDevice.isHeadless())
+    {
+        *imageIndex = m_iNextOffscreenImage;
+        m_iNextOffscreenImage = (m_iNextOffscreenImage + 1) % static_cast<uint32_t>(imageCount());
+        return VK_SUCCESS;
+    }
     
+    MyCpuScope scope{ "acquire" };
     VkResult result = vkAcquireNextImageKHR(
         m_myDevice.device(),
         m_vkSwapChain,
@@ -109,9 +132,12 @@ VkResult MySwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint3
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     
+    // Nothing is acquired or presented when headless, so only the fence is used
+    uint32_t semaphoreCount = m_myDevice.isHeadless() ? 0 : 1;
+    
     VkSemaphore waitSemaphores[] = {m_vVkImageAvailableSemaphores[m_iCurrentFrame]};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = semaphoreCount;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
     
@@ -119,13 +145,22 @@ VkResult MySwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint3
     submitInfo.pCommandBuffers = buffers;
     
     VkSemaphore signalSemaphores[] = {m_vVkRenderFinishedSemaphores[m_iCurrentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = semaphoreCount;
     submitInfo.pSignalSemaphores = signalSemaphores;
     
     vkResetFences(m_myDevice.device(), 1, &m_vVkInFlightFences[m_iCurrentFrame]);
-    if (vkQueueSubmit(m_myDevice.graphicsQueue(), 1, &submitInfo, m_vVkInFlightFences[m_iCurrentFrame]) != VK_SUCCESS) 
     {
-        throw std::runtime_error("failed to submit draw command buffer!");
+        MyCpuScope scope{ "submit" };
+        if (vkQueueSubmit(m_myDevice.graphicsQueue(), 1, &submitInfo, m_vVkInFlightFences[m_iCurrentFrame]) != VK_SUCCESS) 
+        {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+    }
+    
+    if (m_myDevice.isHeadless())
+    {
+        m_iCurrentFrame = (m_iCurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        return VK_SUCCESS;
     }
     
     VkPresentInfoKHR presentInfo = {};
@@ -140,7 +175,11 @@ VkResult MySwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint3
     
     presentInfo.pImageIndices = imageIndex;
     
-    auto result = vkQueuePresentKHR(m_myDevice.presentQueue(), &presentInfo);
+    VkResult result;
+    {
+        MyCpuScope scope{ "present" };
+        result = vkQueuePresentKHR(m_myDevice.presentQueue(), &presentInfo);
+    }
     
     m_iCurrentFrame = (m_iCurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
     
@@ -214,6 +253,48 @@ void MySwapChain::_createSwapChain()
     m_vkSwapChainExtent = extent;
 }
 
+void MySwapChain::_createOffscreenImages()
+{
+    // Same format the swap chain prefers, so the pipelines and the output match
+    VkFormat format = m_myDevice.findSupportedFormat(
+        {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+    
+    m_vVkSwapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+    m_vVkSwapChainImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+    
+    for (size_t i = 0; i < m_vVkSwapChainImages.size(); i++)
+    {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = m_vkWindowExtent.width;
+        imageInfo.extent.height = m_vkWindowExtent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // can be read back
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.flags = 0;
+        
+        m_myDevice.createImageWithInfo(
+            imageInfo,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            m_vVkSwapChainImages[i],
+            m_vVkSwapChainImageMemorys[i]);
+    }
+    
+    std::cout << "Present mode: Headless" << std::endl;
+    
+    m_vkSwapChainImageFormat = format;
+    m_vkSwapChainExtent = m_vkWindowExtent;
+}
+
 void MySwapChain::_createImageViews() 
 {
     m_vVkSwapChainImageViews.resize(m_vVkSwapChainImages.size());
@@ -261,7 +342,7 @@ void MySwapChain::_createRenderPass()
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = m_myDevice.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
     
     VkAttachmentReference colorAttachmentRef = {};
     colorAttachmentRef.attachment = 0;
@@ -337,7 +418,7 @@ void MySwapChain::_createDepthResources()
     m_vVkDepthImageMemorys.resize(imageCount());
     m_vVkDepthImageViews.resize(imageCount());
 
-    for (int i = 0; i < m_vVkDepthImages.size(); i++)
+    for (size_t i = 0; i < m_vVkDepthImages.size(); i++)
     {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
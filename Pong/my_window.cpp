@@ -3,21 +3,37 @@
 #include <stdexcept>
 #include <iostream>
 
-MyWindow::MyWindow(int w, int h, std::string name) : 
+MyWindow::MyWindow(int w, int h, std::string name, bool bHeadless) : 
 	m_iWidth(w),
 	m_iHeight(h),
+	m_bframeBufferResize(false),
+	m_bHeadless(bHeadless),
 	m_sWindowName(name),
 	m_pWindow(nullptr),
-	m_bframeBufferResize(false),
 	m_pMyApplication(nullptr)
 {
-	_initWindow();
+	// No display is needed to render offscreen
+	if (!m_bHeadless)
+	{
+		_initWindow();
+	}
 }
 
 MyWindow::~MyWindow()
 {
-	glfwDestroyWindow(m_pWindow);
-	glfwTerminate();
+	if (!m_bHeadless)
+	{
+		glfwDestroyWindow(m_pWindow);
+		glfwTerminate();
+	}
+}
+
+void MyWindow::requestClose()
+{
+	if (m_bHeadless)
+		m_bCloseRequested = true;
+	else
+		glfwSetWindowShouldClose(m_pWindow, 1);
 }
 
 void MyWindow::_initWindow()
@@ -47,6 +63,11 @@ void MyWindow::_initWindow()
 
 void MyWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
 {
+	if (m_bHeadless)
+	{
+		throw std::runtime_error("Headless window has no surface");
+	}
+
 	if (glfwCreateWindowSurface(instance, m_pWindow, nullptr, surface) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create window");
@@ -75,6 +96,8 @@ void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int
 
 void MyWindow::pollEvents()
 {
+	if (m_bHeadless) return;
+
 	glfwPollEvents();
 
     // Get the keys here rather than in s_keyboardCallback for faster response
@@ -9,10 +9,14 @@
 
 class MyApplication;
 
+//
+// A headless window has no GLFW window and no surface. It only keeps the extent
+// to render offscreen at, and is closed by the application calling requestClose()
+//
 class MyWindow
 {
 public:
-	MyWindow(int w, int h, std::string name);
+	MyWindow(int w, int h, std::string name, bool bHeadless = false);
 	~MyWindow();
 
 	// Cannot do copy constructor or assignment
@@ -20,7 +24,9 @@ public:
 	MyWindow(const MyWindow&) = delete;
 	MyWindow& operator=(const MyWindow&) = delete;
 
-	bool       shouldClose()            { return glfwWindowShouldClose(m_pWindow); }
+	bool       shouldClose()            { return m_bHeadless ? m_bCloseRequested : glfwWindowShouldClose(m_pWindow); }
+	bool       isHeadless()       const { return m_bHeadless; }
+	void       requestClose();
 	VkExtent2D extent()                 { return { static_cast<uint32_t>(m_iWidth), static_cast<uint32_t>(m_iHeight) }; };
 	bool       wasWindowResized()       { return m_bframeBufferResize; }
 	void       resetWindowResizedFlag() { m_bframeBufferResize = false; }
@@ -41,6 +47,9 @@ private:
 	int            m_iHeight;
 	bool           m_bframeBufferResize = false;
 
+	bool           m_bHeadless;
+	bool           m_bCloseRequested = false;
+
 	std::string    m_sWindowName;
 	GLFWwindow*    m_pWindow;
 
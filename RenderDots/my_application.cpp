@@ -1,6 +1,8 @@
 #include "my_application.h"
 #include <stdexcept>
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <iostream>
 
 
@@ -9,7 +11,9 @@ struct ColorPushConstant
     glm::vec3 color;
 };
 
-MyApplication::MyApplication()
+MyApplication::MyApplication(uint32_t headlessFrames) :
+    m_iHeadlessFrames(headlessFrames),
+    m_myWindow{ WIDTH, HEIGHT, "Assignment 1", headlessFrames > 0 }
 {
     _createModel();
     _createPipelineLayout();
@@ -27,11 +31,43 @@ void MyApplication::run()
 {
     m_myWindow.bindMyApplication(this);
 
+    auto startTime = std::chrono::high_resolution_clock::now();
+    uint32_t frameCount = 0;
+
     while (!m_myWindow.shouldClose()) 
     {
-        m_myWindow.pollEvents();
+        // The dazzling mode picks new colors every frame, and headless runs draw every frame
+        bool bAnimating = m_myWindow.isHeadless() || m_colorIndex == m_Color.size();
+        if (bAnimating || m_myWindow.isDirty())
+        {
+            m_myWindow.pollEvents();
+        }
+        else
+        {
+            // Nothing changed since the last frame, sleep until an event arrives
+            m_myWindow.waitEventsTimeout(IDLE_TIMEOUT);
+            if (!m_myWindow.isDirty())
+            {
+                continue;
+            }
+        }
+
         _updateModel();
         _drawFrame();
+        m_myWindow.clearDirty();
+
+        if (m_myWindow.isHeadless() && ++frameCount >= m_iHeadlessFrames)
+        {
+            m_myWindow.requestClose();
+        }
+    }
+
+    if (m_myWindow.isHeadless())
+    {
+        float totalTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+        std::cout << "Headless: " << frameCount << " frames in " << totalTime << " ms ("
+                  << totalTime / std::max(frameCount, 1u) << " ms per frame)" << std::endl;
     }
 
     // GPU will block until all CPU is complete
@@ -196,6 +232,8 @@ void MyApplication::_drawFrame()
 
 void MyApplication::_updateModel()
 {
+    m_pMyModel->ReleaseRetiredBuffers();
+
     // Only send vector of vertices to GPU if there is a new point
     if (m_changeInVertices)
     {
@@ -206,13 +244,6 @@ void MyApplication::_updateModel()
 
 void MyApplication::AddPoint(float x, float y)
 {
-    if (m_vVertices.size() >= m_pMyModel->getNumMaxVertices())
-    {
-        std::cout << "Maximum number of points has reached ! To continue rendering new points, hit spacebar to clear all the points." << std::endl; 
-        std::cout << "-------------------------------------------------" << std::endl; 
-        return; 
-    }
-
     float vk_x = (x / (WIDTH / 2)) - 1.0f; 
     float vk_y = (y / (HEIGHT / 2)) - 1.0f; 
     std::cout << "Point " << m_vVertices.size() + 1 << " created with following coordinates: \n"
@@ -17,7 +17,13 @@ public:
 	static constexpr int WIDTH = 800;
 	static constexpr int HEIGHT = 600;
 
-	MyApplication();
+	// Frames are only drawn when something changed. Without events the loop
+	// still wakes up after this many seconds
+	static constexpr double IDLE_TIMEOUT = 0.5;
+
+	// With headlessFrames > 0 nothing is shown, the given number of frames
+	// are rendered offscreen and run() returns
+	MyApplication(uint32_t headlessFrames = 0);
 	~MyApplication();
 
 	MyApplication(const MyApplication&) = delete;
@@ -38,6 +44,7 @@ private:
 	void _drawFrame();
     void _recordCommandBuffer(int imageIndex);
 
+	uint32_t                     m_iHeadlessFrames;
 	MyWindow                     m_myWindow{ WIDTH, HEIGHT, "Assignment 1" };
 	MyDevice                     m_myDevice{ m_myWindow };
 	MySwapChain                  m_mySwapChain{ m_myDevice, m_myWindow.extent() };
@@ -58,7 +58,7 @@ MyDevice::MyDevice(MyWindow &window) :
 {
     _createInstance();      // Create a Vulkan instance and connect our application window with Vulkan instance (in step 3)
     _setupDebugMessenger(); // Set up validation layer to check for error during debug, and uncheck for release build
-    _createSurface();       // Create a surface for GLFW to connect with Window
+    _createSurface();       // Create a surface for GLFW to connect with Window (none when headless)
     _pickPhysicalDevice();  // Pick the graphics hardware device (GPU) that is capable of using VulKan API
     _createLogicalDevice(); // Describe what featues we would like to use for the physical device we just pick
     _createCommandPool();   // Ceate command buffer to send command to the device
@@ -74,7 +74,11 @@ MyDevice::~MyDevice()
         DestroyDebugUtilsMessengerEXT(m_vkInstance, m_vkDebugMessenger, nullptr);
     }
     
-    vkDestroySurfaceKHR(m_vkInstance, m_vkSurface, nullptr);
+    // VK_KHR_surface is not enabled when headless
+    if (m_vkSurface != VK_NULL_HANDLE)
+    {
+        vkDestroySurfaceKHR(m_vkInstance, m_vkSurface, nullptr);
+    }
     vkDestroyInstance(m_vkInstance, nullptr);
 }
 
@@ -199,8 +203,9 @@ void MyDevice::_createLogicalDevice()
     
     createInfo.pEnabledFeatures = &deviceFeatures;
     
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    std::vector<const char *> enabledExtensions = _requiredDeviceExtensions();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
     
     // might not really be necessary anymore because device specific validation layers
     // have been deprecated
@@ -243,6 +248,12 @@ void MyDevice::_createCommandPool()
 
 void MyDevice::_createSurface() 
 { 
+    if (isHeadless())
+    {
+        m_vkSurface = VK_NULL_HANDLE;
+        return;
+    }
+    
     m_myWindow.createWindowSurface(m_vkInstance, &m_vkSurface);
 }
 
@@ -252,8 +263,10 @@ bool MyDevice::_isDeviceSuitable(VkPhysicalDevice device)
     
     bool extensionsSupported = _checkDeviceExtensionSupport(device);
     
-    bool swapChainAdequate = false;
-    if (extensionsSupported) 
+    // Nothing is presented when headless, so a device without a present queue
+    // or swap chain support (e.g. lavapipe) is fine
+    bool swapChainAdequate = isHeadless();
+    if (extensionsSupported && !isHeadless()) 
     {
         SwapChainSupportDetails swapChainSupport = _querySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -325,8 +338,13 @@ bool MyDevice::_checkValidationLayerSupport()
 std::vector<const char *> MyDevice::_getRequiredExtensions()
 {
     uint32_t extensionCount = 0;
-    const char ** requiredExtensions;
-    requiredExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+    const char ** requiredExtensions = nullptr;
+    
+    // Without a surface no window system extension is needed
+    if (!isHeadless())
+    {
+        requiredExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+    }
 
     std::vector<const char *> extensions(requiredExtensions, requiredExtensions + extensionCount);
 
@@ -382,7 +400,8 @@ bool MyDevice::_checkDeviceExtensionSupport(VkPhysicalDevice device)
         &extensionCount,
         availableExtensions.data());
     
-    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+    std::vector<const char *> deviceRequiredExtensions = _requiredDeviceExtensions();
+    std::set<std::string> requiredExtensions(deviceRequiredExtensions.begin(), deviceRequiredExtensions.end());
     
     for (const auto &extension : availableExtensions)
     {
@@ -392,6 +411,16 @@ bool MyDevice::_checkDeviceExtensionSupport(VkPhysicalDevice device)
     return requiredExtensions.empty();
 }
 
+std::vector<const char *> MyDevice::_requiredDeviceExtensions()
+{
+    if (isHeadless())
+    {
+        return {};
+    }
+    
+    return deviceExtensions;
+}
+
 QueueFamilyIndices MyDevice::_findQueueFamilies(VkPhysicalDevice device) 
 {
     QueueFamilyIndices indices;
@@ -402,7 +431,7 @@ QueueFamilyIndices MyDevice::_findQueueFamilies(VkPhysicalDevice device)
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
     
-    int i = 0;
+    uint32_t i = 0;
     for (const auto &queueFamily : queueFamilies) 
     {
         if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
@@ -411,8 +440,13 @@ QueueFamilyIndices MyDevice::_findQueueFamilies(VkPhysicalDevice device)
             indices.graphicsFamilyHasValue = true;
         }
 
+        // The graphics queue stands in for the present queue when headless
         VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_vkSurface, &presentSupport);
+        if (isHeadless())
+            presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == i;
+        else
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_vkSurface, &presentSupport);
+        
         if (queueFamily.queueCount > 0 && presentSupport)
         {
             indices.presentFamily = i;
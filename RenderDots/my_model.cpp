@@ -1,25 +1,38 @@
 #include "my_model.h"
+#include "my_swap_chain.h"
+
+// std
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 MyModel::MyModel(MyDevice& device) :
 	m_myDevice{ device },
 	m_iVertexCount{ 0 }
 {
-	_createVertexBuffer();
+	_createVertexBuffer(100);
 }
 
 MyModel::~MyModel()
 {
+    // The application waits for the device to be idle before destroying the model
+    for (auto& retired : m_vRetiredBuffers)
+    {
+        vkDestroyBuffer(m_myDevice.device(), retired.buffer, nullptr);
+        vkFreeMemory(m_myDevice.device(), retired.memory, nullptr);
+    }
+
     vkDestroyBuffer(m_myDevice.device(), m_vkVertexBuffer, nullptr);
     vkFreeMemory(m_myDevice.device(), m_vkVertexBufferMemory, nullptr);
 }
 
-void MyModel::_createVertexBuffer()
+void MyModel::_createVertexBuffer(uint32_t capacity)
 {  
     // // number of bytes need to store the vertex buffer
     // // Note: we assume Color and Position are interleaved here
     // // inside the vertex buffer
-    m_myBufferSize = sizeof(glm::vec2) * 100;
+    m_iCapacity = capacity;
+    m_myBufferSize = sizeof(Vertex) * m_iCapacity;
     
     // // Create buffer handle and allocate buffer memory on GPU side
     // // Note: Host - CPU
@@ -66,19 +79,48 @@ std::vector<VkVertexInputAttributeDescription> MyModel::getAttributeDescriptions
 	return attributeDescriptions;
 }
 
-uint32_t MyModel::getNumMaxVertices()
-{
-    return 100; // Maximum of 100 points to be rendered
-}
-
 void MyModel::UpdateVertices(const std::vector<Vertex> &vertices)
 {
     m_iVertexCount = static_cast<uint32_t>(vertices.size());
+    if (m_iVertexCount == 0)
+        return;
+
+    if (m_iVertexCount > m_iCapacity)
+    {
+        // Frames in flight may still read the old buffer, it is destroyed by
+        // ReleaseRetiredBuffers once they are done
+        m_vRetiredBuffers.push_back({ m_vkVertexBuffer, m_vkVertexBufferMemory, MySwapChain::MAX_FRAMES_IN_FLIGHT });
+
+        // Doubling keeps the cost of adding points amortized O(1) per point
+        _createVertexBuffer(std::max(m_iVertexCount, m_iCapacity * 2));
+    }
+
+    // Only copy the points that exist, not the whole buffer
+    VkDeviceSize size = sizeof(Vertex) * m_iVertexCount;
     void* data;
-    vkMapMemory(m_myDevice.device(), m_vkVertexBufferMemory, 0, m_myBufferSize, 0, &data);
-    memcpy(data, vertices.data(), static_cast<size_t>(m_myBufferSize));
+    vkMapMemory(m_myDevice.device(), m_vkVertexBufferMemory, 0, size, 0, &data);
+    memcpy(data, vertices.data(), static_cast<size_t>(size));
     vkUnmapMemory(m_myDevice.device(), m_vkVertexBufferMemory);
 }
 
+void MyModel::ReleaseRetiredBuffers()
+{
+    // Called before the frame is acquired, a buffer retired MAX_FRAMES_IN_FLIGHT
+    // frames ago was last used by a frame whose fence has been waited for since
+    for (auto& retired : m_vRetiredBuffers)
+    {
+        if (--retired.framesLeft == 0)
+        {
+            vkDestroyBuffer(m_myDevice.device(), retired.buffer, nullptr);
+            vkFreeMemory(m_myDevice.device(), retired.memory, nullptr);
+        }
+    }
+
+    m_vRetiredBuffers.erase(
+        std::remove_if(m_vRetiredBuffers.begin(), m_vRetiredBuffers.end(),
+            [](const RetiredBuffer& retired) { return retired.framesLeft == 0; }),
+        m_vRetiredBuffers.end());
+}
+
 
 
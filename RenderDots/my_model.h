@@ -33,18 +33,32 @@ public:
 	void bind(VkCommandBuffer commandBuffer);
 	void draw(VkCommandBuffer commandBuffer);
 
-	uint32_t getNumMaxVertices(); 
+	// The vertex buffer doubles its capacity when the vertices do not fit
 	void UpdateVertices(const std::vector<Vertex> &vertices); 
 
+	// Call once per frame before drawing, destroys the buffers replaced by a grow
+	// once no frame in flight can read them anymore
+	void ReleaseRetiredBuffers();
+
 private:
 
-	void _createVertexBuffer();
+	struct RetiredBuffer
+	{
+		VkBuffer       buffer;
+		VkDeviceMemory memory;
+		int            framesLeft;  // frames to draw before the buffer is destroyed
+	};
+
+	void _createVertexBuffer(uint32_t capacity);
 
 	MyDevice&      m_myDevice;
 	VkBuffer       m_vkVertexBuffer;       // handle of the buffer on GPU side
 	VkDeviceMemory m_vkVertexBufferMemory; // memory on GPU side of the buffer
 	uint32_t       m_iVertexCount;
+	uint32_t       m_iCapacity;            // number of vertices the buffer can hold
 	VkDeviceSize   m_myBufferSize; 
+
+	std::vector<RetiredBuffer> m_vRetiredBuffers;
 };
 
 #endif
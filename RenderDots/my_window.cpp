@@ -3,25 +3,43 @@
 #include <stdexcept>
 #include <iostream>
 
-MyWindow::MyWindow(int w, int h, std::string name) : 
+MyWindow::MyWindow(int w, int h, std::string name, bool bHeadless) : 
 	m_iWidth(w),
 	m_iHeight(h),
+	m_bHeadless(bHeadless),
 	m_sWindowName(name),
 	m_pWindow(nullptr),
 	m_pMyApplication(nullptr)
 {
-	_initWindow();
+	// No display is needed to render offscreen
+	if (!m_bHeadless)
+	{
+		_initWindow();
+	}
 }
 
 MyWindow::~MyWindow()
 {
-	glfwDestroyWindow(m_pWindow);
-	glfwTerminate();
+	if (!m_bHeadless)
+	{
+		glfwDestroyWindow(m_pWindow);
+		glfwTerminate();
+	}
+}
+
+void MyWindow::requestClose()
+{
+	if (m_bHeadless)
+		m_bCloseRequested = true;
+	else
+		glfwSetWindowShouldClose(m_pWindow, 1);
 }
 
 void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
 	auto mywindow = reinterpret_cast<MyWindow*>(glfwGetWindowUserPointer(window));
+	mywindow->invalidate();
+
 	if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
 	{
 		mywindow->ResetView(); 
@@ -40,6 +58,7 @@ void MyWindow::s_mouseButtonCallback(GLFWwindow* window, int button, int action,
 		double xpos = 0.0, ypos = 0.0;
 		glfwGetCursorPos(window, &xpos, &ypos);
 
+		mywindow->invalidate();
 		mywindow->setLButtonPress((float)xpos, (float)ypos);
 	}
 }
@@ -67,10 +86,18 @@ void MyWindow::_initWindow()
 
     // Register mouse button callback
 	glfwSetMouseButtonCallback(m_pWindow, s_mouseButtonCallback);
+
+	// Redraw when the content of the window is damaged, e.g. uncovered by another window
+	glfwSetWindowRefreshCallback(m_pWindow, s_windowRefreshCallback);
 }
 
 void MyWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
 {
+	if (m_bHeadless)
+	{
+		throw std::runtime_error("Headless window has no surface");
+	}
+
 	if (glfwCreateWindowSurface(instance, m_pWindow, nullptr, surface) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create window");
@@ -79,9 +106,24 @@ void MyWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
 
 void MyWindow::pollEvents()
 {
+	if (m_bHeadless) return;
+
 	glfwPollEvents();
 }
 
+void MyWindow::waitEventsTimeout(double seconds)
+{
+	if (m_bHeadless) return;
+
+	glfwWaitEventsTimeout(seconds);
+}
+
+void MyWindow::s_windowRefreshCallback(GLFWwindow* window)
+{
+	auto mywindow = reinterpret_cast<MyWindow*>(glfwGetWindowUserPointer(window));
+	mywindow->invalidate();
+}
+
 void MyWindow::bindMyApplication(MyApplication* pMyApplication)
 {
 	m_pMyApplication = pMyApplication;
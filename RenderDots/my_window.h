@@ -9,10 +9,14 @@
 
 class MyApplication;
 
+//
+// A headless window has no GLFW window and no surface. It only keeps the extent
+// to render offscreen at, and is closed by the application calling requestClose()
+//
 class MyWindow
 {
 public:
-	MyWindow(int w, int h, std::string name);
+	MyWindow(int w, int h, std::string name, bool bHeadless = false);
 	~MyWindow();
 
 	// Cannot do copy contrucror or assignment
@@ -20,10 +24,19 @@ public:
 	MyWindow(const MyWindow&) = delete;
 	MyWindow& operator=(const MyWindow&) = delete;
 
-	bool       shouldClose()      { return glfwWindowShouldClose(m_pWindow); }
+	bool       shouldClose()      { return m_bHeadless ? m_bCloseRequested : glfwWindowShouldClose(m_pWindow); }
+	bool       isHeadless() const { return m_bHeadless; }
+	void       requestClose();
 	VkExtent2D extent()           { return { static_cast<uint32_t>(m_iWidth), static_cast<uint32_t>(m_iHeight) }; };
 	void       createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
 	void       pollEvents();
+
+	// Idle rendering. Input marks the window dirty, the application marks it dirty when
+	// anything else changes what is drawn and clears it once a frame has been drawn
+	void       waitEventsTimeout(double seconds);
+	void       invalidate()       { m_bDirty = true; }
+	bool       isDirty()    const { return m_bDirty; }
+	void       clearDirty()       { m_bDirty = false; }
 	void 	   ResetView(); 
 	void       ChangeColor(); 
 
@@ -33,6 +46,7 @@ public:
 
 private:
 	static void s_keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void s_windowRefreshCallback(GLFWwindow* window);
 	static void s_mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 
 	void _initWindow();
@@ -40,6 +54,10 @@ private:
 	const int      m_iWidth;
 	const int      m_iHeight;
 
+	bool           m_bHeadless;
+	bool           m_bCloseRequested = false;
+	bool           m_bDirty = true;     // the first frame is always drawn
+
 	std::string    m_sWindowName;
 	GLFWwindow*    m_pWindow;
 
@@ -1,18 +1,54 @@
 
 #include "my_application.h"
+#include "my_scene_graph_benchmark.h"
 
 // std
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 
-int main()
+// A decimal number from 1 to UINT32_MAX, std::stoul alone would take "-1", "12abc" or "0"
+static uint32_t parseCount(const std::string& option, const std::string& text)
 {
-    MyApplication app{};
+    bool bDigits = !text.empty() && text.size() <= 10 && text.find_first_not_of("0123456789") == std::string::npos;
+    unsigned long long value = bDigits ? std::stoull(text) : 0;
+    if (value == 0 || value > UINT32_MAX)
+    {
+        throw std::runtime_error(option + " needs a count from 1 to " + std::to_string(UINT32_MAX) + ", got '" + text + "'!");
+    }
+    return static_cast<uint32_t>(value);
+}
 
+// Usage: app [--headless <frames>] [--benchmark]
+int main(int argc, char* argv[])
+{
     try 
     {
+        uint32_t headlessFrames = 0;
+        bool bBenchmark = false;
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::string(argv[i]) == "--headless")
+            {
+                headlessFrames = (i + 1 < argc) ? parseCount("--headless", argv[++i]) : 1000;
+            }
+            else if (std::string(argv[i]) == "--benchmark")
+            {
+                bBenchmark = true;
+            }
+        }
+
+        // Runs on the CPU only, no window or device is created
+        if (bBenchmark)
+        {
+            MySceneGraphBenchmark::run({ 1000, 10000, 100000, 1000000 }, std::cout);
+            return EXIT_SUCCESS;
+        }
+
+        MyApplication app{ headlessFrames };
         app.run();
     }
     catch (const std::exception& e) 
@@ -23,4 +59,3 @@ int main()
 
     return EXIT_SUCCESS;
 }
-
@@ -0,0 +1,58 @@
+#ifndef __MY_AABB_H__
+#define __MY_AABB_H__
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <limits>
+
+//
+// Axis aligned bounding box. The default one is empty, it contains nothing
+// and leaves any box it is merged into unchanged
+//
+struct MyAabb
+{
+	glm::vec3 min{ std::numeric_limits<float>::max() };
+	glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+	bool      empty()  const { return min.x > max.x; }
+	glm::vec3 center() const { return (min + max) * 0.5f; }
+	glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+	void expand(const glm::vec3& point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void expand(const MyAabb& other)
+	{
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+
+	// The box around the transformed box, from its transformed center and the
+	// extent projected onto the axes (Arvo), without transforming all 8 corners
+	MyAabb transformed(const glm::mat4& matrix) const
+	{
+		if (empty())
+		{
+			return *this;
+		}
+
+		glm::vec3 newCenter{ matrix * glm::vec4{ center(), 1.0f } };
+		glm::vec3 oldExtent = extent();
+		glm::vec3 newExtent{ 0.0f };
+		for (int column = 0; column < 3; column++)
+		{
+			newExtent += glm::abs(glm::vec3{ matrix[column] }) * oldExtent[column];
+		}
+
+		return MyAabb{ newCenter - newExtent, newCenter + newExtent };
+	}
+};
+
+#endif
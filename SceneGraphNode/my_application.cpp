@@ -12,12 +12,15 @@
 #include <glm/gtc/constants.hpp>
 
 // Std
+#include <algorithm>
 #include <stdexcept>
 #include <array>
 #include <chrono>
 #include <iostream>
 
-MyApplication::MyApplication() :
+MyApplication::MyApplication(uint32_t headlessFrames) :
+    m_iHeadlessFrames(headlessFrames),
+    m_myWindow{ WIDTH, HEIGHT, "Scene Graph Node", headlessFrames > 0 },
     m_bMoveCamera(true),
     m_bPerspectiveProjection(true)
 {
@@ -45,26 +48,58 @@ void MyApplication::run()
 
     auto currentTime = std::chrono::high_resolution_clock::now();
 
+    auto startTime = std::chrono::high_resolution_clock::now();
+    uint32_t frameCount = 0;
+
+    // The camera or the current node moved in the last frame, and keeps
+    // moving without new events for as long as the key is held
+    bool bAnimating = false;
+
     while (!m_myWindow.shouldClose()) 
     {
         // Note: depending on the platforms (PC, Linux or Mac), this function
         // will cause the event proecssing to block during a Window move, resize or
         // menu operation. Users can use the "window refresh callback" to redraw the
         // contents of the window when necessary during such operation.
-        m_myWindow.pollEvents();
+        // Headless runs draw every frame
+        if (m_myWindow.isHeadless() || bAnimating || m_myWindow.isDirty())
+        {
+            m_myWindow.pollEvents();
+        }
+        else
+        {
+            // Nothing changed since the last frame, sleep until an event arrives
+            m_myWindow.waitEventsTimeout(IDLE_TIMEOUT);
+
+            // The time spent waiting does not move the camera
+            currentTime = std::chrono::high_resolution_clock::now();
+        }
 
         // Need to get the call after glfwPollEvants because the call above may take time
         auto newTime = std::chrono::high_resolution_clock::now();
         float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
         currentTime = newTime;
 
-        if (m_bMoveCamera)
+        bAnimating = m_bNodeMoving;
+
+        // There is no keyboard to read when headless
+        if (m_bMoveCamera && !m_myWindow.isHeadless())
         {
             // Move camera
-            cameraController.moveInPlaneXZ(m_myWindow.glfwWindow(), frameTime, viewerObject);
+            if (cameraController.moveInPlaneXZ(m_myWindow.glfwWindow(), frameTime, viewerObject))
+            {
+                bAnimating = true;
+                m_myWindow.invalidate();
+            }
             camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
         }
 
+        // The last frame is still up to date
+        if (!m_myWindow.isHeadless() && !m_myWindow.isDirty())
+        {
+            continue;
+        }
+
         float apsectRatio = m_myRenderer.aspectRatio();
 
         // Put it here because the viewport may change
@@ -81,6 +116,9 @@ void MyApplication::run()
         // if the swapChain needs to be recreated
         if (auto commandBuffer = m_myRenderer.beginFrame())
 		{
+            // Everything that changed so far is in this frame
+            m_myWindow.clearDirty();
+
             // In case we have multiple render passes for the current frame
             // begin offsreen shadow pass
             // render shadow casting objects
@@ -88,14 +126,31 @@ void MyApplication::run()
 
             m_myRenderer.beginSwapChainRenderPass(commandBuffer);
             
-            simpleRenderSystem.renderSceneGraph(commandBuffer, m_pMySeceneGraphRoot, camera);
+            // Only the nodes that moved get new world matrices, the culling
+            // runs every frame because the camera may have moved
+            MyFrustum frustum = MyFrustum::fromMatrix(camera.projectionMatrix() * camera.viewMatrix());
+            m_myFlatSceneGraph.updateAndCull(m_myJobScheduler, frustum, m_vDrawLists);
+            simpleRenderSystem.renderSceneGraph(commandBuffer, m_myFlatSceneGraph, m_vDrawLists, camera);
 
             m_myRenderer.endSwapChainRenderPass(commandBuffer);
 
             m_myRenderer.endFrame();
+
+            if (m_myWindow.isHeadless() && ++frameCount >= m_iHeadlessFrames)
+            {
+                m_myWindow.requestClose();
+            }
         }
     }
 
+    if (m_myWindow.isHeadless())
+    {
+        float totalTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+        std::cout << "Headless: " << frameCount << " frames in " << totalTime << " ms ("
+                  << totalTime / std::max(frameCount, 1u) << " ms per frame)" << std::endl;
+    }
+
     // GPU will block until all CPU is complete
     vkDeviceWaitIdle(m_myDevice.device());
 }
@@ -340,13 +395,11 @@ void MyApplication::_loadGameObjects()
 
     auto cube_model = std::make_shared<MyModel>(m_myDevice, vertices); // all cubes will use this model
 
-    m_pMySeceneGraphRoot = std::make_unique<MySceneGraphNode>("Root", 0); 
+    m_pMySeceneGraphRoot = std::make_unique<MySceneGraphNode>("Root"); 
     m_pCurrentSceneGraphNode = m_pMySeceneGraphRoot.get(); 
-    m_pMySeceneGraphRoot->m_bIsCurrent = true; 
-    m_pMySeceneGraphRoot->m_bVisited = true; 
 
-    std::shared_ptr<MySceneGraphNode> group1 = std::make_shared<MySceneGraphNode>("Group1", 1);
-    std::shared_ptr<MySceneGraphNode> group2 = std::make_shared<MySceneGraphNode>("Group2", 2);
+    std::shared_ptr<MySceneGraphNode> group1 = std::make_shared<MySceneGraphNode>("Group1");
+    std::shared_ptr<MySceneGraphNode> group2 = std::make_shared<MySceneGraphNode>("Group2");
 
     // set transform for group1 and 2
     group1->transform.translation.x = -2.0f; 
@@ -355,8 +408,8 @@ void MyApplication::_loadGameObjects()
     m_pMySeceneGraphRoot->addChild(group1);
     m_pMySeceneGraphRoot->addChild(group2);
 
-    std::shared_ptr<MySceneGraphNode> cube1 = std::make_shared<MySceneGraphNode>("Cube1", 3);
-    std::shared_ptr<MySceneGraphNode> cube2 = std::make_shared<MySceneGraphNode>("Cube2", 4);
+    std::shared_ptr<MySceneGraphNode> cube1 = std::make_shared<MySceneGraphNode>("Cube1");
+    std::shared_ptr<MySceneGraphNode> cube2 = std::make_shared<MySceneGraphNode>("Cube2");
 
     cube1->model = cube_model; 
     cube2->model = cube_model; 
@@ -368,8 +421,8 @@ void MyApplication::_loadGameObjects()
     group1->addChild(cube1);
     group1->addChild(cube2);
 
-    std::shared_ptr<MySceneGraphNode> cube3 = std::make_shared<MySceneGraphNode>("Cube3", 5);
-    std::shared_ptr<MySceneGraphNode> cube4 = std::make_shared<MySceneGraphNode>("Cube4", 6);
+    std::shared_ptr<MySceneGraphNode> cube3 = std::make_shared<MySceneGraphNode>("Cube3");
+    std::shared_ptr<MySceneGraphNode> cube4 = std::make_shared<MySceneGraphNode>("Cube4");
 
     cube3->model = cube_model; 
     cube4->model = cube_model; 
@@ -380,6 +433,9 @@ void MyApplication::_loadGameObjects()
 
     group2->addChild(cube3);
     group2->addChild(cube4);
+
+    // The tree is only used to navigate, the transforms are computed on the flat copy
+    m_myFlatSceneGraph.build(*m_pMySeceneGraphRoot);
 }
 
 void MyApplication::switchInteractionMode()
@@ -394,6 +450,13 @@ void MyApplication::switchInteractionMode()
 
 void MyApplication::handleMovementOfCurrentNode(MyAppKeyMap key)
 {
+    // Called with KEY_NONE when no key is held
+    m_bNodeMoving = !m_bMoveCamera && key != KEY_NONE;
+    if (m_bNodeMoving)
+    {
+        m_myWindow.invalidate();
+    }
+
     if (m_bMoveCamera)
     {
         return; 
@@ -434,6 +497,12 @@ void MyApplication::handleMovementOfCurrentNode(MyAppKeyMap key)
         std::cout << "Rotate in Z-direction"  << std::endl;
         m_pCurrentSceneGraphNode->transform.rotation.z = glm::mod(m_pCurrentSceneGraphNode->transform.rotation.z + 0.01f, glm::two_pi<float>()); 
     }
+
+    if (m_bNodeMoving)
+    {
+        // Only the subtree of the current node gets new world matrices
+        m_myFlatSceneGraph.setLocalTransform(m_pCurrentSceneGraphNode->m_iFlatIndex, m_pCurrentSceneGraphNode->transform);
+    }
 }
 
 void MyApplication::printSceneGraph()
@@ -442,7 +511,7 @@ void MyApplication::printSceneGraph()
     
     if (m_pMySeceneGraphRoot)
     {
-        m_pMySeceneGraphRoot->printSceneGraph();
+        m_pMySeceneGraphRoot->printSceneGraph(m_pCurrentSceneGraphNode);
     }
 }
 
@@ -452,8 +521,33 @@ void MyApplication::traverseNext()
 
     if (m_pMySeceneGraphRoot)
     {    
-        m_pCurrentSceneGraphNode = m_pMySeceneGraphRoot->traverseNext(m_pCurrentSceneGraphNode);
-        m_pMySeceneGraphRoot->printSceneGraph();
+        // Wraps around to the root after the last node
+        m_pCurrentSceneGraphNode = m_pCurrentSceneGraphNode->nextInPreOrder();
+        if (m_pCurrentSceneGraphNode == nullptr)
+        {
+            m_pCurrentSceneGraphNode = m_pMySeceneGraphRoot.get();
+        }
+        m_pMySeceneGraphRoot->printSceneGraph(m_pCurrentSceneGraphNode);
+    }
+}
+
+void MyApplication::traversePrevious()
+{
+    std::cout << "Traverse to the previous node in the scene graph" << std::endl;
+
+    if (m_pMySeceneGraphRoot)
+    {    
+        // Wraps around to the last node before the root
+        m_pCurrentSceneGraphNode = m_pCurrentSceneGraphNode->previousInPreOrder();
+        if (m_pCurrentSceneGraphNode == nullptr)
+        {
+            m_pCurrentSceneGraphNode = m_pMySeceneGraphRoot.get();
+            while (!m_pCurrentSceneGraphNode->m_vMyChildren.empty())
+            {
+                m_pCurrentSceneGraphNode = m_pCurrentSceneGraphNode->m_vMyChildren.back().get();
+            }
+        }
+        m_pMySeceneGraphRoot->printSceneGraph(m_pCurrentSceneGraphNode);
     }
 }
 
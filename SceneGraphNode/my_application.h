@@ -5,6 +5,8 @@
 #include "my_device.h"
 #include "my_renderer.h"
 #include "my_game_object.h"
+#include "my_flat_scene_graph.h"
+#include "my_job_scheduler.h"
 
 #include <memory>
 #include <vector>
@@ -15,6 +17,10 @@ public:
 	static constexpr int WIDTH = 800;
 	static constexpr int HEIGHT = 600;
 
+	// Frames are only drawn when something changed. Without events the loop
+	// still wakes up after this many seconds
+	static constexpr double IDLE_TIMEOUT = 0.5;
+
 	enum MyAppKeyMap
 	{
 		KEY_NONE = 0,
@@ -27,7 +33,9 @@ public:
 		KEY_ROTATE_Z
 	};
 
-	MyApplication();
+	// With headlessFrames > 0 nothing is shown, the given number of frames
+	// are rendered offscreen and run() returns
+	MyApplication(uint32_t headlessFrames = 0);
 	~MyApplication();
 
 	MyApplication(const MyApplication&) = delete;
@@ -41,17 +49,23 @@ public:
 	void handleMovementOfCurrentNode(MyAppKeyMap key);
 	void printSceneGraph();
 	void traverseNext();
+	void traversePrevious();
 
 private:
 	void _loadGameObjects();
 
+	uint32_t                           m_iHeadlessFrames;
 	MyWindow                           m_myWindow{ WIDTH, HEIGHT, "Scene Graph Node" };
 	MyDevice                           m_myDevice{ m_myWindow };
 	MyRenderer                         m_myRenderer{ m_myWindow, m_myDevice };
+	MyJobScheduler                     m_myJobScheduler{ MyJobScheduler::defaultThreadCount() };
 
 	std::shared_ptr<MySceneGraphNode>  m_pMySeceneGraphRoot;               // Scene graph root node pointer
+	MyFlatSceneGraph                   m_myFlatSceneGraph;                 // Flattened copy of the scene graph used for rendering
+	MyFlatSceneGraph::DrawLists        m_vDrawLists;                       // Visible nodes of the last update, one list per worker
 	bool                               m_bPerspectiveProjection;           // Switch between orthographic and perspective camera
 	bool                               m_bMoveCamera;                      // Move camera or move game object(s)
+	bool                               m_bNodeMoving = false;              // A key held moves the current node
 
 	MySceneGraphNode*                  m_pCurrentSceneGraphNode = nullptr; // Pointer to the current node in the scene graph
 };
@@ -45,6 +45,7 @@ class MyDevice
     VkCommandPool commandPool() { return m_vkCommandPool; }
     VkDevice device()           { return m_vkDevice; }
     VkSurfaceKHR surface()      { return m_vkSurface; }
+    bool isHeadless() const     { return m_myWindow.isHeadless(); }
     VkQueue graphicsQueue()     { return m_vkGraphicsQueue; }
     VkQueue presentQueue()      { return m_vkPresentQueue; }
 
@@ -88,6 +89,7 @@ class MyDevice
     void _populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
     void _hasGflwRequiredInstanceExtensions();
     bool _checkDeviceExtensionSupport(VkPhysicalDevice device);
+    std::vector<const char *> _requiredDeviceExtensions();
     SwapChainSupportDetails _querySwapChainSupport(VkPhysicalDevice device);
 	
     VkInstance                 m_vkInstance;
@@ -103,7 +105,7 @@ class MyDevice
     VkQueue                    m_vkPresentQueue;
     
     const std::vector<const char *> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-    const std::vector<const char *> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    const std::vector<const char *> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME }; // not needed when headless
 };
 
 #endif
@@ -0,0 +1,328 @@
+#include "my_flat_scene_graph.h"
+
+// std
+#include <algorithm>
+#include <utility>
+
+void MyFlatSceneGraph::clear()
+{
+	m_vLocalTransforms.clear();
+	m_vParents.clear();
+	m_vSubtreeEnds.clear();
+	m_vLocalMatrices.clear();
+	m_vWorldMatrices.clear();
+	m_vModelBounds.clear();
+	m_vSubtreeBounds.clear();
+	m_vModels.clear();
+	m_vColors.clear();
+	m_vVisible.clear();
+	m_vLocalDirty.clear();
+	m_vDirtyNodes.clear();
+}
+
+void MyFlatSceneGraph::build(MySceneGraphNode& root)
+{
+	clear();
+
+	// An explicit stack instead of recursion, deep trees do not overflow the call stack.
+	// The children are pushed in reverse so they come out in their original order
+	std::vector<std::pair<MySceneGraphNode*, uint32_t>> stack{ { &root, NO_PARENT } };
+	while (!stack.empty())
+	{
+		MySceneGraphNode* pNode = stack.back().first;
+		uint32_t parentIndex = stack.back().second;
+		stack.pop_back();
+
+		MyAabb modelBounds = pNode->model ? pNode->model->boundingBox() : MyAabb{};
+		pNode->m_iFlatIndex = addNode(parentIndex, pNode->transform, pNode->model.get(), pNode->color, modelBounds);
+
+		for (auto child = pNode->m_vMyChildren.rbegin(); child != pNode->m_vMyChildren.rend(); child++)
+		{
+			stack.push_back({ child->get(), pNode->m_iFlatIndex });
+		}
+	}
+}
+
+uint32_t MyFlatSceneGraph::addNode(uint32_t parent, const TransformComponent& transform, MyModel* pModel, const glm::vec3& color, const MyAabb& modelBounds)
+{
+	uint32_t index = size();
+
+	m_vLocalTransforms.push_back(transform);
+	m_vParents.push_back(parent);
+	m_vSubtreeEnds.push_back(index + 1);
+	m_vLocalMatrices.push_back(glm::mat4{ 1.0f });
+	m_vWorldMatrices.push_back(glm::mat4{ 1.0f });
+	m_vModelBounds.push_back(modelBounds);
+	m_vSubtreeBounds.push_back(MyAabb{});
+	m_vModels.push_back(pModel);
+	m_vColors.push_back(color);
+	m_vVisible.push_back(0);
+	m_vLocalDirty.push_back(0);
+
+	// The new node is the last descendant of all its ancestors
+	for (uint32_t ancestor = parent; ancestor != NO_PARENT; ancestor = m_vParents[ancestor])
+	{
+		m_vSubtreeEnds[ancestor] = index + 1;
+	}
+
+	_markDirty(index);
+
+	return index;
+}
+
+void MyFlatSceneGraph::_markDirty(uint32_t index)
+{
+	// A node already dirty is already in the list
+	if (!m_vLocalDirty[index])
+	{
+		m_vLocalDirty[index] = 1;
+		m_vDirtyNodes.push_back(index);
+	}
+}
+
+void MyFlatSceneGraph::setLocalTransform(uint32_t index, const TransformComponent& transform)
+{
+	m_vLocalTransforms[index] = transform;
+	_markDirty(index);
+}
+
+void MyFlatSceneGraph::setModelBounds(uint32_t index, const MyAabb& modelBounds)
+{
+	m_vModelBounds[index] = modelBounds;
+	_markDirty(index);
+}
+
+void MyFlatSceneGraph::invalidateAll()
+{
+	for (uint32_t i = 0; i < size(); i++)
+	{
+		_markDirty(i);
+	}
+}
+
+void MyFlatSceneGraph::_collectDirtySubtrees()
+{
+	// In index order a dirty node inside the subtree of an earlier one is
+	// covered by the pass over that subtree
+	std::sort(m_vDirtyNodes.begin(), m_vDirtyNodes.end());
+
+	uint32_t end = 0;
+	auto last = std::remove_if(m_vDirtyNodes.begin(), m_vDirtyNodes.end(), [this, &end](uint32_t dirtyNode)
+	{
+		if (dirtyNode < end)
+		{
+			return true;
+		}
+		end = m_vSubtreeEnds[dirtyNode];
+		return false;
+	});
+	m_vDirtyNodes.erase(last, m_vDirtyNodes.end());
+}
+
+void MyFlatSceneGraph::_updateSubtree(MyJobScheduler* pScheduler, uint32_t root, uint32_t cutoff)
+{
+	MyJobScheduler::JobGroup children;
+	std::vector<uint32_t> spawnedRoots;
+
+	uint32_t end = m_vSubtreeEnds[root];
+	uint32_t i = root;
+	while (i < end)
+	{
+		// The parent of a large subtree was done by this job before it is
+		// spawned, and nothing else below i depends on the skipped nodes
+		if (pScheduler != nullptr && i != root && m_vSubtreeEnds[i] - i > cutoff)
+		{
+			pScheduler->spawn(children, [this, pScheduler, i, cutoff]()
+			{
+				_updateSubtree(pScheduler, i, cutoff);
+			});
+			spawnedRoots.push_back(i);
+			i = m_vSubtreeEnds[i];
+			continue;
+		}
+
+		if (m_vLocalDirty[i])
+		{
+			m_vLocalMatrices[i] = m_vLocalTransforms[i].mat4();
+			m_vLocalDirty[i] = 0;
+		}
+
+		uint32_t parent = m_vParents[i];
+		m_vWorldMatrices[i] = (parent == NO_PARENT) ? m_vLocalMatrices[i] : m_vWorldMatrices[parent] * m_vLocalMatrices[i];
+		m_vSubtreeBounds[i] = m_vModelBounds[i].transformed(m_vWorldMatrices[i]);
+
+		i++;
+	}
+
+	// The boxes of the spawned subtrees are complete once their jobs are done
+	if (!spawnedRoots.empty())
+	{
+		pScheduler->wait(children);
+	}
+
+	// Bottom up, the descendants of a node come after it. The inside of a spawned subtree
+	// was already folded by its job, only its root is folded here. The spawned subtrees are
+	// in index order, so the last one is the next one j walks into
+	for (uint32_t j = end - 1; j > root; j--)
+	{
+		if (!spawnedRoots.empty() && spawnedRoots.back() <= j && j < m_vSubtreeEnds[spawnedRoots.back()])
+		{
+			j = spawnedRoots.back();
+			spawnedRoots.pop_back();
+		}
+
+		m_vSubtreeBounds[m_vParents[j]].expand(m_vSubtreeBounds[j]);
+	}
+}
+
+void MyFlatSceneGraph::_refitAncestors(uint32_t index)
+{
+	// Only the direct children are merged, their own boxes are up to date
+	for (uint32_t ancestor = m_vParents[index]; ancestor != NO_PARENT; ancestor = m_vParents[ancestor])
+	{
+		MyAabb bounds = m_vModelBounds[ancestor].transformed(m_vWorldMatrices[ancestor]);
+		for (uint32_t child = ancestor + 1; child < m_vSubtreeEnds[ancestor]; child = m_vSubtreeEnds[child])
+		{
+			bounds.expand(m_vSubtreeBounds[child]);
+		}
+		m_vSubtreeBounds[ancestor] = bounds;
+	}
+}
+
+uint32_t MyFlatSceneGraph::updateWorldTransforms()
+{
+	if (m_vDirtyNodes.empty())
+	{
+		return 0;
+	}
+
+	_collectDirtySubtrees();
+
+	uint32_t updated = 0;
+	for (uint32_t dirtyNode : m_vDirtyNodes)
+	{
+		_updateSubtree(nullptr, dirtyNode, 0);
+		_refitAncestors(dirtyNode);
+		updated += m_vSubtreeEnds[dirtyNode] - dirtyNode;
+	}
+	m_vDirtyNodes.clear();
+
+	return updated;
+}
+
+uint32_t MyFlatSceneGraph::updateAndCull(MyJobScheduler& scheduler, const MyFrustum& frustum, DrawLists& drawLists, uint32_t cutoff)
+{
+	// The dirty subtrees do not overlap, so each can be a job of its own.
+	// Their ancestors are refitted once all of them are done
+	if (!m_vDirtyNodes.empty())
+	{
+		_collectDirtySubtrees();
+
+		MyJobScheduler::JobGroup group;
+		for (uint32_t dirtyNode : m_vDirtyNodes)
+		{
+			scheduler.spawn(group, [this, &scheduler, dirtyNode, cutoff]()
+			{
+				_updateSubtree(&scheduler, dirtyNode, cutoff);
+			});
+		}
+		scheduler.wait(group);
+
+		for (uint32_t dirtyNode : m_vDirtyNodes)
+		{
+			_refitAncestors(dirtyNode);
+		}
+		m_vDirtyNodes.clear();
+	}
+
+	drawLists.resize(scheduler.workerCount());
+	for (auto& drawList : drawLists)
+	{
+		drawList.clear();
+	}
+
+	// One job per root, each splits itself further
+	std::atomic<uint32_t> testCount{ 0 };
+	MyJobScheduler::JobGroup group;
+	for (uint32_t root = 0; root < size(); root = m_vSubtreeEnds[root])
+	{
+		scheduler.spawn(group, [this, &scheduler, &group, &frustum, &drawLists, &testCount, root, cutoff]()
+		{
+			_cullSubtree(scheduler, group, frustum, drawLists, testCount, root, false, cutoff);
+		});
+	}
+	scheduler.wait(group);
+
+	return testCount.load();
+}
+
+void MyFlatSceneGraph::_cullSubtree(
+	MyJobScheduler& scheduler,
+	MyJobScheduler::JobGroup& group,
+	const MyFrustum& frustum,
+	DrawLists& drawLists,
+	std::atomic<uint32_t>& testCount,
+	uint32_t root,
+	bool bInside,
+	uint32_t cutoff)
+{
+	// The same worker runs the whole job
+	std::vector<uint32_t>& drawList = drawLists[scheduler.workerIndex()];
+	uint32_t tests = 0;
+
+	// Nodes before insideEnd are below a box that is completely inside the frustum.
+	// The subtrees are nested ranges, so one index is enough
+	uint32_t end = m_vSubtreeEnds[root];
+	uint32_t insideEnd = bInside ? end : root;
+	uint32_t i = root;
+	while (i < end)
+	{
+		bool bKnownInside = i < insideEnd;
+
+		if (i != root && m_vSubtreeEnds[i] - i > cutoff)
+		{
+			scheduler.spawn(group, [this, &scheduler, &group, &frustum, &drawLists, &testCount, i, bKnownInside, cutoff]()
+			{
+				_cullSubtree(scheduler, group, frustum, drawLists, testCount, i, bKnownInside, cutoff);
+			});
+			i = m_vSubtreeEnds[i];
+			continue;
+		}
+
+		if (!bKnownInside)
+		{
+			tests++;
+			MyFrustum::Containment containment = frustum.classify(m_vSubtreeBounds[i]);
+			if (containment == MyFrustum::OUTSIDE)
+			{
+				// One test for the whole subtree
+				std::fill(m_vVisible.begin() + i, m_vVisible.begin() + m_vSubtreeEnds[i], 0);
+				i = m_vSubtreeEnds[i];
+				continue;
+			}
+			if (containment == MyFrustum::INSIDE)
+			{
+				insideEnd = m_vSubtreeEnds[i];
+				bKnownInside = true;
+			}
+		}
+
+		// The box of a leaf is its model, a group with a model needs a test of its own
+		bool bVisible = !m_vModelBounds[i].empty();
+		if (bVisible && !bKnownInside && !isLeaf(i))
+		{
+			tests++;
+			bVisible = frustum.classify(m_vModelBounds[i].transformed(m_vWorldMatrices[i])) != MyFrustum::OUTSIDE;
+		}
+
+		m_vVisible[i] = bVisible;
+		if (bVisible)
+		{
+			drawList.push_back(i);
+		}
+
+		i++;
+	}
+
+	testCount.fetch_add(tests, std::memory_order_relaxed);
+}
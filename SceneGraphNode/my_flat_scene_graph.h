@@ -0,0 +1,111 @@
+#ifndef __MY_FLAT_SCENE_GRAPH_H__
+#define __MY_FLAT_SCENE_GRAPH_H__
+
+#include "my_game_object.h"
+#include "my_aabb.h"
+#include "my_frustum.h"
+#include "my_job_scheduler.h"
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+//
+// The scene graph flattened in depth first (pre-order) order, one array per component.
+// Every parent comes before its children, so the world matrices are computed in a single
+// linear pass without recursion or pointer chasing, and rendering walks the arrays front to back.
+// The subtree of a node is the range [index, subtreeEnd), so a changed transform only marks that
+// range dirty and a scene where nothing moved costs no transform math at all.
+// Every node also has a world space box around its model and all of its descendants, so the
+// culling skips a whole subtree after one test of its root
+//
+class MyFlatSceneGraph
+{
+public:
+	static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+	// Subtrees with more nodes than this become jobs of their own in updateAndCull,
+	// the smaller ones are walked by the job of their parent
+	static constexpr uint32_t DEFAULT_JOB_CUTOFF = 1024;
+
+	// The visible nodes found by each worker of the scheduler
+	using DrawLists = std::vector<std::vector<uint32_t>>;
+
+	// Replaces the content with the tree below root, every node of the tree
+	// remembers its index in m_iFlatIndex
+	void     build(MySceneGraphNode& root);
+	void     clear();
+
+	// Appends a node whose parent is already in the graph, or NO_PARENT for a root. The nodes must
+	// be added in pre-order, the parent is the last added node or one of its ancestors.
+	// The model is not owned and stays nullptr for group nodes. Only nodes with model bounds are
+	// culled and drawn, the bounds of group nodes stay empty
+	uint32_t addNode(uint32_t parent, const TransformComponent& transform, MyModel* pModel, const glm::vec3& color, const MyAabb& modelBounds);
+
+	// world = world of the parent * local, only for the subtrees of the nodes changed since the last update.
+	// The boxes of those subtrees and of their ancestors are refitted. Returns the number of world matrices computed
+	uint32_t updateWorldTransforms();
+
+	// The local matrix of the node and the world matrices of its subtree are recomputed on the next update
+	void     setLocalTransform(uint32_t index, const TransformComponent& transform);
+	void     setModelBounds(uint32_t index, const MyAabb& modelBounds);
+
+	// Everything is recomputed on the next update
+	void     invalidateAll();
+
+	// updateWorldTransforms spread over the workers of the scheduler, followed by the culling of
+	// every subtree against the frustum. The result goes into visible(index), and the visible nodes
+	// into the draw list of the worker that tested them. Returns the number of boxes tested
+	uint32_t updateAndCull(MyJobScheduler& scheduler, const MyFrustum& frustum, DrawLists& drawLists, uint32_t cutoff = DEFAULT_JOB_CUTOFF);
+
+	uint32_t                  size()                         const { return static_cast<uint32_t>(m_vParents.size()); }
+	uint32_t                  parent(uint32_t index)         const { return m_vParents[index]; }
+	uint32_t                  subtreeEnd(uint32_t index)     const { return m_vSubtreeEnds[index]; }
+	const TransformComponent& localTransform(uint32_t index) const { return m_vLocalTransforms[index]; }
+	const glm::mat4&          worldMatrix(uint32_t index)    const { return m_vWorldMatrices[index]; }
+	const MyAabb&             subtreeBounds(uint32_t index)  const { return m_vSubtreeBounds[index]; }
+	const MyAabb&             modelBounds(uint32_t index)    const { return m_vModelBounds[index]; }
+	MyModel*                  model(uint32_t index)          const { return m_vModels[index]; }
+	const glm::vec3&          color(uint32_t index)          const { return m_vColors[index]; }
+	bool                      visible(uint32_t index)        const { return m_vVisible[index] != 0; }
+
+	// In pre-order the first child directly follows its parent
+	bool                      isLeaf(uint32_t index)         const { return m_vSubtreeEnds[index] == index + 1; }
+
+private:
+	void _markDirty(uint32_t index);
+
+	// Leaves only the dirty nodes that are not below another dirty node, in index order
+	void _collectDirtySubtrees();
+
+	// World matrices and boxes of the subtree, with pScheduler the large child subtrees run as jobs
+	void _updateSubtree(MyJobScheduler* pScheduler, uint32_t root, uint32_t cutoff);
+	void _refitAncestors(uint32_t index);
+
+	void _cullSubtree(
+		MyJobScheduler& scheduler,
+		MyJobScheduler::JobGroup& group,
+		const MyFrustum& frustum,
+		DrawLists& drawLists,
+		std::atomic<uint32_t>& testCount,
+		uint32_t root,
+		bool bInside,
+		uint32_t cutoff);
+
+	std::vector<TransformComponent> m_vLocalTransforms;
+	std::vector<uint32_t>           m_vParents;
+	std::vector<uint32_t>           m_vSubtreeEnds;     // one past the last descendant
+	std::vector<glm::mat4>          m_vLocalMatrices;   // cached TransformComponent::mat4
+	std::vector<glm::mat4>          m_vWorldMatrices;
+	std::vector<MyAabb>             m_vModelBounds;     // in model space, empty for group nodes
+	std::vector<MyAabb>             m_vSubtreeBounds;   // in world space, the model and all descendants
+	std::vector<MyModel*>           m_vModels;
+	std::vector<glm::vec3>          m_vColors;
+	std::vector<uint8_t>            m_vVisible;         // written by updateAndCull, one byte per node so workers never share a flag
+
+	std::vector<uint8_t>            m_vLocalDirty;      // the local matrix is out of date
+	std::vector<uint32_t>           m_vDirtyNodes;      // nodes whose subtree needs new world matrices
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef __MY_FRUSTUM_H__
+#define __MY_FRUSTUM_H__
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "my_aabb.h"
+
+// std
+#include <array>
+
+//
+// The six planes of a view volume, facing inwards and normalized so that
+// dot(plane.xyz, p) + plane.w is the signed distance of p to the plane
+//
+struct MyFrustum
+{
+	enum Containment
+	{
+		OUTSIDE = 0,
+		INTERSECTING,
+		INSIDE
+	};
+
+	std::array<glm::vec4, 6> planes;
+
+	// Planes of a projection * view matrix with a depth range of 0 to 1, works
+	// for both the perspective and the orthographic projection
+	static MyFrustum fromMatrix(const glm::mat4& projView)
+	{
+		// Rows of the matrix, GLM is column major
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+		{
+			rows[i] = glm::vec4{ projView[0][i], projView[1][i], projView[2][i], projView[3][i] };
+		}
+
+		MyFrustum frustum{};
+		frustum.planes[0] = rows[3] + rows[0];   // left
+		frustum.planes[1] = rows[3] - rows[0];   // right
+		frustum.planes[2] = rows[3] + rows[1];   // top, Y is down in Vulkan
+		frustum.planes[3] = rows[3] - rows[1];   // bottom
+		frustum.planes[4] = rows[2];             // near
+		frustum.planes[5] = rows[3] - rows[2];   // far
+
+		for (auto& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3{ plane });
+		}
+
+		return frustum;
+	}
+
+	// Per plane, the distance of the center against the extent projected onto the normal.
+	// Conservative, a box just outside a corner may still count as intersecting.
+	// An empty box is always outside
+	Containment classify(const MyAabb& box) const
+	{
+		if (box.empty())
+		{
+			return OUTSIDE;
+		}
+
+		glm::vec3 center = box.center();
+		glm::vec3 extent = box.extent();
+
+		Containment result = INSIDE;
+		for (const auto& plane : planes)
+		{
+			glm::vec3 normal{ plane };
+			float distance = glm::dot(normal, center) + plane.w;
+			float radius = glm::dot(glm::abs(normal), extent);
+
+			if (distance < -radius)
+			{
+				return OUTSIDE;
+			}
+			if (distance < radius)
+			{
+				result = INTERSECTING;
+			}
+		}
+		return result;
+	}
+};
+
+#endif
@@ -3,77 +3,67 @@
 
 void MySceneGraphNode::addChild(std::shared_ptr<MySceneGraphNode>& obj)
 {
+	if (!m_vMyChildren.empty())
+	{
+		m_vMyChildren.back()->m_pMyNextSibling = obj.get();
+		obj->m_pMyPreviousSibling = m_vMyChildren.back().get();
+	}
+
 	m_vMyChildren.push_back(obj); 
 	obj->m_iLevel = m_iLevel + 1; 
 	obj->m_pMyParent = shared_from_this().get(); 
 }
 
-void MySceneGraphNode::printSceneGraph()
+void MySceneGraphNode::printSceneGraph(const MySceneGraphNode* pCurrentNode) const
 {
-	std::string current; 
-	std::string offset; 
-
-	for (int i = 0; i < m_iLevel; i++)
+	// Iterative, a deep tree does not overflow the call stack
+	for (const MySceneGraphNode* pNode = this; pNode != nullptr; pNode = pNode->nextInPreOrder())
 	{
-		offset += "\t";
-	}
+		// Past the subtree of this node
+		if (pNode != this && pNode->m_iLevel <= m_iLevel)
+		{
+			break;
+		}
 
-	if (m_bIsCurrent)
-	{
-		current = "*";
-	}
-	std::cout << offset + current + getName() << std::endl;
+		std::string offset(pNode->m_iLevel, '\t');
+		std::string current = (pNode == pCurrentNode) ? "*" : "";
 
-	for (int i = 0; i < m_vMyChildren.size(); i++)
-	{
-		m_vMyChildren[i]->printSceneGraph(); 
+		std::cout << offset + current + pNode->getName() << std::endl;
 	}
 }
 
-MySceneGraphNode * MySceneGraphNode::traverseNext(MySceneGraphNode* pCurrentNode)
+MySceneGraphNode* MySceneGraphNode::nextInPreOrder() const
 {
-	if (!pCurrentNode->m_bVisited)
+	if (!m_vMyChildren.empty())
 	{
-		pCurrentNode->m_bVisited = true; 
-		pCurrentNode->m_bIsCurrent = true; 
-		return pCurrentNode; 
+		return m_vMyChildren.front().get();
 	}
-	else if (pCurrentNode->m_vMyChildren.size() == 0)
-	{
-		pCurrentNode->m_bIsCurrent = false;
-		return traverseNext(pCurrentNode->m_pMyParent); 
-	}
-	else
+
+	// The next sibling of the closest ancestor that has one
+	for (const MySceneGraphNode* pNode = this; pNode != nullptr; pNode = pNode->m_pMyParent)
 	{
-		for (int i = 0; i < pCurrentNode->m_vMyChildren.size(); i++)
-		{
-			if (!pCurrentNode->m_vMyChildren[i]->m_bVisited)
-			{
-				pCurrentNode->m_bIsCurrent = false; 
-				return traverseNext(pCurrentNode->m_vMyChildren[i].get()); 
-			}
-		}
-		if (pCurrentNode->m_pMyParent == nullptr)
+		if (pNode->m_pMyNextSibling != nullptr)
 		{
-			unvisitAll(pCurrentNode); 
-			pCurrentNode->m_bVisited = true; 
-			pCurrentNode->m_bIsCurrent = true; 
-			return pCurrentNode;
+			return pNode->m_pMyNextSibling;
 		}
-		pCurrentNode->m_bIsCurrent = false;
-		return traverseNext(pCurrentNode->m_pMyParent); 
 	}
 
 	return nullptr;
 }
 
-void MySceneGraphNode::unvisitAll(MySceneGraphNode* pCurrentNode)
+MySceneGraphNode* MySceneGraphNode::previousInPreOrder() const
 {
-	pCurrentNode->m_bVisited = false; 
+	if (m_pMyPreviousSibling == nullptr)
+	{
+		return m_pMyParent;
+	}
 
-	for (int i = 0; i < pCurrentNode->m_vMyChildren.size(); i++)
+	// The last node of the subtree of the previous sibling
+	MySceneGraphNode* pNode = m_pMyPreviousSibling;
+	while (!pNode->m_vMyChildren.empty())
 	{
-		unvisitAll(pCurrentNode->m_vMyChildren[i].get()); 
+		pNode = pNode->m_vMyChildren.back().get();
 	}
-}
 
+	return pNode;
+}
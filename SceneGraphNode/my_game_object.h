@@ -5,6 +5,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <array>
@@ -58,8 +59,14 @@ public:
 
 	static MyGameObject createGameObject(std::string name)
 	{
-		static id_t currentID = 0;
-		return MyGameObject(currentID++, name);
+		return MyGameObject(nextID(), name);
+	}
+
+	// Shared by the game objects and the scene graph nodes, can be called from any thread
+	static id_t nextID()
+	{
+		static std::atomic<id_t> currentID{ 0 };
+		return currentID++;
 	}
 
 	MyGameObject(const MyGameObject&) = delete;
@@ -67,7 +74,7 @@ public:
 	MyGameObject(MyGameObject&&) = default;
 	MyGameObject& operator=(MyGameObject&&) = default;
 
-	std::string              getName() const { return m_sName; };
+	const std::string&       getName() const { return m_sName; };
 	id_t                     getID()   const { return m_iID; }
 	std::shared_ptr<MyModel> model{};
 	glm::vec3                color{};
@@ -85,25 +92,32 @@ public:
 
     static MySceneGraphNode createGameObject(std::string name)
 	{
-		static id_t currentID = 0;
-		return MySceneGraphNode(name, currentID++);
+		return MySceneGraphNode(name);
 	}
 	
-	MySceneGraphNode(std::string name, int id) : MyGameObject(id, name)
+	MySceneGraphNode(std::string name) : MyGameObject(nextID(), name)
 	{
 	}
 
 	void addChild(std::shared_ptr<MySceneGraphNode>& obj);
-	void printSceneGraph();
-	MySceneGraphNode * traverseNext(MySceneGraphNode* pCurrentNode);
-	void unvisitAll(MySceneGraphNode* pCurrentNode); 
+
+	// pCurrentNode is marked with a *
+	void printSceneGraph(const MySceneGraphNode* pCurrentNode) const;
+
+	// Pre-order cursor over the links of the nodes, no state is kept anywhere else, so any number
+	// of traversals can run at once, also from several threads as long as the tree does not change.
+	// A whole traversal follows every link at most twice, so a step is amortized O(1).
+	// Both return nullptr past the end
+	MySceneGraphNode* nextInPreOrder() const;
+	MySceneGraphNode* previousInPreOrder() const;
 
 	std::vector<std::shared_ptr<MySceneGraphNode>> m_vMyChildren;
 	//std::shared_ptr<MySceneGraphNode> m_pMyParent; 
-	MySceneGraphNode* m_pMyParent;
-	bool m_bVisited = false;
-	bool m_bIsCurrent = false;
+	MySceneGraphNode* m_pMyParent = nullptr;
+	MySceneGraphNode* m_pMyNextSibling = nullptr;
+	MySceneGraphNode* m_pMyPreviousSibling = nullptr;
 	int m_iLevel = 0; 
+	uint32_t m_iFlatIndex = UINT32_MAX; // position in MyFlatSceneGraph, set by its build
 };
 
 #endif
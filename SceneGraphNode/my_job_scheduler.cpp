@@ -0,0 +1,168 @@
+#include "my_job_scheduler.h"
+
+namespace
+{
+	// Set for the threads of a scheduler, other threads use the last queue
+	thread_local const MyJobScheduler* tl_pScheduler = nullptr;
+	thread_local uint32_t              tl_iWorkerIndex = 0;
+}
+
+MyJobScheduler::MyJobScheduler(uint32_t threadCount)
+{
+	m_vQueues.reserve(threadCount + 1);
+	for (uint32_t i = 0; i < threadCount + 1; i++)
+	{
+		m_vQueues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	m_vThreads.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		m_vThreads.emplace_back(&MyJobScheduler::_workerLoop, this, i);
+	}
+}
+
+MyJobScheduler::~MyJobScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_sleepMutex };
+		m_bStopping = true;
+	}
+	m_condition.notify_all();
+
+	// Jobs that are already queued still run before the threads exit
+	for (auto& thread : m_vThreads)
+	{
+		thread.join();
+	}
+}
+
+uint32_t MyJobScheduler::defaultThreadCount()
+{
+	// hardware_concurrency returns 0 if it cannot tell
+	uint32_t coreCount = std::thread::hardware_concurrency();
+	return coreCount > 1 ? coreCount - 1 : 0;
+}
+
+uint32_t MyJobScheduler::workerIndex() const
+{
+	return tl_pScheduler == this ? tl_iWorkerIndex : workerCount() - 1;
+}
+
+void MyJobScheduler::spawn(JobGroup& group, Job job)
+{
+	group.m_iPendingJobs.fetch_add(1, std::memory_order_relaxed);
+
+	WorkerQueue& queue = *m_vQueues[workerIndex()];
+	{
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		queue.jobs.push_back(QueuedJob{ std::move(job), &group });
+	}
+	m_iQueuedJobs.fetch_add(1, std::memory_order_release);
+
+	// Taking the lock orders the increment before the predicate check
+	// of a worker about to sleep, so the wake up is not lost
+	{
+		std::lock_guard<std::mutex> lock{ m_sleepMutex };
+	}
+	m_condition.notify_one();
+}
+
+bool MyJobScheduler::_runOneJob(uint32_t index)
+{
+	QueuedJob queuedJob;
+	bool bFound = false;
+
+	// Newest job of the own queue first, then the oldest job of the others
+	{
+		WorkerQueue& queue = *m_vQueues[index];
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		if (!queue.jobs.empty())
+		{
+			queuedJob = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			bFound = true;
+		}
+	}
+
+	for (uint32_t i = 1; !bFound && i < workerCount(); i++)
+	{
+		WorkerQueue& queue = *m_vQueues[(index + i) % workerCount()];
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		if (!queue.jobs.empty())
+		{
+			queuedJob = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			bFound = true;
+		}
+	}
+
+	if (!bFound)
+	{
+		return false;
+	}
+	m_iQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+	try
+	{
+		queuedJob.job();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock{ queuedJob.pGroup->m_mutex };
+		if (!queuedJob.pGroup->m_pException)
+		{
+			queuedJob.pGroup->m_pException = std::current_exception();
+		}
+	}
+
+	// Release so the waiting thread sees everything the job wrote
+	queuedJob.pGroup->m_iPendingJobs.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void MyJobScheduler::_workerLoop(uint32_t index)
+{
+	tl_pScheduler = this;
+	tl_iWorkerIndex = index;
+
+	while (true)
+	{
+		if (_runOneJob(index))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{ m_sleepMutex };
+		m_condition.wait(lock, [this]() { return m_bStopping || m_iQueuedJobs.load(std::memory_order_acquire) > 0; });
+
+		if (m_bStopping && m_iQueuedJobs.load(std::memory_order_acquire) == 0)
+		{
+			return;
+		}
+	}
+}
+
+void MyJobScheduler::wait(JobGroup& group)
+{
+	uint32_t index = workerIndex();
+
+	while (group.m_iPendingJobs.load(std::memory_order_acquire) > 0)
+	{
+		// Nothing left to steal, the last jobs are running on other workers
+		if (!_runOneJob(index))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	std::exception_ptr pException;
+	{
+		std::lock_guard<std::mutex> lock{ group.m_mutex };
+		std::swap(pException, group.m_pException);
+	}
+	if (pException)
+	{
+		std::rethrow_exception(pException);
+	}
+}
@@ -0,0 +1,91 @@
+#ifndef __MY_JOB_SCHEDULER_H__
+#define __MY_JOB_SCHEDULER_H__
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Work-stealing job scheduler. Every worker has its own queue: a job spawned from a job goes
+// to the back of the queue of its worker, which runs it next while it is still in the cache,
+// and an idle worker steals from the front of the other queues, where the oldest and usually
+// largest jobs are. The thread calling wait is a worker too, so 0 threads runs everything in wait.
+// Only one thread outside of the scheduler may spawn and wait
+//
+class MyJobScheduler
+{
+public:
+	using Job = std::function<void()>;
+
+	// Counts the unfinished jobs spawned into it
+	class JobGroup
+	{
+	public:
+		JobGroup() = default;
+
+		JobGroup(const JobGroup&) = delete;
+		JobGroup& operator=(const JobGroup&) = delete;
+
+	private:
+		friend class MyJobScheduler;
+
+		std::atomic<uint32_t> m_iPendingJobs{ 0 };
+		std::mutex            m_mutex;            // guards m_pException
+		std::exception_ptr    m_pException;       // first exception thrown by one of the jobs
+	};
+
+	MyJobScheduler(uint32_t threadCount);
+	~MyJobScheduler();
+
+	MyJobScheduler(const MyJobScheduler&) = delete;
+	MyJobScheduler& operator=(const MyJobScheduler&) = delete;
+
+	void     spawn(JobGroup& group, Job job);
+
+	// Runs jobs until every job of the group has finished, then rethrows
+	// the first exception one of them threw
+	void     wait(JobGroup& group);
+
+	// The threads plus the thread calling wait
+	uint32_t workerCount() const { return static_cast<uint32_t>(m_vQueues.size()); }
+
+	// Index of the calling worker in [0, workerCount), the same for the whole life of a job
+	uint32_t workerIndex() const;
+
+	// One thread per core, leaving one for the main thread
+	static uint32_t defaultThreadCount();
+
+private:
+	struct QueuedJob
+	{
+		Job       job;
+		JobGroup* pGroup;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex            mutex;
+		std::deque<QueuedJob> jobs;
+	};
+
+	void _workerLoop(uint32_t index);
+	bool _runOneJob(uint32_t index);
+
+	std::vector<std::unique_ptr<WorkerQueue>> m_vQueues;         // one per worker, the last one is the thread calling wait
+	std::vector<std::thread>                  m_vThreads;
+	std::atomic<uint32_t>                     m_iQueuedJobs{ 0 };
+
+	std::mutex                                m_sleepMutex;       // idle workers sleep on m_condition
+	std::condition_variable                   m_condition;
+	bool                                      m_bStopping = false;
+};
+
+#endif
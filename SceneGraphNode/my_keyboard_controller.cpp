@@ -4,7 +4,7 @@
 #include <limits>
 #include <iostream>
 
-void MyKeyboardController::moveInPlaneXZ(GLFWwindow* window, float dt, MyGameObject& gameObject)
+bool MyKeyboardController::moveInPlaneXZ(GLFWwindow* window, float dt, MyGameObject& gameObject)
 {
      // Camera rotation
      glm::vec3 rotate{ 0 };
@@ -28,7 +28,8 @@ void MyKeyboardController::moveInPlaneXZ(GLFWwindow* window, float dt, MyGameObj
         rotate.x -= 1.f;
         std::cout << "Looking down" << std::endl;
      }
-     if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon())
+     bool bRotating = glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon();
+     if (bRotating)
      {
          gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
      }
@@ -73,9 +74,12 @@ void MyKeyboardController::moveInPlaneXZ(GLFWwindow* window, float dt, MyGameObj
         moveDir -= upDir;
         std::cout << "Moving camera downwards" << std::endl; 
      }
-     if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon())
+     bool bMoving = glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon();
+     if (bMoving)
      {
          gameObject.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
      }
+
+     return bRotating || bMoving;
 }
 
@@ -21,7 +21,8 @@ public:
         int lookDown = GLFW_KEY_DOWN;
     };
 
-    void moveInPlaneXZ(GLFWwindow* window, float dt, MyGameObject& gameObject);
+    // Returns true if a key held moved or turned the game object
+    bool moveInPlaneXZ(GLFWwindow* window, float dt, MyGameObject& gameObject);
 
     KeyMappings keys{};
     float moveSpeed{ 3.f };
@@ -6,6 +6,11 @@ MyModel::MyModel(MyDevice& device, const std::vector<Vertex>& vertices) :
 	m_iVertexCount{ 0 }
 {
     _createVertexBuffer(vertices);
+
+    for (const auto& vertex : vertices)
+    {
+        m_myBoundingBox.expand(vertex.position);
+    }
 }
 
 MyModel::~MyModel()
@@ -8,6 +8,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "my_aabb.h"
+
 // Std
 #include <vector>
 
@@ -34,6 +36,9 @@ public:
 	void bind(VkCommandBuffer commandBuffer);
 	void draw(VkCommandBuffer commandBuffer);
 
+	// Box around every vertex in model space
+	const MyAabb& boundingBox() const { return m_myBoundingBox; }
+
 private:
 
 	void _createVertexBuffer(const std::vector<Vertex>& vertices);
@@ -42,6 +47,7 @@ private:
 	VkBuffer       m_vkVertexBuffer;       // handle of the buffer on GPU side
 	VkDeviceMemory m_vkVertexBufferMemory; // memory on GPU side of the buffer
 	uint32_t       m_iVertexCount;
+	MyAabb         m_myBoundingBox;
 };
 
 #endif
@@ -0,0 +1,409 @@
+#include "my_scene_graph_benchmark.h"
+
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <limits>
+#include <string>
+#include <thread>
+
+std::shared_ptr<MySceneGraphNode> MySceneGraphBenchmark::_generateTree(uint32_t nodeCount, std::mt19937& rng)
+{
+	std::uniform_int_distribution<uint32_t> childCount{ 1, 8 };
+	std::uniform_real_distribution<float>   offset{ -1.0f, 1.0f };
+	std::uniform_real_distribution<float>   angle{ 0.0f, glm::two_pi<float>() };
+
+	auto root = std::make_shared<MySceneGraphNode>("Node0");
+
+	// Every node gets at least one child, so the queue never runs empty
+	std::deque<MySceneGraphNode*> open{ root.get() };
+	uint32_t created = 1;
+	while (created < nodeCount)
+	{
+		MySceneGraphNode* pParent = open.front();
+		open.pop_front();
+
+		uint32_t count = std::min(childCount(rng), nodeCount - created);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			auto child = std::make_shared<MySceneGraphNode>("Node" + std::to_string(created));
+			child->transform.translation = { offset(rng), offset(rng), offset(rng) };
+			child->transform.rotation = { angle(rng), angle(rng), angle(rng) };
+
+			pParent->addChild(child);
+			open.push_back(child.get());
+			created++;
+		}
+	}
+
+	return root;
+}
+
+void MySceneGraphBenchmark::_gatherRecursive(
+	const std::shared_ptr<MySceneGraphNode>& node,
+	glm::mat4 projView,
+	glm::mat4 modelMat,
+	std::vector<glm::mat4>& transforms)
+{
+	if (node->m_vMyChildren.empty())
+	{
+		transforms.push_back(projView * modelMat);
+	}
+	else
+	{
+		for (auto& obj : node->m_vMyChildren)
+		{
+			glm::mat4 newTransform = modelMat * obj->transform.mat4();
+			_gatherRecursive(obj, projView, newTransform, transforms);
+		}
+	}
+}
+
+void MySceneGraphBenchmark::_gatherFlat(MyFlatSceneGraph& sceneGraph, const glm::mat4& projView, std::vector<glm::mat4>& transforms)
+{
+	sceneGraph.updateWorldTransforms();
+
+	for (uint32_t i = 0; i < sceneGraph.size(); i++)
+	{
+		if (sceneGraph.isLeaf(i))
+		{
+			transforms.push_back(projView * sceneGraph.worldMatrix(i));
+		}
+	}
+}
+
+void MySceneGraphBenchmark::_moveNode(MyFlatSceneGraph& sceneGraph, uint32_t index)
+{
+	// Same transform again, the cost is the same and the tree stays equal to the recursive one
+	TransformComponent transform = sceneGraph.localTransform(index);
+
+	sceneGraph.setLocalTransform(index, transform);
+	sceneGraph.updateWorldTransforms();
+}
+
+bool MySceneGraphBenchmark::_checkParallel(MyFlatSceneGraph& sceneGraph, const MyFrustum& frustum, uint32_t cutoff, std::ostream& out)
+{
+	// The serial update never splits the tree, it is the reference
+	sceneGraph.invalidateAll();
+	sceneGraph.updateWorldTransforms();
+
+	std::vector<glm::mat4> serialMatrices(sceneGraph.size());
+	std::vector<MyAabb> serialBounds(sceneGraph.size());
+	for (uint32_t i = 0; i < sceneGraph.size(); i++)
+	{
+		serialMatrices[i] = sceneGraph.worldMatrix(i);
+		serialBounds[i] = sceneGraph.subtreeBounds(i);
+	}
+
+	// The culling of updateAndCull in one pass over the whole tree, without jobs
+	std::vector<uint8_t> serialVisible(sceneGraph.size(), 0);
+	uint32_t insideEnd = 0;
+	for (uint32_t i = 0; i < sceneGraph.size(); )
+	{
+		bool bInside = i < insideEnd;
+		if (!bInside)
+		{
+			MyFrustum::Containment containment = frustum.classify(sceneGraph.subtreeBounds(i));
+			if (containment == MyFrustum::OUTSIDE)
+			{
+				i = sceneGraph.subtreeEnd(i);
+				continue;
+			}
+			if (containment == MyFrustum::INSIDE)
+			{
+				insideEnd = sceneGraph.subtreeEnd(i);
+				bInside = true;
+			}
+		}
+
+		bool bVisible = !sceneGraph.modelBounds(i).empty();
+		if (bVisible && !bInside && !sceneGraph.isLeaf(i))
+		{
+			bVisible = frustum.classify(sceneGraph.modelBounds(i).transformed(sceneGraph.worldMatrix(i))) != MyFrustum::OUTSIDE;
+		}
+		serialVisible[i] = bVisible;
+		i++;
+	}
+
+	MyJobScheduler scheduler{ MyJobScheduler::defaultThreadCount() };
+	MyFlatSceneGraph::DrawLists drawLists;
+	sceneGraph.invalidateAll();
+	sceneGraph.updateAndCull(scheduler, frustum, drawLists, cutoff);
+
+	// Every matrix is the same product in both, and min and max do not round, so the boxes
+	// are equal whatever the order they were merged in. Nothing is compared with a tolerance
+	uint32_t matrixMismatches = 0;
+	uint32_t boundsMismatches = 0;
+	uint32_t visibleMismatches = 0;
+	for (uint32_t i = 0; i < sceneGraph.size(); i++)
+	{
+		const MyAabb& bounds = sceneGraph.subtreeBounds(i);
+		matrixMismatches += sceneGraph.worldMatrix(i) != serialMatrices[i];
+		boundsMismatches += bounds.min != serialBounds[i].min || bounds.max != serialBounds[i].max;
+		visibleMismatches += sceneGraph.visible(i) != (serialVisible[i] != 0);
+	}
+
+	// The draw lists together hold every visible node exactly once
+	std::vector<uint32_t> drawn;
+	for (const auto& drawList : drawLists)
+	{
+		drawn.insert(drawn.end(), drawList.begin(), drawList.end());
+	}
+	std::sort(drawn.begin(), drawn.end());
+
+	std::vector<uint32_t> expected;
+	for (uint32_t i = 0; i < sceneGraph.size(); i++)
+	{
+		if (serialVisible[i])
+		{
+			expected.push_back(i);
+		}
+	}
+
+	out << "Parallel update and cull with job cutoff " << cutoff << " against the serial ones: ";
+	if (matrixMismatches == 0 && boundsMismatches == 0 && visibleMismatches == 0 && drawn == expected)
+	{
+		out << "match" << std::endl;
+		return true;
+	}
+	out << "mismatch, " << matrixMismatches << " world matrices, " << boundsMismatches << " subtree boxes and "
+		<< visibleMismatches << " visibility flags differ, " << drawn.size() << " nodes drawn instead of " << expected.size() << std::endl;
+	return false;
+}
+
+void MySceneGraphBenchmark::_runScaling(uint32_t nodeCount, std::mt19937& rng, const glm::mat4& projView, std::ostream& out)
+{
+	std::shared_ptr<MySceneGraphNode> root = _generateTree(nodeCount, rng);
+
+	// The leaves stand in for the cubes of the demo
+	MyFlatSceneGraph flatSceneGraph;
+	flatSceneGraph.build(*root);
+	for (uint32_t i = 0; i < flatSceneGraph.size(); i++)
+	{
+		if (flatSceneGraph.isLeaf(i))
+		{
+			flatSceneGraph.setModelBounds(i, MyAabb{ glm::vec3{ -0.5f }, glm::vec3{ 0.5f } });
+		}
+	}
+
+	MyFrustum frustum = MyFrustum::fromMatrix(projView);
+
+	// A small cutoff splits off many subtrees, most of them next to other nodes of their parent.
+	// The default one is what the timed runs use
+	_checkParallel(flatSceneGraph, frustum, 16, out);
+	_checkParallel(flatSceneGraph, frustum, MyFlatSceneGraph::DEFAULT_JOB_CUTOFF, out);
+
+	// 1, 2, 4, ... workers and one per core, the calling thread is one of them
+	uint32_t coreCount = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<uint32_t> workerCounts;
+	for (uint32_t workers = 1; workers < coreCount; workers *= 2)
+	{
+		workerCounts.push_back(workers);
+	}
+	workerCounts.push_back(coreCount);
+
+	out << "Parallel update and cull of " << nodeCount << " nodes, best time of several runs (ms)" << std::endl;
+	out << std::right << std::setw(10) << "workers" << std::setw(10) << "time" << std::setw(10) << "speedup"
+		<< std::setw(10) << "visible" << std::endl;
+
+	double singleWorkerMs = 0.0;
+	for (uint32_t workers : workerCounts)
+	{
+		MyJobScheduler scheduler{ workers - 1 };
+		MyFlatSceneGraph::DrawLists drawLists;
+
+		double bestMs = std::numeric_limits<double>::max();
+		for (uint32_t run = 0; run < 5; run++)
+		{
+			flatSceneGraph.invalidateAll();
+
+			auto start = std::chrono::steady_clock::now();
+			flatSceneGraph.updateAndCull(scheduler, frustum, drawLists);
+			bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		if (workers == 1)
+		{
+			singleWorkerMs = bestMs;
+		}
+
+		size_t visibleCount = 0;
+		for (const auto& drawList : drawLists)
+		{
+			visibleCount += drawList.size();
+		}
+
+		out << std::fixed << std::setprecision(3)
+			<< std::setw(10) << workers << std::setw(10) << bestMs
+			<< std::setw(9) << std::setprecision(2) << singleWorkerMs / bestMs << "x"
+			<< std::setw(10) << visibleCount << std::defaultfloat << std::endl;
+	}
+}
+
+void MySceneGraphBenchmark::_runCulling(uint32_t rowCount, std::ostream& out)
+{
+	// The demo scene, a group with two cubes, repeated on a rowCount x rowCount grid
+	// in the XZ plane. Every row of groups is a group too
+	const float spacing = 5.0f;
+	const float halfSize = 0.5f * spacing * rowCount;
+	const MyAabb cubeBounds{ glm::vec3{ -0.5f }, glm::vec3{ 0.5f } };
+
+	MyFlatSceneGraph flatSceneGraph;
+	uint32_t root = flatSceneGraph.addNode(MyFlatSceneGraph::NO_PARENT, TransformComponent{}, nullptr, glm::vec3{ 0.0f }, MyAabb{});
+	for (uint32_t row = 0; row < rowCount; row++)
+	{
+		TransformComponent rowTransform{};
+		rowTransform.translation.z = row * spacing - halfSize;
+		uint32_t rowGroup = flatSceneGraph.addNode(root, rowTransform, nullptr, glm::vec3{ 0.0f }, MyAabb{});
+
+		for (uint32_t column = 0; column < rowCount; column++)
+		{
+			TransformComponent groupTransform{};
+			groupTransform.translation.x = column * spacing - halfSize;
+			uint32_t group = flatSceneGraph.addNode(rowGroup, groupTransform, nullptr, glm::vec3{ 0.0f }, MyAabb{});
+
+			TransformComponent cubeTransform{};
+			cubeTransform.translation.x = -1.0f;
+			flatSceneGraph.addNode(group, cubeTransform, nullptr, glm::vec3{ 0.0f }, cubeBounds);
+			cubeTransform.translation.x = 1.0f;
+			flatSceneGraph.addNode(group, cubeTransform, nullptr, glm::vec3{ 0.0f }, cubeBounds);
+		}
+	}
+	flatSceneGraph.updateWorldTransforms();
+
+	// Standing just outside the grid, once looking over it and once away from it
+	glm::mat4 projection = glm::perspective(glm::radians(50.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+	glm::vec3 eye{ 0.0f, 2.0f, halfSize + 5.0f };
+	glm::mat4 towards = projection * glm::lookAt(eye, eye + glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+	glm::mat4 away = projection * glm::lookAt(eye, eye + glm::vec3{ 0.0f, 0.0f, 1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+
+	// Boxes completely inside the frustum skip the tests below them, which the random tree rarely has
+	_checkParallel(flatSceneGraph, MyFrustum::fromMatrix(towards), 16, out);
+
+	MyJobScheduler scheduler{ MyJobScheduler::defaultThreadCount() };
+	MyFlatSceneGraph::DrawLists drawLists;
+
+	out << "Culling of " << rowCount * rowCount << " groups (" << flatSceneGraph.size() << " nodes), best time of several runs (ms)" << std::endl;
+	out << std::right << std::setw(10) << "camera" << std::setw(10) << "time" << std::setw(10) << "tested"
+		<< std::setw(10) << "visible" << std::endl;
+
+	for (int direction = 0; direction < 2; direction++)
+	{
+		MyFrustum frustum = MyFrustum::fromMatrix(direction == 0 ? towards : away);
+
+		double bestMs = std::numeric_limits<double>::max();
+		uint32_t testCount = 0;
+		for (uint32_t run = 0; run < 10; run++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			testCount = flatSceneGraph.updateAndCull(scheduler, frustum, drawLists);
+			bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		size_t visibleCount = 0;
+		for (const auto& drawList : drawLists)
+		{
+			visibleCount += drawList.size();
+		}
+
+		out << std::fixed << std::setprecision(3)
+			<< std::setw(10) << (direction == 0 ? "towards" : "away") << std::setw(10) << bestMs
+			<< std::setw(10) << testCount << std::setw(10) << visibleCount << std::defaultfloat << std::endl;
+	}
+}
+
+void MySceneGraphBenchmark::run(const std::vector<uint32_t>& nodeCounts, std::ostream& out)
+{
+	std::mt19937 rng{ 1234 };
+
+	glm::mat4 projView = glm::perspective(glm::radians(50.0f), 4.0f / 3.0f, 0.1f, 100.0f) *
+		glm::lookAt(glm::vec3{ 0.0f, 0.0f, 10.0f }, glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+
+	auto elapsedMs = [](std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	out << "Scene graph transforms, best time of several runs (ms)" << std::endl;
+	out << std::right << std::setw(10) << "nodes" << std::setw(10) << "leaves" << std::setw(10) << "flatten"
+		<< std::setw(12) << "recursive" << std::setw(10) << "flat" << std::setw(10) << "speedup"
+		<< std::setw(10) << "1 moved" << std::endl;
+
+	for (uint32_t nodeCount : nodeCounts)
+	{
+		std::shared_ptr<MySceneGraphNode> root = _generateTree(nodeCount, rng);
+
+		auto start = std::chrono::steady_clock::now();
+		MyFlatSceneGraph flatSceneGraph;
+		flatSceneGraph.build(*root);
+		double flattenMs = elapsedMs(start);
+
+		// Enough runs for a stable minimum on the small trees without
+		// making the large ones take minutes
+		uint32_t runs = std::max(3u, std::min(100u, 10000000u / nodeCount));
+
+		std::vector<glm::mat4> recursiveTransforms;
+		std::vector<glm::mat4> flatTransforms;
+		recursiveTransforms.reserve(nodeCount);
+		flatTransforms.reserve(nodeCount);
+
+		// A node in the middle of the order, usually near the leaves like the cubes of the demo
+		uint32_t movedNode = nodeCount / 2;
+
+		double recursiveMs = std::numeric_limits<double>::max();
+		double flatMs = std::numeric_limits<double>::max();
+		double movedMs = std::numeric_limits<double>::max();
+		for (uint32_t run = 0; run < runs; run++)
+		{
+			recursiveTransforms.clear();
+			start = std::chrono::steady_clock::now();
+			_gatherRecursive(root, projView, root->transform.mat4(), recursiveTransforms);
+			recursiveMs = std::min(recursiveMs, elapsedMs(start));
+
+			// The cached matrices would otherwise make every run after the first free
+			flatTransforms.clear();
+			flatSceneGraph.invalidateAll();
+			start = std::chrono::steady_clock::now();
+			_gatherFlat(flatSceneGraph, projView, flatTransforms);
+			flatMs = std::min(flatMs, elapsedMs(start));
+
+			start = std::chrono::steady_clock::now();
+			_moveNode(flatSceneGraph, movedNode);
+			movedMs = std::min(movedMs, elapsedMs(start));
+		}
+
+		// Both walk the leaves in pre-order, so the results line up one to one
+		float maxDifference = 0.0f;
+		for (size_t i = 0; i < std::min(recursiveTransforms.size(), flatTransforms.size()); i++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				glm::vec4 difference = glm::abs(recursiveTransforms[i][column] - flatTransforms[i][column]);
+				maxDifference = std::max({ maxDifference, difference.x, difference.y, difference.z, difference.w });
+			}
+		}
+
+		out << std::fixed << std::setprecision(3)
+			<< std::setw(10) << nodeCount << std::setw(10) << flatTransforms.size() << std::setw(10) << flattenMs
+			<< std::setw(12) << recursiveMs << std::setw(10) << flatMs
+			<< std::setw(9) << std::setprecision(2) << recursiveMs / flatMs << "x"
+			<< std::setw(10) << std::setprecision(3) << movedMs << std::defaultfloat;
+
+		if (recursiveTransforms.size() != flatTransforms.size() || maxDifference > 1e-3f)
+		{
+			out << "  mismatch, max difference " << maxDifference;
+		}
+		out << std::endl;
+	}
+
+	if (!nodeCounts.empty())
+	{
+		_runScaling(*std::max_element(nodeCounts.begin(), nodeCounts.end()), rng, projView, out);
+	}
+
+	_runCulling(100, out);
+}
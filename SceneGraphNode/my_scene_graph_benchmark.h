@@ -0,0 +1,46 @@
+#ifndef __MY_SCENE_GRAPH_BENCHMARK_H__
+#define __MY_SCENE_GRAPH_BENCHMARK_H__
+
+#include "my_game_object.h"
+#include "my_flat_scene_graph.h"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <vector>
+
+//
+// Times the recursive walk over MySceneGraphNode that rendering used before against the linear pass
+// of MyFlatSceneGraph on generated trees. Both compute the world matrices and the push transform
+// of every leaf, the flat graph once with every node changed and once with a single node changed.
+// The flat graph also refits the boxes of its nodes, which the recursive walk does not have.
+// The parallel update and cull of the flat graph is then timed with 1 worker up to one per core,
+// and the culling of a large version of the demo scene with the camera towards and away from it.
+// Before it is timed, the parallel update and cull is checked against serial ones with small and
+// default job cutoffs, so subtrees are split off into jobs. Only the CPU side is measured so no device is needed
+//
+class MySceneGraphBenchmark
+{
+public:
+	static void run(const std::vector<uint32_t>& nodeCounts, std::ostream& out);
+
+private:
+	// Breadth first with 1 to 8 children per node and random local transforms
+	static std::shared_ptr<MySceneGraphNode> _generateTree(uint32_t nodeCount, std::mt19937& rng);
+
+	// The former recursive render walk, vkCmdPushConstants replaced by a push_back
+	static void _gatherRecursive(const std::shared_ptr<MySceneGraphNode>& node, glm::mat4 projView, glm::mat4 modelMat, std::vector<glm::mat4>& transforms);
+	static void _gatherFlat(MyFlatSceneGraph& sceneGraph, const glm::mat4& projView, std::vector<glm::mat4>& transforms);
+	static void _moveNode(MyFlatSceneGraph& sceneGraph, uint32_t index);
+
+	// Compares the world matrices, subtree boxes and visible nodes of updateAndCull with the given
+	// job cutoff against the serial update and a serial cull, prints the differences and returns
+	// true if there are none
+	static bool _checkParallel(MyFlatSceneGraph& sceneGraph, const MyFrustum& frustum, uint32_t cutoff, std::ostream& out);
+	static void _runScaling(uint32_t nodeCount, std::mt19937& rng, const glm::mat4& projView, std::ostream& out);
+	static void _runCulling(uint32_t rowCount, std::ostream& out);
+};
+
+#endif
@@ -102,48 +102,40 @@ void MySimpleRenderSystem::_createPipeline(VkRenderPass renderPass)
 
 void MySimpleRenderSystem::renderSceneGraph(
     VkCommandBuffer commandBuffer,
-    std::shared_ptr<MySceneGraphNode>& sceneGraph,
+    const MyFlatSceneGraph& sceneGraph,
+    const MyFlatSceneGraph::DrawLists& drawLists,
     const MyCamera& camera)
 {
     m_pMyPipeline->bind(commandBuffer);
-    
-    // TODO: Render the scene graph recursively
-    auto projView = camera.projectionMatrix() * camera.viewMatrix(); 
-    glm::mat4 modelMat = sceneGraph->transform.mat4(); 
 
-    _renderSceneGraph(commandBuffer, sceneGraph, projView, modelMat);
-}
+    auto projView = camera.projectionMatrix() * camera.viewMatrix();
 
-void MySimpleRenderSystem::_renderSceneGraph(VkCommandBuffer commandBuffer, std::shared_ptr<MySceneGraphNode>& node, glm::mat4 projView, glm::mat4 modelMat)
-{
-    if (node->model != nullptr)
+    // The order of the lists depends on which worker got which subtree, the depth test makes it not matter
+    for (const auto& drawList : drawLists)
     {
-        MySimplePushConstantData push{}; 
-
-        push.push_color = node->color; 
-
-        push.transform = projView * modelMat; //node->transform.mat4();
-
-        vkCmdPushConstants(
-            commandBuffer,
-            m_vkPipelineLayout,
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-            0,
-            sizeof(MySimplePushConstantData),
-            &push);
-
-        node->model->bind(commandBuffer);
-        node->model->draw(commandBuffer);
-    }
-    else
-    {
-        //For non-leaf nodes
-        for (auto& obj: node->m_vMyChildren)
+        for (uint32_t i : drawList)
         {
-            glm::mat4 newTransform = modelMat * obj->transform.mat4();
-            _renderSceneGraph(commandBuffer, obj, projView, newTransform); 
+            MyModel* pModel = sceneGraph.model(i);
+            if (pModel == nullptr)
+            {
+                continue;
+            }
+
+            MySimplePushConstantData push{};
+
+            push.push_color = sceneGraph.color(i);
+            push.transform = projView * sceneGraph.worldMatrix(i);
+
+            vkCmdPushConstants(
+                commandBuffer,
+                m_vkPipelineLayout,
+                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                0,
+                sizeof(MySimplePushConstantData),
+                &push);
+
+            pModel->bind(commandBuffer);
+            pModel->draw(commandBuffer);
         }
     }
 }
-
-
@@ -3,6 +3,7 @@
 
 #include "my_device.h"
 #include "my_game_object.h"
+#include "my_flat_scene_graph.h"
 #include "my_pipeline.h"
 #include "my_camera.h"
 
@@ -21,12 +22,13 @@ public:
 	MySimpleRenderSystem& operator=(const MySimpleRenderSystem&) = delete;
 
 	//void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<MyGameObject>& gameObjects, const MyCamera &camera);
-	void renderSceneGraph(VkCommandBuffer commandBuffer, std::shared_ptr<MySceneGraphNode>& sceneGraph, const MyCamera& camera);
+
+	// Draws the nodes of the draw lists filled by MyFlatSceneGraph::updateAndCull, one list after the other
+	void renderSceneGraph(VkCommandBuffer commandBuffer, const MyFlatSceneGraph& sceneGraph, const MyFlatSceneGraph::DrawLists& drawLists, const MyCamera& camera);
 
 private:
 	void _createPipelineLayout();
 	void _createPipeline(VkRenderPass renderPass);
-	void _renderSceneGraph(VkCommandBuffer commandBuffer, std::shared_ptr<MySceneGraphNode>& node, glm::mat4 projView, glm::mat4 modelMat);
 
 	MyDevice&                   m_myDevice;
 
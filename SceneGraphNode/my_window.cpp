@@ -2,21 +2,37 @@
 #include "my_application.h"
 #include <stdexcept>
 
-MyWindow::MyWindow(int w, int h, std::string name) : 
+MyWindow::MyWindow(int w, int h, std::string name, bool bHeadless) : 
 	m_iWidth(w),
 	m_iHeight(h),
+	m_bframeBufferResize(false),
+	m_bHeadless(bHeadless),
 	m_sWindowName(name),
 	m_pWindow(nullptr),
-	m_bframeBufferResize(false),
 	m_pMyApplication(nullptr)
 {
-	_initWindow();
+	// No display is needed to render offscreen
+	if (!m_bHeadless)
+	{
+		_initWindow();
+	}
 }
 
 MyWindow::~MyWindow()
 {
-	glfwDestroyWindow(m_pWindow);
-	glfwTerminate();
+	if (!m_bHeadless)
+	{
+		glfwDestroyWindow(m_pWindow);
+		glfwTerminate();
+	}
+}
+
+void MyWindow::requestClose()
+{
+	if (m_bHeadless)
+		m_bCloseRequested = true;
+	else
+		glfwSetWindowShouldClose(m_pWindow, 1);
 }
 
 void MyWindow::_initWindow()
@@ -42,10 +58,18 @@ void MyWindow::_initWindow()
 	
 	// Register keyboard callback	
 	glfwSetKeyCallback(m_pWindow, s_keyboardCallback);
+
+	// Redraw when the content of the window is damaged, e.g. uncovered by another window
+	glfwSetWindowRefreshCallback(m_pWindow, s_windowRefreshCallback);
 }
 
 void MyWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
 {
+	if (m_bHeadless)
+	{
+		throw std::runtime_error("Headless window has no surface");
+	}
+
 	if (glfwCreateWindowSurface(instance, m_pWindow, nullptr, surface) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create window");
@@ -58,14 +82,22 @@ void MyWindow::s_frameBufferResizeCallback(GLFWwindow* window, int width, int he
 	mywindow->m_bframeBufferResize = true;
 	mywindow->m_iWidth = width;
 	mywindow->m_iHeight = height;
+	mywindow->invalidate();
+}
+
+void MyWindow::s_windowRefreshCallback(GLFWwindow* window)
+{
+	auto mywindow = reinterpret_cast<MyWindow*>(glfwGetWindowUserPointer(window));
+	mywindow->invalidate();
 }
 
 void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     // Handle keyboard events
 	auto mywindow = reinterpret_cast<MyWindow*>(glfwGetWindowUserPointer(window));
+	mywindow->invalidate();
 
-	if ((key == GLFW_KEY_SPACE || key == GLFW_KEY_P || key == GLFW_KEY_C || key == GLFW_KEY_N || GLFW_KEY_ESCAPE)
+	if ((key == GLFW_KEY_SPACE || key == GLFW_KEY_P || key == GLFW_KEY_C || key == GLFW_KEY_N || key == GLFW_KEY_B || key == GLFW_KEY_ESCAPE)
 		&& action == GLFW_PRESS)
 	{
 		mywindow->keyboardEvent(key);
@@ -74,8 +106,23 @@ void MyWindow::s_keyboardCallback(GLFWwindow* window, int key, int scancode, int
 
 void MyWindow::pollEvents()
 {
+	if (m_bHeadless) return;
+
 	glfwPollEvents();
+	_pollHeldKeys();
+}
 
+void MyWindow::waitEventsTimeout(double seconds)
+{
+	if (m_bHeadless) return;
+
+	glfwWaitEventsTimeout(seconds);
+	_pollHeldKeys();
+}
+
+void MyWindow::_pollHeldKeys()
+{
+	// The current node keeps moving for as long as the key is held
 	if (glfwGetKey(m_pWindow, GLFW_KEY_LEFT) == GLFW_PRESS)       m_pMyApplication->handleMovementOfCurrentNode(MyApplication::KEY_LEFT);
 	else if (glfwGetKey(m_pWindow, GLFW_KEY_RIGHT) == GLFW_PRESS) m_pMyApplication->handleMovementOfCurrentNode(MyApplication::KEY_RIGHT);
 	else if (glfwGetKey(m_pWindow, GLFW_KEY_UP) == GLFW_PRESS)    m_pMyApplication->handleMovementOfCurrentNode(MyApplication::KEY_UP);
@@ -115,5 +162,9 @@ void MyWindow::keyboardEvent(int key)
 	{
 		m_pMyApplication->traverseNext();
 	}
+	else if (key == GLFW_KEY_B)
+	{
+		m_pMyApplication->traversePrevious();
+	}
 }
 